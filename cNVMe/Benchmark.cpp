@@ -0,0 +1,333 @@
+/*
+###########################################################################################
+// cNVMe - An Open Source NVMe Device Simulation - MIT License
+// Copyright 2018 - Intel Corporation
+
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+// INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+// PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+// LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT
+// OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+// OTHER DEALINGS IN THE SOFTWARE.
+############################################################################################
+Benchmark.cpp - An implementation file for the built-in benchmark harness
+*/
+
+#include "Benchmark.h"
+#include "Constants.h"
+#include "Driver.h"
+#include "Identify.h"
+#include "Logger.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <thread>
+
+namespace cnvme
+{
+	namespace benchmark
+	{
+		/// <summary>
+		/// One in-flight command slot owned by a worker
+		/// </summary>
+		typedef struct WORKER_SLOT
+		{
+			Payload CommandBuffer;								// DRIVER_COMMAND plus the transfer data
+			std::chrono::steady_clock::time_point SubmitTime;	// When the command in this slot was submitted
+		} WORKER_SLOT;
+
+		/// <summary>
+		/// Per-thread workload state. Each worker keeps QueueDepth commands in flight on its queue pair.
+		/// </summary>
+		typedef struct WORKER_CONTEXT
+		{
+			UINT_16 QueueId;						// The IO queue pair this worker drives
+			std::vector<WORKER_SLOT> Slots;			// One slot per in-flight command
+			std::vector<size_t> FreeSlots;			// Slot indexes not currently in flight (guarded by Mutex)
+			std::vector<UINT_64> LatenciesMicroseconds;	// Latency of every completed command (guarded by Mutex)
+			UINT_64 CommandsCompleted;				// Successful completions (guarded by Mutex)
+			UINT_64 CommandsFailed;					// Failed completions (guarded by Mutex)
+			std::mutex Mutex;						// Completion callbacks can fire on any reaping thread
+			UINT_64 RandomState;					// xorshift64* state for read/write mix and LBA picks
+		} WORKER_CONTEXT;
+
+		/// <summary>
+		/// xorshift64* step. Fast and plenty random for picking LBAs.
+		/// </summary>
+		static UINT_64 nextRandom(UINT_64& state)
+		{
+			state ^= state >> 12;
+			state ^= state << 25;
+			state ^= state >> 27;
+			return state * 0x2545F4914F6CDD1DULL;
+		}
+
+		/// <summary>
+		/// Pulls the given percentile out of an already sorted latency list
+		/// </summary>
+		static UINT_64 percentile(const std::vector<UINT_64>& sortedLatencies, double percent)
+		{
+			if (sortedLatencies.empty())
+			{
+				return 0;
+			}
+			size_t index = (size_t)std::ceil((percent / 100.0) * sortedLatencies.size());
+			index = std::min(index, sortedLatencies.size());
+			index = std::max(index, (size_t)1);
+			return sortedLatencies[index - 1];
+		}
+
+		bool runBenchmark(const BENCHMARK_CONFIG& config, BENCHMARK_RESULTS& results)
+		{
+			BENCHMARK_CONFIG cfg = config;
+			cfg.QueuePairCount = std::max(cfg.QueuePairCount, (UINT_32)1);
+			cfg.QueueDepth = std::max(cfg.QueueDepth, (UINT_32)1);
+			cfg.WorkerThreadCount = std::max(cfg.WorkerThreadCount, (UINT_32)1);
+			cfg.DurationInSeconds = std::max(cfg.DurationInSeconds, (UINT_32)1);
+			cfg.ReadPercent = std::min(cfg.ReadPercent, (UINT_32)100);
+
+			results = BENCHMARK_RESULTS();
+
+			cnvme::driver::Driver driver;
+			driver.setIoQueueWorkersEnabled(true); // give the device side a worker per IO queue
+
+			UINT_32 setupBufferSize = sizeof(cnvme::driver::DRIVER_COMMAND) + sizeof(identify::structures::IDENTIFY_NAMESPACE);
+			Payload setupBuffer(setupBufferSize);
+			auto pSetupCommand = (cnvme::driver::PDRIVER_COMMAND)setupBuffer.getBuffer();
+
+			// Ask the namespace how big it is and how big its sectors are
+			pSetupCommand->QueueId = ADMIN_QUEUE_ID;
+			pSetupCommand->Timeout = 5;
+			pSetupCommand->TransferDataDirection = cnvme::driver::READ;
+			pSetupCommand->TransferDataSize = sizeof(identify::structures::IDENTIFY_NAMESPACE);
+			pSetupCommand->Command.DWord0Breakdown.OPC = constants::opcodes::admin::IDENTIFY;
+			pSetupCommand->Command.DW10_Identify.CNS = constants::commands::identify::cns::NAMESPACE_ACTIVE;
+			pSetupCommand->Command.NSID = 1;
+			driver.sendCommand(setupBuffer.getBuffer(), setupBuffer.getSize());
+			if (!pSetupCommand->CompletionQueueEntry.succeeded())
+			{
+				LOG_ERROR("Benchmark setup failed: couldn't identify namespace 1");
+				return false;
+			}
+
+			auto pIdentifyNamespace = (identify::structures::PIDENTIFY_NAMESPACE)pSetupCommand->TransferData;
+			UINT_32 sectorSize = (UINT_32)std::pow(2, pIdentifyNamespace->LBAF[pIdentifyNamespace->FLBAS.CurrentLBAFormat].LBADS);
+			UINT_64 namespaceSectorCount = pIdentifyNamespace->NSZE;
+
+			cfg.BlockSizeInBytes = std::max(cfg.BlockSizeInBytes, sectorSize);
+			cfg.BlockSizeInBytes -= (cfg.BlockSizeInBytes % sectorSize); // whole sectors only
+			UINT_32 sectorsPerCommand = cfg.BlockSizeInBytes / sectorSize;
+			if (sectorsPerCommand > namespaceSectorCount)
+			{
+				LOG_ERROR("Benchmark setup failed: block size is larger than the namespace");
+				return false;
+			}
+			UINT_64 maxStartingSector = namespaceSectorCount - sectorsPerCommand;
+
+			// Create the queue pairs, sized for every worker sharing them to stay at full depth
+			for (UINT_32 queueId = 1; queueId <= cfg.QueuePairCount; queueId++)
+			{
+				UINT_32 workersOnThisPair = (cfg.WorkerThreadCount / cfg.QueuePairCount) + ((queueId - 1) < (cfg.WorkerThreadCount % cfg.QueuePairCount) ? 1 : 0);
+				UINT_32 queueEntries = std::min((workersOnThisPair * cfg.QueueDepth) + 1, (UINT_32)0x10000);
+
+				memset(&pSetupCommand->Command, 0, sizeof(pSetupCommand->Command));
+				pSetupCommand->QueueId = ADMIN_QUEUE_ID;
+				pSetupCommand->TransferDataDirection = cnvme::driver::NO_DATA;
+				pSetupCommand->TransferDataSize = 0;
+				pSetupCommand->Command.DWord0Breakdown.OPC = constants::opcodes::admin::CREATE_IO_COMPLETION_QUEUE;
+				pSetupCommand->Command.DW10_CreateIoQueue.QSIZE = queueEntries - 1; // 0-based
+				pSetupCommand->Command.DW10_CreateIoQueue.QID = queueId;
+				pSetupCommand->Command.DW11_CreateIoCompletionQueue.IEN = 1;
+				pSetupCommand->Command.DW11_CreateIoCompletionQueue.PC = 1;
+				driver.sendCommand(setupBuffer.getBuffer(), setupBuffer.getSize());
+				if (!pSetupCommand->CompletionQueueEntry.succeeded())
+				{
+					LOG_ERROR("Benchmark setup failed: couldn't create completion queue " + std::to_string(queueId));
+					return false;
+				}
+
+				memset(&pSetupCommand->Command, 0, sizeof(pSetupCommand->Command));
+				pSetupCommand->Command.DWord0Breakdown.OPC = constants::opcodes::admin::CREATE_IO_SUBMISSION_QUEUE;
+				pSetupCommand->Command.DW10_CreateIoQueue.QSIZE = queueEntries - 1;
+				pSetupCommand->Command.DW10_CreateIoQueue.QID = queueId;
+				pSetupCommand->Command.DW11_CreateIoSubmissionQueue.PC = 1;
+				pSetupCommand->Command.DW11_CreateIoSubmissionQueue.CQID = queueId;
+				driver.sendCommand(setupBuffer.getBuffer(), setupBuffer.getSize());
+				if (!pSetupCommand->CompletionQueueEntry.succeeded())
+				{
+					LOG_ERROR("Benchmark setup failed: couldn't create submission queue " + std::to_string(queueId));
+					return false;
+				}
+			}
+
+			// Set up the workers. Workers share queue pairs round robin.
+			std::vector<std::unique_ptr<WORKER_CONTEXT>> workers;
+			UINT_32 commandBufferSize = sizeof(cnvme::driver::DRIVER_COMMAND) + cfg.BlockSizeInBytes;
+			for (UINT_32 workerIndex = 0; workerIndex < cfg.WorkerThreadCount; workerIndex++)
+			{
+				std::unique_ptr<WORKER_CONTEXT> worker(new WORKER_CONTEXT());
+				worker->QueueId = (UINT_16)((workerIndex % cfg.QueuePairCount) + 1);
+				worker->Slots.resize(cfg.QueueDepth);
+				for (size_t slotIndex = 0; slotIndex < worker->Slots.size(); slotIndex++)
+				{
+					worker->Slots[slotIndex].CommandBuffer = Payload(commandBufferSize);
+					worker->FreeSlots.push_back(slotIndex);
+				}
+				worker->CommandsCompleted = 0;
+				worker->CommandsFailed = 0;
+				worker->RandomState = (0x9E3779B97F4A7C15ULL * (workerIndex + 1)) | 1;
+				workers.push_back(std::move(worker));
+			}
+
+			auto startTime = std::chrono::steady_clock::now();
+			auto deadline = startTime + std::chrono::seconds(cfg.DurationInSeconds);
+
+			auto workerLoop = [&](WORKER_CONTEXT* worker)
+			{
+				while (std::chrono::steady_clock::now() < deadline)
+				{
+					// Refill the queue: submit a command for every free slot
+					for (;;)
+					{
+						size_t slotIndex;
+						{
+							std::lock_guard<std::mutex> workerLock(worker->Mutex);
+							if (worker->FreeSlots.empty())
+							{
+								break;
+							}
+							slotIndex = worker->FreeSlots.back();
+							worker->FreeSlots.pop_back();
+						}
+
+						WORKER_SLOT& slot = worker->Slots[slotIndex];
+						auto pDriverCommand = (cnvme::driver::PDRIVER_COMMAND)slot.CommandBuffer.getBuffer();
+						bool isRead = (nextRandom(worker->RandomState) % 100) < cfg.ReadPercent;
+
+						memset(&pDriverCommand->Command, 0, sizeof(pDriverCommand->Command));
+						pDriverCommand->QueueId = worker->QueueId;
+						pDriverCommand->Timeout = 5;
+						pDriverCommand->TransferDataSize = cfg.BlockSizeInBytes;
+						pDriverCommand->TransferDataDirection = isRead ? cnvme::driver::READ : cnvme::driver::WRITE;
+						pDriverCommand->Command.DWord0Breakdown.OPC = isRead ? constants::opcodes::nvm::READ : constants::opcodes::nvm::WRITE;
+						pDriverCommand->Command.NSID = 1;
+						pDriverCommand->Command.SLBA = (maxStartingSector == 0) ? 0 : (nextRandom(worker->RandomState) % (maxStartingSector + 1));
+						pDriverCommand->Command.DW12_IO.NLB = ZERO_BASED_FROM_ONE_BASED(sectorsPerCommand);
+
+						slot.SubmitTime = std::chrono::steady_clock::now();
+						auto handle = driver.submitCommand(slot.CommandBuffer.getBuffer(), slot.CommandBuffer.getSize(),
+							[worker, slotIndex](cnvme::driver::PDRIVER_COMMAND pCompletedCommand)
+						{
+							UINT_64 latencyMicroseconds = std::chrono::duration_cast<std::chrono::microseconds>(
+								std::chrono::steady_clock::now() - worker->Slots[slotIndex].SubmitTime).count();
+
+							std::lock_guard<std::mutex> workerLock(worker->Mutex);
+							worker->LatenciesMicroseconds.push_back(latencyMicroseconds);
+							if (pCompletedCommand->CompletionQueueEntry.succeeded())
+							{
+								worker->CommandsCompleted++;
+							}
+							else
+							{
+								worker->CommandsFailed++;
+							}
+							worker->FreeSlots.push_back(slotIndex);
+						});
+
+						if (handle == INVALID_COMMAND_HANDLE)
+						{
+							// Couldn't submit (shouldn't happen): put the slot back and count the failure
+							std::lock_guard<std::mutex> workerLock(worker->Mutex);
+							worker->CommandsFailed++;
+							worker->FreeSlots.push_back(slotIndex);
+							break;
+						}
+					}
+
+					// Reap whatever has finished. Completions for other workers fire their callbacks too.
+					driver.reapCompletions(cfg.QueueDepth, 1);
+				}
+
+				// Time's up: drain this worker's remaining in-flight commands
+				auto drainDeadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+				for (;;)
+				{
+					{
+						std::lock_guard<std::mutex> workerLock(worker->Mutex);
+						if (worker->FreeSlots.size() == worker->Slots.size())
+						{
+							break;
+						}
+					}
+					if (std::chrono::steady_clock::now() > drainDeadline)
+					{
+						LOG_ERROR("Benchmark drain timed out with commands still in flight");
+						break;
+					}
+					driver.reapCompletions(cfg.QueueDepth, 1);
+				}
+			};
+
+			std::vector<std::thread> workerThreads;
+			for (auto& worker : workers)
+			{
+				workerThreads.emplace_back(workerLoop, worker.get());
+			}
+			for (auto& workerThread : workerThreads)
+			{
+				workerThread.join();
+			}
+
+			results.ElapsedSeconds = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - startTime).count() / 1000.0;
+
+			// Merge what the workers measured
+			std::vector<UINT_64> allLatencies;
+			for (auto& worker : workers)
+			{
+				results.CommandsCompleted += worker->CommandsCompleted;
+				results.CommandsFailed += worker->CommandsFailed;
+				allLatencies.insert(allLatencies.end(), worker->LatenciesMicroseconds.begin(), worker->LatenciesMicroseconds.end());
+			}
+			results.BytesTransferred = results.CommandsCompleted * cfg.BlockSizeInBytes;
+
+			std::sort(allLatencies.begin(), allLatencies.end());
+			results.P50LatencyMicroseconds = percentile(allLatencies, 50);
+			results.P99LatencyMicroseconds = percentile(allLatencies, 99);
+			results.P999LatencyMicroseconds = percentile(allLatencies, 99.9);
+			results.MaxLatencyMicroseconds = allLatencies.empty() ? 0 : allLatencies.back();
+
+			if (results.ElapsedSeconds > 0)
+			{
+				results.IOPS = results.CommandsCompleted / results.ElapsedSeconds;
+				results.BandwidthMBps = (results.BytesTransferred / 1000000.0) / results.ElapsedSeconds;
+			}
+
+			return results.CommandsFailed == 0;
+		}
+
+		void printReport(const BENCHMARK_CONFIG& config, const BENCHMARK_RESULTS& results)
+		{
+			printf("cNVMe benchmark: %u queue pair(s), depth %u, %u byte blocks, %u%% reads, %u worker(s), %us\n",
+				config.QueuePairCount, config.QueueDepth, config.BlockSizeInBytes, config.ReadPercent,
+				config.WorkerThreadCount, config.DurationInSeconds);
+			printf("  completed: %llu commands (%llu failed) in %.2fs\n",
+				(unsigned long long)results.CommandsCompleted, (unsigned long long)results.CommandsFailed, results.ElapsedSeconds);
+			printf("  IOPS:      %.1f\n", results.IOPS);
+			printf("  bandwidth: %.2f MB/s\n", results.BandwidthMBps);
+			printf("  latency:   p50=%lluus p99=%lluus p999=%lluus max=%lluus\n",
+				(unsigned long long)results.P50LatencyMicroseconds, (unsigned long long)results.P99LatencyMicroseconds,
+				(unsigned long long)results.P999LatencyMicroseconds, (unsigned long long)results.MaxLatencyMicroseconds);
+		}
+	}
+}
@@ -0,0 +1,95 @@
+/*
+###########################################################################################
+// cNVMe - An Open Source NVMe Device Simulation - MIT License
+// Copyright 2018 - Intel Corporation
+
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+// INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+// PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+// LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT
+// OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+// OTHER DEALINGS IN THE SOFTWARE.
+############################################################################################
+Benchmark.h - A header file for the built-in benchmark harness
+*/
+
+#pragma once
+
+#include "Types.h"
+
+namespace cnvme
+{
+	namespace benchmark
+	{
+		/// <summary>
+		/// Knobs for a benchmark run. The defaults give a quick mixed workload.
+		/// </summary>
+		typedef struct BENCHMARK_CONFIG
+		{
+			UINT_32 QueuePairCount;			// Number of IO submission/completion queue pairs to create
+			UINT_32 QueueDepth;				// Commands each worker keeps in flight on its queue pair
+			UINT_32 BlockSizeInBytes;		// Transfer size per command (multiple of the sector size)
+			UINT_32 ReadPercent;			// 0-100. 100 is all reads, 0 is all writes
+			UINT_32 WorkerThreadCount;		// Host-side threads driving IO. Workers share queue pairs round robin
+			UINT_32 DurationInSeconds;		// How long to run the measured phase
+
+			BENCHMARK_CONFIG()
+			{
+				QueuePairCount = 2;
+				QueueDepth = 16;
+				BlockSizeInBytes = 4096;
+				ReadPercent = 70;
+				WorkerThreadCount = 2;
+				DurationInSeconds = 5;
+			}
+		} BENCHMARK_CONFIG, *PBENCHMARK_CONFIG;
+
+		/// <summary>
+		/// What a benchmark run measured.
+		/// </summary>
+		typedef struct BENCHMARK_RESULTS
+		{
+			UINT_64 CommandsCompleted;			// Total commands that completed successfully
+			UINT_64 CommandsFailed;				// Total commands that completed with a non-success status
+			UINT_64 BytesTransferred;			// Total bytes moved (reads plus writes)
+			double ElapsedSeconds;				// Measured wall time
+			double IOPS;						// CommandsCompleted / ElapsedSeconds
+			double BandwidthMBps;				// BytesTransferred / ElapsedSeconds, in 1000^2 bytes
+			UINT_64 P50LatencyMicroseconds;		// Median command latency
+			UINT_64 P99LatencyMicroseconds;		// 99th percentile command latency
+			UINT_64 P999LatencyMicroseconds;	// 99.9th percentile command latency
+			UINT_64 MaxLatencyMicroseconds;		// Worst command latency seen
+
+			BENCHMARK_RESULTS()
+			{
+				memset(this, 0, sizeof(*this));
+			}
+		} BENCHMARK_RESULTS, *PBENCHMARK_RESULTS;
+
+		/// <summary>
+		/// Brings up a Driver, creates the requested IO queue pairs and drives the configured
+		/// workload for the configured duration.
+		/// </summary>
+		/// <param name="config">The workload to run</param>
+		/// <param name="results">Filled out with what the run measured</param>
+		/// <returns>true if the run completed (setup worked and no command failed)</returns>
+		bool runBenchmark(const BENCHMARK_CONFIG& config, BENCHMARK_RESULTS& results);
+
+		/// <summary>
+		/// Prints a fio-style report of a config and its results to stdout.
+		/// </summary>
+		/// <param name="config">The workload that ran</param>
+		/// <param name="results">What it measured</param>
+		void printReport(const BENCHMARK_CONFIG& config, const BENCHMARK_RESULTS& results);
+	}
+}
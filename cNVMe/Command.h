@@ -173,6 +173,13 @@ namespace cnvme
 							UINT_32 NUMDL : 16; // Number of DW Lower
 						} DW10_GetLogPage;
 
+						struct
+						{
+							UINT_32 FID : 8; // Feature Identifier
+							UINT_32 SET_FEATURES_DW10_RSVD : 23;
+							UINT_32 SV : 1; // Save
+						} DW10_SetFeatures; // Also used for Get Features (SV is SEL there)
+
 						struct
 						{
 							UINT_32 FS : 3; // Firmware Slot
@@ -202,6 +209,15 @@ namespace cnvme
 							UINT_32 CQID : 16; // Completion Queue Identifier
 						} DW11_CreateIoSubmissionQueue;
 
+						struct
+						{
+							UINT_32 AB : 3; // Arbitration Burst (2^n commands, 7 == unlimited)
+							UINT_32 ARBITRATION_DW11_RSVD : 5;
+							UINT_32 LPW : 8; // Low Priority Weight (0-based)
+							UINT_32 MPW : 8; // Medium Priority Weight (0-based)
+							UINT_32 HPW : 8; // High Priority Weight (0-based)
+						} DW11_Arbitration;
+
 						struct
 						{
 							UINT_32 NUMDU : 16; // Number of DW Upper
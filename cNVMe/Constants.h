@@ -56,11 +56,11 @@ namespace cnvme
 				const UINT_8 VIRTUALIZATION_MANAGEMENT = 0x1C;
 				const UINT_8 NVME_MI_SEND = 0x1D;
 				const UINT_8 NVME_MI_RECEIVE = 0x1E;
+				const UINT_8 DOORBELL_BUFFER_CONFIG = 0x7C;
 				const UINT_8 FORMAT_NVM = 0x80;
 				const UINT_8 SECURITY_SEND = 0x81;
 				const UINT_8 SECURITY_RECEIVE = 0x82;
 				const UINT_8 SANITIZE = 0x84;
-				const UINT_8 DOORBELL_BUFFER_CONFIG = 0x7C;
 			}
 
 			namespace nvm
@@ -180,6 +180,32 @@ namespace cnvme
 
 		namespace commands
 		{
+			namespace arbitration
+			{
+				const UINT_8 AB_UNLIMITED = 0x7; // Arbitration Burst value meaning 'no limit'
+				const UINT_8 WEIGHTED_ROUND_ROBIN_WITH_URGENT = 0x1; // CC.AMS value for WRR with urgent priority class
+			}
+
+			namespace features
+			{
+				const UINT_8 ARBITRATION = 0x01;
+			}
+
+			namespace log_page_ids
+			{
+				const UINT_8 SMART_HEALTH_INFORMATION = 0x02;
+				const UINT_8 FIRMWARE_SLOT_INFORMATION = 0x03;
+				const UINT_8 VENDOR_PERFORMANCE = 0xC0;
+			}
+
+			namespace queue_priorities
+			{
+				const UINT_8 URGENT = 0;
+				const UINT_8 HIGH = 1;
+				const UINT_8 MEDIUM = 2;
+				const UINT_8 LOW = 3;
+			}
+
 			namespace identify
 			{
 				namespace cns
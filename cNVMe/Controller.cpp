@@ -35,25 +35,64 @@ Controller.cpp - An implementation file for the NVMe Controller
 #include "Strings.h"
 #include "System.h"
 
+#ifndef _WIN32
+#include <sys/wait.h>
+#include <unistd.h>
+#endif // !_WIN32
+
 namespace cnvme
 {
 	namespace controller
 	{
-		Controller::Controller()
+		Controller::Controller() : Controller(nullptr)
 		{
-			this->CommandResponseApiFilePath = "";
+		}
 
-			PCIExpressRegisters = new pci::PCIExpressRegisters();
-			PCIExpressRegisters->waitForChangeLoop();
+		Controller::Controller(cnvme::WatcherPool* watcherPool)
+		{
+			this->CommandResponseApiFilePath = "";
+			this->CommandResponseApiPersistent = false;
+			this->TotalCompletionInterruptCount = 0;
+			this->ArbitrationBurst = constants::commands::arbitration::AB_UNLIMITED;
+			this->HighPriorityWeight = 0;   // 0-based: 1 command per round
+			this->MediumPriorityWeight = 0;
+			this->LowPriorityWeight = 0;
+			this->ControllerStartTime = std::chrono::steady_clock::now();
+			this->BackgroundCommandsInFlight = 0;
+			this->BackgroundCommandThreadRunning = false;
+			for (size_t i = 0; i < 256; i++)
+			{
+				this->AdminOpcodeCounts[i] = 0;
+				this->NvmOpcodeCounts[i] = 0;
+			}
+			this->CommandResponseWorkerPid = 0;
+			this->CommandResponseWorkerStdinFd = -1;
+			this->CommandResponseWorkerStdoutFd = -1;
+			this->IoQueueWorkersEnabled = false;
+			this->ShadowDoorbells = nullptr;
+			this->EventIdxs = nullptr;
+			this->SmartCounters.BytesRead = 0;
+			this->SmartCounters.BytesWritten = 0;
+			this->SmartCounters.HostReadCommands = 0;
+			this->SmartCounters.HostWriteCommands = 0;
+			this->SmartCounters.BusyTimeMicroseconds = 0;
+			this->FirmwareDownloadDWordCount = 0;
+			this->FirmwareDownloadEyeCatcherChecked = false;
+			this->FirmwareDownloadEyeCatcherValid = false;
+
+			this->WatchersStarted = false;
+
+			// Both register spaces initialize inline in their constructors now, so there is no
+			//  watcher handshake to wait out here; the watchers start lazily on first use
+			PCIExpressRegisters = new pci::PCIExpressRegisters(watcherPool);
 
 			pci::header::PCI_HEADER* PciHeader = PCIExpressRegisters->getPciExpressRegisters().PciHeader;
 			UINT_64 BAR0Address = (UINT_64)PciHeader->MLBAR.BA + ((UINT_64)PciHeader->MUBAR.BA << 18);
-			ControllerRegisters = new controller::registers::ControllerRegisters(BAR0Address, this); // Put the controller registers in BAR0/BAR1
-			ControllerRegisters->waitForChangeLoop();
+			ControllerRegisters = new controller::registers::ControllerRegisters(BAR0Address, this, watcherPool); // Put the controller registers in BAR0/BAR1
 
 #ifndef SINGLE_THREADED
 			DoorbellWatcher = LoopingThread([&] {Controller::checkForChanges(); }, CHANGE_CHECK_SLEEP_MS);
-			DoorbellWatcher.start();
+			DoorbellWatcher.setPool(watcherPool);
 #endif
 
 			// Setup the IC with default values.
@@ -72,6 +111,9 @@ namespace cnvme
 
 		Controller::~Controller()
 		{
+			stopBackgroundCommandThread();
+			stopAllIoQueueWorkers();
+			stopCommandResponseWorker();
 			DoorbellWatcher.end();
 
 			// Delete Controller Registers first, because deleting the PCI registers first could lead to the ControllerRegisters loop segfaulting
@@ -100,11 +142,15 @@ namespace cnvme
 
 		cnvme::controller::registers::ControllerRegisters* Controller::getControllerRegisters()
 		{
+			// Handing out the registers is the first moment someone could write one
+			ensureWatchersStarted();
 			return ControllerRegisters;
 		}
 
 		pci::PCIExpressRegisters* Controller::getPCIExpressRegisters()
 		{
+			// Handing out the registers is the first moment someone could write one
+			ensureWatchersStarted();
 			return PCIExpressRegisters;
 		}
 
@@ -162,43 +208,582 @@ namespace cnvme
 			}
 
 			// Made it this far, we have at least the admin queue
-			// This is round-robin right now
+
+			// WRR with urgent priority class if the host selected it via CC.AMS
+			if (controllerRegisters->CC.AMS == constants::commands::arbitration::WEIGHTED_ROUND_ROBIN_WITH_URGENT)
+			{
+				arbitrateAndServiceSubmissionQueues(doorbells);
+				return;
+			}
+
+			// Plain round-robin: every queue gets equal service
 			size_t currentValidSubmissionQueuesSize = this->ValidSubmissionQueues.size();
 			for (size_t idx = 0; idx < currentValidSubmissionQueuesSize; idx++)
 			{
 				// Using this instead of foreach since the ValidSubmission/Completion Queues can change at runtime.
 				auto sq = this->ValidSubmissionQueues[idx];
 
-				if (doorbells[sq->getQueueId()].SQTDBL.SQT != sq->getTailPointer())
+				// If IO queue workers are enabled, each IO queue has its own thread servicing it.
+				//  Only the admin queue stays here (to keep admin command ordering).
+				if (this->IoQueueWorkersEnabled && sq->getQueueId() != ADMIN_QUEUE_ID)
+				{
+					continue;
+				}
+
+				serviceSubmissionQueue(sq, doorbells);
+
+				// If the number of queues changed... maybe one got deleted or lost?
+				//  for safety, just break from this loop so that currentValidSubmissionQueuesSize gets updated on the next go.
+				if (currentValidSubmissionQueuesSize != this->ValidSubmissionQueues.size())
+				{
+					break;
+				}
+			}
+		}
+
+		UINT_32 Controller::serviceSubmissionQueue(Queue* submissionQueue, controller::registers::QUEUE_DOORBELLS* doorbells, UINT_32 maxCommands)
+		{
+			auto sq = submissionQueue;
+
+			UINT_32 latestTail = doorbells[sq->getQueueId()].SQTDBL.SQT;
+			UINT_32* shadowDoorbells = this->ShadowDoorbells.load(std::memory_order_acquire);
+			if (shadowDoorbells)
+			{
+				// Doorbell Buffer Config is live: the host may have skipped the doorbell register
+				//  write entirely, so the shadow slot is the authoritative tail.
+				latestTail = shadowDoorbells[sq->getQueueId() * 2];
+			}
+
+			if (latestTail != sq->getTailPointer())
+			{
+				if (!sq->setTailPointer(latestTail)) // Set our internal Queue instance's tail
+				{
+					LOG_ERROR("Should trigger AER since the Tail pointer given was invalid"); // Stop early.
+					return 0;
+				}
+				else
+				{
+					sq->getMappedQueue()->setTailPointer(sq->getTailPointer());  // Set in internal CQ as well
+				}
+			}
+
+			// Drain the burst in one pass (capped if the arbiter limits our turn), then ring
+			//  the completion doorbell once for the batch instead of once per command.
+			UINT_32 commandsProcessed = 0;
+			while (sq->getHeadPointer() != sq->getTailPointer() && (maxCommands == 0 || commandsProcessed < maxCommands))
+			{
+				processCommandAndPostCompletion(*sq, false);
+				sq->incrementAndGetHeadCloserToTail();
+				commandsProcessed++;
+			}
+
+			if (commandsProcessed > 0 && sq->getMappedQueue())
+			{
+				ringCompletionQueueDoorbell(*sq->getMappedQueue());
+			}
+
+			// With shadow doorbells live, publish how far we have consumed; the host keeps
+			//  skipping the real doorbell write until its tail crosses this value.
+			UINT_32* eventIdxs = this->EventIdxs.load(std::memory_order_acquire);
+			if (eventIdxs)
+			{
+				eventIdxs[sq->getQueueId() * 2] = sq->getTailPointer();
+			}
+
+			return commandsProcessed;
+		}
+
+		void Controller::arbitrateAndServiceSubmissionQueues(controller::registers::QUEUE_DOORBELLS* doorbells)
+		{
+			using namespace constants::commands;
+
+			bool workPossiblyRemaining = true;
+			while (workPossiblyRemaining)
+			{
+				workPossiblyRemaining = false;
+				size_t queueCountAtStart = this->ValidSubmissionQueues.size();
+
+				// Admin, then urgent class: strict priority, fully drained before anything else
+				for (size_t idx = 0; idx < queueCountAtStart; idx++)
 				{
-					if (!sq->setTailPointer(doorbells[sq->getQueueId()].SQTDBL.SQT)) // Set our internal Queue instance's tail
+					auto sq = this->ValidSubmissionQueues[idx];
+					if (this->IoQueueWorkersEnabled && sq->getQueueId() != ADMIN_QUEUE_ID)
 					{
-						LOG_ERROR("Should trigger AER since the Tail pointer given was invalid"); // Stop early.
-						continue;
+						continue; // that queue's worker thread services it
 					}
-					else
+					if (sq->getQueueId() == ADMIN_QUEUE_ID || sq->getPriority() == queue_priorities::URGENT)
 					{
-						sq->getMappedQueue()->setTailPointer(sq->getTailPointer());  // Set in internal CQ as well
+						serviceSubmissionQueue(sq, doorbells);
+						if (queueCountAtStart != this->ValidSubmissionQueues.size())
+						{
+							return; // a queue came or went (admin command): re-arbitrate on the next poll
+						}
 					}
+				}
+
+				// Weighted classes: each class gets (weight + 1) commands per round,
+				//  fetched in bursts of up to the arbitration burst per queue turn.
+				const UINT_8 priorityClasses[] = { queue_priorities::HIGH, queue_priorities::MEDIUM, queue_priorities::LOW };
+				const UINT_32 classWeights[] = { (UINT_32)this->HighPriorityWeight + 1, (UINT_32)this->MediumPriorityWeight + 1, (UINT_32)this->LowPriorityWeight + 1 };
+				UINT_32 burstCommands = (this->ArbitrationBurst >= arbitration::AB_UNLIMITED) ? 0 : (1u << this->ArbitrationBurst);
 
-					while (sq->getHeadPointer() != sq->getTailPointer())
+				for (size_t classIdx = 0; classIdx < sizeof(priorityClasses); classIdx++)
+				{
+					UINT_32 credit = classWeights[classIdx];
+					bool servicedSomething = true;
+					while (credit > 0 && servicedSomething)
 					{
-						processCommandAndPostCompletion(*sq);
-						sq->incrementAndGetHeadCloserToTail();
+						servicedSomething = false;
+						for (size_t idx = 0; idx < queueCountAtStart && credit > 0; idx++)
+						{
+							auto sq = this->ValidSubmissionQueues[idx];
+							if (sq->getQueueId() == ADMIN_QUEUE_ID || sq->getPriority() != priorityClasses[classIdx] ||
+								(this->IoQueueWorkersEnabled && sq->getQueueId() != ADMIN_QUEUE_ID))
+							{
+								continue;
+							}
+
+							UINT_32 turnCap = (burstCommands == 0) ? credit : std::min(burstCommands, credit);
+							UINT_32 commandsProcessed = serviceSubmissionQueue(sq, doorbells, turnCap);
+							if (queueCountAtStart != this->ValidSubmissionQueues.size())
+							{
+								return; // a queue came or went: re-arbitrate on the next poll
+							}
+
+							credit -= std::min(commandsProcessed, credit);
+							if (commandsProcessed > 0)
+							{
+								servicedSomething = true;
+							}
+							if (commandsProcessed == turnCap && turnCap > 0)
+							{
+								workPossiblyRemaining = true; // the cap may have cut the queue off mid-backlog
+							}
+						}
 					}
+				}
+			}
+		}
+
+		void Controller::ioQueueWorkerIteration(UINT_16 queueId)
+		{
+			auto controllerRegisters = ControllerRegisters->getControllerRegisters();
+			if (controllerRegisters->CSTS.RDY == 0)
+			{
+				return; // Not ready... Don't do anything.
+			}
+
+			Queue* sq = nullptr;
+			{
+				std::lock_guard<std::mutex> queueLock(this->QueueCollectionMutex);
+				sq = getQueueWithId(this->ValidSubmissionQueues, queueId);
+			}
+
+			// The queue can briefly not exist (worker starting before the create completes, or a reset in flight)
+			if (sq)
+			{
+				serviceSubmissionQueue(sq, getControllerRegisters()->getQueueDoorbells());
+			}
+		}
+
+		void Controller::startIoQueueWorker(UINT_16 queueId)
+		{
+			LoopingThread* worker = nullptr;
+			{
+				std::lock_guard<std::mutex> queueLock(this->QueueCollectionMutex);
+
+				if (this->IoQueueWorkers.find(queueId) != this->IoQueueWorkers.end())
+				{
+					return; // already have a worker for this queue
+				}
+
+				worker = new LoopingThread([this, queueId] { this->ioQueueWorkerIteration(queueId); }, CHANGE_CHECK_SLEEP_MS);
+				this->IoQueueWorkers[queueId] = worker;
+
+				// The worker is the fetch/decode stage; give the queue its execute stage too
+				auto pipeline = std::make_shared<IO_QUEUE_PIPELINE>();
+				pipeline->Running = true;
+				pipeline->ExecuteThread = std::thread(&Controller::pipelineExecuteLoop, this, pipeline);
+				this->IoQueuePipelines[queueId] = pipeline;
+			}
+
+			// Start outside the lock since the worker's first iteration takes the QueueCollectionMutex
+			worker->start();
+
+			LOG_INFO("Started a worker thread for IO submission queue " + std::to_string(queueId));
+		}
+
+		void Controller::stopIoQueueWorker(UINT_16 queueId)
+		{
+			LoopingThread* worker = nullptr;
+			{
+				std::lock_guard<std::mutex> queueLock(this->QueueCollectionMutex);
+				auto itr = this->IoQueueWorkers.find(queueId);
+				if (itr == this->IoQueueWorkers.end())
+				{
+					return;
+				}
+				worker = itr->second;
+				this->IoQueueWorkers.erase(itr);
+			}
+
+			// End outside the lock since the worker's iteration takes the QueueCollectionMutex
+			worker->end();
+			delete worker;
 
-					// If the number of queues changed... maybe one got deleted or lost?
-					//  for safety, just break from this loop so that currentValidSubmissionQueuesSize gets updated on the next go.
-					if (currentValidSubmissionQueuesSize != this->ValidSubmissionQueues.size())
+			// With the fetch stage gone nothing new can stage; drain and stop the execute stage
+			stopIoQueuePipeline(queueId);
+
+			LOG_INFO("Stopped the worker thread for IO submission queue " + std::to_string(queueId));
+		}
+
+		void Controller::stopAllIoQueueWorkers()
+		{
+			std::vector<LoopingThread*> workers;
+			std::vector<UINT_16> pipelineQueueIds;
+			{
+				std::lock_guard<std::mutex> queueLock(this->QueueCollectionMutex);
+				for (auto &itr : this->IoQueueWorkers)
+				{
+					workers.push_back(itr.second);
+				}
+				this->IoQueueWorkers.clear();
+
+				for (auto &itr : this->IoQueuePipelines)
+				{
+					pipelineQueueIds.push_back(itr.first);
+				}
+			}
+
+			for (LoopingThread* worker : workers)
+			{
+				worker->end();
+				delete worker;
+			}
+
+			// Fetch stages are gone; drain and stop each queue's execute stage
+			for (UINT_16 queueId : pipelineQueueIds)
+			{
+				stopIoQueuePipeline(queueId);
+			}
+		}
+
+		bool Controller::stagePipelinedCommand(Queue& submissionQueue, const NVME_COMMAND& command, Queue* completionQueue, std::chrono::steady_clock::time_point pickupTime)
+		{
+			std::shared_ptr<IO_QUEUE_PIPELINE> pipeline;
+			{
+				std::lock_guard<std::mutex> queueLock(this->QueueCollectionMutex);
+				auto itr = this->IoQueuePipelines.find(submissionQueue.getQueueId());
+				if (itr != this->IoQueuePipelines.end())
+				{
+					pipeline = itr->second;
+				}
+			}
+
+			if (!pipeline)
+			{
+				return false; // no workers for this queue, so no pipeline either
+			}
+
+			{
+				std::lock_guard<std::mutex> pipelineLock(pipeline->Mutex);
+				if (!pipeline->Running || pipeline->StagedCommands.size() >= IO_QUEUE_PIPELINE_MAX_STAGED)
+				{
+					return false; // stopping or backed up: the caller runs the command inline
+				}
+
+				PIPELINED_COMMAND pipelinedCommand;
+				pipelinedCommand.Command = command;
+				pipelinedCommand.CompletionQueue = completionQueue;
+				pipelinedCommand.SubmissionQueueId = submissionQueue.getQueueId();
+				pipelinedCommand.PickupTime = pickupTime;
+				pipeline->StagedCommands.push_back(pipelinedCommand);
+			}
+			pipeline->Condition.notify_one();
+
+			return true;
+		}
+
+		void Controller::pipelineExecuteLoop(std::shared_ptr<IO_QUEUE_PIPELINE> pipeline)
+		{
+			std::unique_lock<std::mutex> pipelineLock(pipeline->Mutex);
+			while (pipeline->Running || !pipeline->StagedCommands.empty())
+			{
+				if (pipeline->StagedCommands.empty())
+				{
+					pipeline->Condition.wait(pipelineLock);
+					continue;
+				}
+
+				PIPELINED_COMMAND pipelinedCommand = pipeline->StagedCommands.front();
+				pipeline->StagedCommands.pop_front();
+
+				// Execute without the lock so the fetch/decode stage can keep staging
+				pipelineLock.unlock();
+				processPipelinedCommand(pipelinedCommand);
+				pipelineLock.lock();
+			}
+		}
+
+		void Controller::processPipelinedCommand(PIPELINED_COMMAND& pipelinedCommand)
+		{
+			COMPLETION_QUEUE_ENTRY completionQueueEntryToPost = { 0 };
+
+			auto itr = this->NVMCommandCallers.find(pipelinedCommand.Command.DWord0Breakdown.OPC);
+			if (itr != this->NVMCommandCallers.end())
+			{
+				NVMeCaller caller = itr->second;
+				(this->*caller)(pipelinedCommand.Command, completionQueueEntryToPost);
+			}
+			else
+			{
+				// We don't have handling for this command
+				LOG_INFO("Unknown NVM command recv'd by the controller.");
+				completionQueueEntryToPost.SC = constants::status::codes::generic::INVALID_COMMAND_OPCODE; // Unsupported Opcode
+				completionQueueEntryToPost.DNR = 1;                                                        // Do not retry
+			}
+
+			// Hold the completion back for the opcode's modeled device latency (if any)
+			UINT_64 modeledLatencyMicroseconds = 0;
+			bool useModeledLatency = applyModeledLatency(false, pipelinedCommand.Command.DWord0Breakdown.OPC, modeledLatencyMicroseconds);
+
+			// Always ring here: the fetch stage's batch doorbell ring may already have happened
+			postCompletion(*pipelinedCommand.CompletionQueue, completionQueueEntryToPost, &pipelinedCommand.Command, true);
+
+			// Account for the command now that its completion is visible
+			UINT_32 assumedSectorSize = DEFAULT_SECTOR_SIZE;
+			auto namespaceItr = this->NamespaceIdToActiveNamespace.find(pipelinedCommand.Command.NSID);
+			if (namespaceItr != this->NamespaceIdToActiveNamespace.end())
+			{
+				auto identifyNamespace = namespaceItr->second.getIdentifyNamespaceStructure();
+				assumedSectorSize = (UINT_32)std::pow(2, identifyNamespace.LBAF[identifyNamespace.FLBAS.CurrentLBAFormat].LBADS);
+			}
+			auto completionTime = std::chrono::steady_clock::now();
+			UINT_64 latencyMicroseconds = std::chrono::duration_cast<std::chrono::microseconds>(completionTime - pipelinedCommand.PickupTime).count();
+			if (useModeledLatency)
+			{
+				latencyMicroseconds = modeledLatencyMicroseconds; // a virtual clock delay took no wall time
+			}
+			recordCommandPerformance(pipelinedCommand.SubmissionQueueId, false, pipelinedCommand.Command.DWord0Breakdown.OPC, latencyMicroseconds,
+				pipelinedCommand.Command.getTransferSizeBytes(false, assumedSectorSize));
+
+			std::shared_ptr<tracing::CommandTracer> tracer;
+			{
+				std::lock_guard<std::mutex> tracerLock(this->CommandTracerMutex);
+				tracer = this->CommandTracer;
+			}
+			if (tracer)
+			{
+				tracer->recordCommand(pipelinedCommand.Command, completionQueueEntryToPost, pipelinedCommand.SubmissionQueueId, pipelinedCommand.PickupTime, completionTime);
+			}
+		}
+
+		void Controller::stopIoQueuePipeline(UINT_16 queueId)
+		{
+			std::shared_ptr<IO_QUEUE_PIPELINE> pipeline;
+			{
+				std::lock_guard<std::mutex> queueLock(this->QueueCollectionMutex);
+				auto itr = this->IoQueuePipelines.find(queueId);
+				if (itr == this->IoQueuePipelines.end())
+				{
+					return;
+				}
+				pipeline = itr->second;
+				this->IoQueuePipelines.erase(itr);
+			}
+
+			{
+				std::lock_guard<std::mutex> pipelineLock(pipeline->Mutex);
+				pipeline->Running = false;
+			}
+			pipeline->Condition.notify_one();
+			pipeline->ExecuteThread.join(); // the loop drains anything still staged before exiting
+
+			LOG_INFO("Stopped the pipeline execute stage for IO submission queue " + std::to_string(queueId));
+		}
+
+		void Controller::setIoQueueWorkersEnabled(bool enabled)
+		{
+#ifdef SINGLE_THREADED
+			// No worker threads exist in this profile; every queue gets serviced inline
+			LOG_INFO("Ignoring the IO queue worker setting: the SINGLE_THREADED profile services queues inline");
+			return;
+#endif
+			this->IoQueueWorkersEnabled = enabled;
+
+			if (enabled)
+			{
+				// Give every existing IO queue a worker
+				std::vector<UINT_16> queueIds;
+				{
+					std::lock_guard<std::mutex> queueLock(this->QueueCollectionMutex);
+					for (Queue* sq : this->ValidSubmissionQueues)
 					{
-						break;
+						if (sq->getQueueId() != ADMIN_QUEUE_ID)
+						{
+							queueIds.push_back(sq->getQueueId());
+						}
 					}
 				}
+
+				for (UINT_16 queueId : queueIds)
+				{
+					startIoQueueWorker(queueId);
+				}
+			}
+			else
+			{
+				stopAllIoQueueWorkers();
+			}
+		}
+
+		void Controller::enableCommandTracing(const std::string& traceFilePath, UINT_64 recordCapacity)
+		{
+			auto tracer = std::make_shared<tracing::CommandTracer>(traceFilePath, recordCapacity);
+			std::lock_guard<std::mutex> tracerLock(this->CommandTracerMutex);
+			this->CommandTracer = tracer;
+		}
+
+		void Controller::disableCommandTracing()
+		{
+			std::shared_ptr<tracing::CommandTracer> tracer;
+			{
+				std::lock_guard<std::mutex> tracerLock(this->CommandTracerMutex);
+				tracer = this->CommandTracer;
+				this->CommandTracer = nullptr;
+			}
+			// tracer finalizes the file here, once any in-flight recordCommand lets go
+		}
+
+		void Controller::setTimingEngine(const std::shared_ptr<timing::TimingEngine>& timingEngine)
+		{
+			std::lock_guard<std::mutex> timingLock(this->TimingEngineMutex);
+			this->TimingEngine = timingEngine;
+		}
+
+		void Controller::ensureWatchersStarted()
+		{
+#ifndef SINGLE_THREADED
+			// Flag first: the doorbell watcher's own first iteration lands back in here (via
+			//  getControllerRegisters()) while we're still waiting out its start handshake
+			if (this->WatchersStarted.exchange(true))
+			{
+				return; // already started (or another thread is mid-start; the watchers poll, so no write gets lost)
+			}
+
+			// Bottom up, like step(): PCIe config space, then BAR0, then the doorbells
+			PCIExpressRegisters->startRegisterWatcher();
+			ControllerRegisters->startRegisterWatcher();
+			DoorbellWatcher.start();
+#endif
+		}
+
+		void Controller::recycle()
+		{
+			auto controllerRegisters = this->ControllerRegisters->getControllerRegisters();
+			ASSERT_IF(controllerRegisters == nullptr, "recycle() called without controller registers");
+
+			if (controllerRegisters->CC.EN == 1)
+			{
+				// Take the same disable path a host reset takes, so the queues, CIDs, shadow
+				//  doorbells and firmware download state all get torn down the normal way
+				controllerRegisters->CC.EN = 0;
+				auto deathTime = std::chrono::steady_clock::now() + std::chrono::milliseconds((UINT_64)controllerRegisters->CAP.TO * 500);
+				while (controllerRegisters->CSTS.RDY == 1 && std::chrono::steady_clock::now() < deathTime)
+				{
+					this->ControllerRegisters->waitForChangeLoop();
+				}
+				ASSERT_IF(controllerRegisters->CSTS.RDY == 1, "recycle() couldn't get the controller to disable");
+
+				// One full doorbell watcher pass so an iteration that saw RDY=1 is done
+				//  with the queues before they get deleted below
+				this->waitForChangeLoop();
+			}
+			else
+			{
+				this->controllerResetCallback(); // never enabled: still drop anything staged
+			}
+
+			// A fresh controller has no queues at all (the admin queue arrives when the host
+			//  enables), so drop the admin queues the reset path deliberately keeps
+			{
+				std::lock_guard<std::mutex> queueLock(this->QueueCollectionMutex);
+				for (Queue* q : this->ValidSubmissionQueues)
+				{
+					delete q;
+				}
+				this->ValidSubmissionQueues.clear();
+				for (Queue* q : this->ValidCompletionQueues)
+				{
+					delete q;
+				}
+				this->ValidCompletionQueues.clear();
+			}
+			controllerRegisters->AQA = { 0 };
+			controllerRegisters->ASQ = { 0 };
+			controllerRegisters->ACQ = { 0 };
+
+			// Detach the per-instance hooks the last user may have left behind
+			this->disableCommandTracing();
+			this->setTimingEngine(nullptr);
+			this->stopCommandResponseWorker();
+			this->CommandResponseApiFilePath = "";
+			this->CommandResponseApiPersistent = false;
+
+			// Back to the constructor's identify/namespace/accounting defaults
+			this->NamespaceIdToActiveNamespace.clear();
+			this->NamespaceIdToActiveNamespace[1] = ns::Namespace(DEFAULT_NAMESPACE_SIZE);
+			resetIdentifyController();
+			this->invalidateIdentifyResponseCache();
+
+			this->ArbitrationBurst = constants::commands::arbitration::AB_UNLIMITED;
+			this->HighPriorityWeight = 0;
+			this->MediumPriorityWeight = 0;
+			this->LowPriorityWeight = 0;
+
+			for (size_t i = 0; i < 256; i++)
+			{
+				this->AdminOpcodeCounts[i] = 0;
+				this->NvmOpcodeCounts[i] = 0;
 			}
+			{
+				std::lock_guard<std::mutex> countersLock(this->PerformanceCountersMutex);
+				this->SubmissionQueueIdToPerformanceCounters.clear();
+			}
+			this->SmartCounters.BytesRead = 0;
+			this->SmartCounters.BytesWritten = 0;
+			this->SmartCounters.HostReadCommands = 0;
+			this->SmartCounters.HostWriteCommands = 0;
+			this->SmartCounters.BusyTimeMicroseconds = 0;
+			this->ControllerStartTime = std::chrono::steady_clock::now();
+
+			this->FirmwareSlotInfo = { 0 };
+			this->FirmwareSlotInfo.AFI.ActiveFirmwareSlot = 1;
+			memcpy_s(&this->FirmwareSlotInfo.FRS[ZERO_BASED_FROM_ONE_BASED(this->FirmwareSlotInfo.AFI.ActiveFirmwareSlot)],
+				sizeof(this->FirmwareSlotInfo.FRS[ZERO_BASED_FROM_ONE_BASED(this->FirmwareSlotInfo.AFI.ActiveFirmwareSlot)]), DEFAULT_FIRMWARE, strlen(DEFAULT_FIRMWARE));
 		}
 
-		void Controller::processCommandAndPostCompletion(Queue &submissionQueue)
+		bool Controller::applyModeledLatency(bool adminCommand, UINT_8 opcode, UINT_64& modeledLatencyMicroseconds)
 		{
+			modeledLatencyMicroseconds = 0;
+
+			std::shared_ptr<timing::TimingEngine> timingEngine;
+			{
+				std::lock_guard<std::mutex> timingLock(this->TimingEngineMutex);
+				timingEngine = this->TimingEngine;
+			}
+
+			if (timingEngine)
+			{
+				return timingEngine->delayBeforeCompletion(adminCommand, opcode, modeledLatencyMicroseconds);
+			}
+			return false;
+		}
+
+		void Controller::processCommandAndPostCompletion(Queue &submissionQueue, bool ringCompletionDoorbell)
+		{
+			auto commandPickupTime = std::chrono::steady_clock::now(); // doorbell pickup: latency starts here
+
 			Queue* theCompletionQueue = submissionQueue.getMappedQueue();
 			if (!theCompletionQueue)
 			{
@@ -224,6 +809,20 @@ namespace cnvme
 
 				LOG_INFO("Controller got a command:\n" + command->toString());
 
+				// Long-running admin commands go to the background executor so one format/commit
+				//  doesn't stall every queue on the controller. Their completion posts later.
+				if (submissionQueue.getQueueId() == ADMIN_QUEUE_ID && shouldWeProcessThisCommand && this->shouldExecuteInBackground(*command))
+				{
+					BACKGROUND_COMMAND backgroundCommand;
+					backgroundCommand.Command = *command; // copy: the SQ slot can be reused once the head moves
+					backgroundCommand.CompletionQueue = theCompletionQueue;
+					backgroundCommand.SubmissionQueueId = submissionQueue.getQueueId();
+					backgroundCommand.RingCompletionDoorbell = ringCompletionDoorbell;
+					backgroundCommand.PickupTime = commandPickupTime;
+					this->queueBackgroundCommand(backgroundCommand);
+					return; // the background executor posts the completion and does the accounting
+				}
+
 				if (submissionQueue.getQueueId() == ADMIN_QUEUE_ID && shouldWeProcessThisCommand)
 				{
 					LOG_INFO("That was an Admin command!");
@@ -244,28 +843,320 @@ namespace cnvme
 						completionQueueEntryToPost.DNR = 1;                                                        // Do not retry
 					}
 				}
-				else if (shouldWeProcessThisCommand) // NVM Command
+				else if (shouldWeProcessThisCommand) // NVM Command
+				{
+					LOG_INFO("That was an NVM command!");
+
+					// Fetch/decode is done; if this queue has a pipeline, hand the command to its
+					//  execute stage and go fetch the next one. Overlapping the stages this way
+					//  is what queue workers buy us; without one we just run everything inline.
+					if (this->stagePipelinedCommand(submissionQueue, *command, theCompletionQueue, commandPickupTime))
+					{
+						return; // the execute stage posts the completion and does the accounting
+					}
+
+					// AdminCommandCallers goes from OpCode to Function to call. 
+					//  All functions to call must have the same parameters and return value (no return since they are voids)
+					auto itr = this->NVMCommandCallers.find(command->DWord0Breakdown.OPC);
+					if (itr != this->NVMCommandCallers.end())
+					{
+						NVMeCaller caller = itr->second;
+						(this->*caller)(*command, completionQueueEntryToPost);
+					}
+					else
+					{
+						// We don't have handling for this command
+						LOG_INFO("Unknown NVM command recv'd by the controller.");
+						completionQueueEntryToPost.SC = constants::status::codes::generic::INVALID_COMMAND_OPCODE; // Unsupported Opcode
+						completionQueueEntryToPost.DNR = 1;                                                        // Do not retry
+					}
+				}
+			}
+			// Hold the completion back for the opcode's modeled device latency (if any)
+			bool adminCommand = (submissionQueue.getQueueId() == ADMIN_QUEUE_ID);
+			UINT_64 modeledLatencyMicroseconds = 0;
+			bool useModeledLatency = applyModeledLatency(adminCommand, command->DWord0Breakdown.OPC, modeledLatencyMicroseconds);
+
+			postCompletion(*theCompletionQueue, completionQueueEntryToPost, command, ringCompletionDoorbell);
+
+			// Account for the command now that its completion is visible
+			UINT_32 assumedSectorSize = DEFAULT_SECTOR_SIZE;
+			auto namespaceItr = this->NamespaceIdToActiveNamespace.find(command->NSID);
+			if (namespaceItr != this->NamespaceIdToActiveNamespace.end())
+			{
+				auto identifyNamespace = namespaceItr->second.getIdentifyNamespaceStructure();
+				assumedSectorSize = (UINT_32)std::pow(2, identifyNamespace.LBAF[identifyNamespace.FLBAS.CurrentLBAFormat].LBADS);
+			}
+			auto completionTime = std::chrono::steady_clock::now();
+			UINT_64 latencyMicroseconds = std::chrono::duration_cast<std::chrono::microseconds>(completionTime - commandPickupTime).count();
+			if (useModeledLatency)
+			{
+				latencyMicroseconds = modeledLatencyMicroseconds; // a virtual clock delay took no wall time
+			}
+			recordCommandPerformance(submissionQueue.getQueueId(), adminCommand, command->DWord0Breakdown.OPC, latencyMicroseconds,
+				command->getTransferSizeBytes(adminCommand, assumedSectorSize));
+
+			std::shared_ptr<tracing::CommandTracer> tracer;
+			{
+				std::lock_guard<std::mutex> tracerLock(this->CommandTracerMutex);
+				tracer = this->CommandTracer;
+			}
+			if (tracer)
+			{
+				tracer->recordCommand(*command, completionQueueEntryToPost, submissionQueue.getQueueId(), commandPickupTime, completionTime);
+			}
+		}
+
+		void Controller::recordCommandPerformance(UINT_16 submissionQueueId, bool adminCommand, UINT_8 opcode, UINT_64 latencyMicroseconds, UINT_64 bytesTransferred)
+		{
+			std::shared_ptr<ATOMIC_QUEUE_PERFORMANCE_COUNTERS> counters;
+			{
+				std::lock_guard<std::mutex> countersLock(this->PerformanceCountersMutex);
+				auto &slot = this->SubmissionQueueIdToPerformanceCounters[submissionQueueId];
+				if (!slot)
+				{
+					slot = std::make_shared<ATOMIC_QUEUE_PERFORMANCE_COUNTERS>(); // value-initialized: all counters start at 0
+				}
+				counters = slot;
+			}
+
+			counters->CommandsCompleted.fetch_add(1, std::memory_order_relaxed);
+			counters->BytesTransferred.fetch_add(bytesTransferred, std::memory_order_relaxed);
+			counters->TotalLatencyMicroseconds.fetch_add(latencyMicroseconds, std::memory_order_relaxed);
+
+			UINT_64 previousMax = counters->MaxLatencyMicroseconds.load(std::memory_order_relaxed);
+			while (latencyMicroseconds > previousMax &&
+				!counters->MaxLatencyMicroseconds.compare_exchange_weak(previousMax, latencyMicroseconds, std::memory_order_relaxed))
+			{
+				// previousMax was refreshed by the failed exchange: keep trying while we are still the max
+			}
+
+			size_t bucket = 0;
+			while ((1ULL << bucket) <= latencyMicroseconds && bucket < PERFORMANCE_LOG_LATENCY_BUCKETS - 1)
+			{
+				bucket++;
+			}
+			counters->LatencyHistogram[bucket].fetch_add(1, std::memory_order_relaxed);
+
+			if (adminCommand)
+			{
+				this->AdminOpcodeCounts[opcode].fetch_add(1, std::memory_order_relaxed);
+			}
+			else
+			{
+				this->NvmOpcodeCounts[opcode].fetch_add(1, std::memory_order_relaxed);
+			}
+
+			// SMART fabric: a couple of relaxed bumps on padded counters
+			this->SmartCounters.BusyTimeMicroseconds.fetch_add(latencyMicroseconds, std::memory_order_relaxed);
+			if (!adminCommand && opcode == constants::opcodes::nvm::READ)
+			{
+				this->SmartCounters.BytesRead.fetch_add(bytesTransferred, std::memory_order_relaxed);
+				this->SmartCounters.HostReadCommands.fetch_add(1, std::memory_order_relaxed);
+			}
+			else if (!adminCommand && opcode == constants::opcodes::nvm::WRITE)
+			{
+				this->SmartCounters.BytesWritten.fetch_add(bytesTransferred, std::memory_order_relaxed);
+				this->SmartCounters.HostWriteCommands.fetch_add(1, std::memory_order_relaxed);
+			}
+		}
+
+		Payload Controller::getPerformanceLogPage()
+		{
+			// snapshot the queue list under the lock; the counter reads don't need it
+			std::vector<std::pair<UINT_16, std::shared_ptr<ATOMIC_QUEUE_PERFORMANCE_COUNTERS>>> queueCounters;
+			{
+				std::lock_guard<std::mutex> countersLock(this->PerformanceCountersMutex);
+				for (auto &itr : this->SubmissionQueueIdToPerformanceCounters)
+				{
+					queueCounters.push_back(itr);
+				}
+			}
+
+			Payload logPayload(sizeof(log_pages::PERFORMANCE_LOG_HEADER) + (queueCounters.size() * sizeof(log_pages::QUEUE_PERFORMANCE_STATS)));
+
+			auto pHeader = (log_pages::PPERFORMANCE_LOG_HEADER)logPayload.getBuffer();
+			pHeader->QueueCount = (UINT_32)queueCounters.size();
+			pHeader->LatencyBucketCount = PERFORMANCE_LOG_LATENCY_BUCKETS;
+			pHeader->ControllerUpMilliseconds = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - this->ControllerStartTime).count();
+			for (size_t i = 0; i < 256; i++)
+			{
+				pHeader->AdminOpcodeCounts[i] = this->AdminOpcodeCounts[i].load(std::memory_order_relaxed);
+				pHeader->NvmOpcodeCounts[i] = this->NvmOpcodeCounts[i].load(std::memory_order_relaxed);
+			}
+
+			auto pEntry = (log_pages::PQUEUE_PERFORMANCE_STATS)(logPayload.getBuffer() + sizeof(log_pages::PERFORMANCE_LOG_HEADER));
+			for (auto &itr : queueCounters)
+			{
+				pEntry->SubmissionQueueId = itr.first;
+				pEntry->CommandsCompleted = itr.second->CommandsCompleted.load(std::memory_order_relaxed);
+				pEntry->BytesTransferred = itr.second->BytesTransferred.load(std::memory_order_relaxed);
+				pEntry->TotalLatencyMicroseconds = itr.second->TotalLatencyMicroseconds.load(std::memory_order_relaxed);
+				pEntry->MaxLatencyMicroseconds = itr.second->MaxLatencyMicroseconds.load(std::memory_order_relaxed);
+				for (size_t i = 0; i < PERFORMANCE_LOG_LATENCY_BUCKETS; i++)
+				{
+					pEntry->LatencyHistogram[i] = itr.second->LatencyHistogram[i].load(std::memory_order_relaxed);
+				}
+				pEntry++;
+			}
+
+			return logPayload;
+		}
+
+		Payload Controller::getSmartHealthLogPage()
+		{
+			log_pages::SMART_HEALTH_INFO smartInfo = { 0 };
+
+			// Places a value in the low half of one of the 128 bit counters
+			auto placeCounter = [](UINT_8* counterField, UINT_64 value)
+			{
+				memcpy_s(counterField, 16, &value, sizeof(value));
+			};
+
+			// Data units are thousands of 512 byte units, rounded up so even a single
+			//  sector of traffic is visible to host tooling
+			auto bytesToDataUnits = [](UINT_64 bytes) -> UINT_64
+			{
+				return ((bytes / 512) + 999) / 1000;
+			};
+
+			UINT_16 compositeTemperatureKelvin = 300; // simulated media runs nice and cool (~27C)
+			memcpy_s(smartInfo.CompositeTemperature, sizeof(smartInfo.CompositeTemperature), &compositeTemperatureKelvin, sizeof(compositeTemperatureKelvin));
+			smartInfo.AvailableSpare = 100;			// RAM doesn't wear out
+			smartInfo.AvailableSpareThreshold = 10;
+			smartInfo.PercentageUsed = 0;
+
+			placeCounter(smartInfo.DataUnitsRead, bytesToDataUnits(this->SmartCounters.BytesRead.load(std::memory_order_relaxed)));
+			placeCounter(smartInfo.DataUnitsWritten, bytesToDataUnits(this->SmartCounters.BytesWritten.load(std::memory_order_relaxed)));
+			placeCounter(smartInfo.HostReadCommands, this->SmartCounters.HostReadCommands.load(std::memory_order_relaxed));
+			placeCounter(smartInfo.HostWriteCommands, this->SmartCounters.HostWriteCommands.load(std::memory_order_relaxed));
+			placeCounter(smartInfo.ControllerBusyTime, this->SmartCounters.BusyTimeMicroseconds.load(std::memory_order_relaxed) / (60ULL * 1000000ULL));
+			placeCounter(smartInfo.PowerCycles, 1);	// constructing the controller is our one power on
+			placeCounter(smartInfo.PowerOnHours, std::chrono::duration_cast<std::chrono::hours>(std::chrono::steady_clock::now() - this->ControllerStartTime).count());
+
+			return Payload((BYTE*)&smartInfo, sizeof(smartInfo));
+		}
+
+		size_t Controller::getBackgroundCommandsInFlight()
+		{
+			std::lock_guard<std::mutex> backgroundLock(this->BackgroundCommandMutex);
+			return this->BackgroundCommandsInFlight;
+		}
+
+		bool Controller::shouldExecuteInBackground(const NVME_COMMAND& command)
+		{
+#ifdef SINGLE_THREADED
+			// One command is one synchronous call chain in this profile; nothing runs in
+			//  the background (there is no thread for it to run on)
+			return false;
+#else
+			// Commands that touch every byte of media (or swap the running firmware) are the
+			//  long-running ones worth taking off the doorbell thread
+			return (command.DWord0Breakdown.OPC == constants::opcodes::admin::FORMAT_NVM || \
+				command.DWord0Breakdown.OPC == constants::opcodes::admin::FIRMWARE_COMMIT);
+#endif
+		}
+
+		void Controller::queueBackgroundCommand(const BACKGROUND_COMMAND& backgroundCommand)
+		{
+			std::lock_guard<std::mutex> backgroundLock(this->BackgroundCommandMutex);
+
+			if (!this->BackgroundCommandThreadRunning)
+			{
+				if (this->BackgroundCommandThread.joinable())
+				{
+					this->BackgroundCommandThread.join(); // reap a previously stopped executor
+				}
+				this->BackgroundCommandThreadRunning = true;
+				this->BackgroundCommandThread = std::thread(&Controller::backgroundCommandExecutionLoop, this);
+			}
+
+			this->BackgroundCommandQueue.push_back(backgroundCommand);
+			this->BackgroundCommandsInFlight++;
+			this->BackgroundCommandCondition.notify_one();
+		}
+
+		void Controller::backgroundCommandExecutionLoop()
+		{
+			std::unique_lock<std::mutex> backgroundLock(this->BackgroundCommandMutex);
+			while (this->BackgroundCommandThreadRunning)
+			{
+				if (this->BackgroundCommandQueue.empty())
+				{
+					this->BackgroundCommandCondition.wait(backgroundLock);
+					continue;
+				}
+
+				BACKGROUND_COMMAND backgroundCommand = this->BackgroundCommandQueue.front();
+				this->BackgroundCommandQueue.pop_front();
+
+				// Execute without the lock so new work can queue up (and the stop path can run)
+				backgroundLock.unlock();
+
+				COMPLETION_QUEUE_ENTRY completionQueueEntryToPost = { 0 };
+				auto itr = this->AdminCommandCallers.find(backgroundCommand.Command.DWord0Breakdown.OPC);
+				if (itr != this->AdminCommandCallers.end())
+				{
+					NVMeCaller caller = itr->second;
+					(this->*caller)(backgroundCommand.Command, completionQueueEntryToPost);
+				}
+				else
+				{
+					// shouldExecuteInBackground() only matches registered opcodes, so this shouldn't happen
+					completionQueueEntryToPost.SC = constants::status::codes::generic::INVALID_COMMAND_OPCODE;
+					completionQueueEntryToPost.DNR = 1;
+				}
+
+				// Hold the completion back for the opcode's modeled device latency (if any)
+				UINT_64 modeledLatencyMicroseconds = 0;
+				bool useModeledLatency = applyModeledLatency(true, backgroundCommand.Command.DWord0Breakdown.OPC, modeledLatencyMicroseconds);
+
+				postCompletion(*backgroundCommand.CompletionQueue, completionQueueEntryToPost, &backgroundCommand.Command, backgroundCommand.RingCompletionDoorbell);
+
+				auto completionTime = std::chrono::steady_clock::now();
+				UINT_64 latencyMicroseconds = std::chrono::duration_cast<std::chrono::microseconds>(completionTime - backgroundCommand.PickupTime).count();
+				if (useModeledLatency)
 				{
-					LOG_INFO("That was an NVM command!");
+					latencyMicroseconds = modeledLatencyMicroseconds; // a virtual clock delay took no wall time
+				}
+				recordCommandPerformance(backgroundCommand.SubmissionQueueId, true, backgroundCommand.Command.DWord0Breakdown.OPC, latencyMicroseconds,
+					backgroundCommand.Command.getTransferSizeBytes(true, DEFAULT_SECTOR_SIZE));
 
-					// AdminCommandCallers goes from OpCode to Function to call. 
-					//  All functions to call must have the same parameters and return value (no return since they are voids)
-					auto itr = this->NVMCommandCallers.find(command->DWord0Breakdown.OPC);
-					if (itr != this->NVMCommandCallers.end())
-					{
-						NVMeCaller caller = itr->second;
-						(this->*caller)(*command, completionQueueEntryToPost);
-					}
-					else
-					{
-						// We don't have handling for this command
-						LOG_INFO("Unknown NVM command recv'd by the controller.");
-						completionQueueEntryToPost.SC = constants::status::codes::generic::INVALID_COMMAND_OPCODE; // Unsupported Opcode
-						completionQueueEntryToPost.DNR = 1;                                                        // Do not retry
-					}
+				std::shared_ptr<tracing::CommandTracer> tracer;
+				{
+					std::lock_guard<std::mutex> tracerLock(this->CommandTracerMutex);
+					tracer = this->CommandTracer;
+				}
+				if (tracer)
+				{
+					tracer->recordCommand(backgroundCommand.Command, completionQueueEntryToPost, backgroundCommand.SubmissionQueueId, backgroundCommand.PickupTime, completionTime);
+				}
+
+				backgroundLock.lock();
+				this->BackgroundCommandsInFlight--;
+			}
+		}
+
+		void Controller::stopBackgroundCommandThread()
+		{
+			{
+				std::lock_guard<std::mutex> backgroundLock(this->BackgroundCommandMutex);
+				if (!this->BackgroundCommandThreadRunning && !this->BackgroundCommandThread.joinable())
+				{
+					return; // never started
 				}
+				this->BackgroundCommandThreadRunning = false;
+
+				// Anything still queued gets dropped; the command being executed finishes first
+				this->BackgroundCommandsInFlight -= this->BackgroundCommandQueue.size();
+				this->BackgroundCommandQueue.clear();
+				this->BackgroundCommandCondition.notify_one();
+			}
+
+			if (this->BackgroundCommandThread.joinable())
+			{
+				this->BackgroundCommandThread.join();
 			}
-			postCompletion(*theCompletionQueue, completionQueueEntryToPost, command);
 		}
 
 		Queue* Controller::getQueueWithId(std::vector<Queue*> &queues, UINT_16 id)
@@ -282,8 +1173,11 @@ namespace cnvme
 			return nullptr;
 		}
 
-		void Controller::postCompletion(Queue &completionQueue, COMPLETION_QUEUE_ENTRY completionEntry, NVME_COMMAND* command)
+		void Controller::postCompletion(Queue &completionQueue, COMPLETION_QUEUE_ENTRY completionEntry, NVME_COMMAND* command, bool ringDoorbell)
 		{
+			// Queue workers can post completions concurrently; the phase tag map and CQ memory need serialization
+			std::lock_guard<std::mutex> postLock(this->PostCompletionMutex);
+
 			COMPLETION_QUEUE_ENTRY* completionQueueList = (COMPLETION_QUEUE_ENTRY*)MEMORY_ADDRESS_TO_8POINTER(completionQueue.getMemoryAddress());
 			ASSERT_IF(completionQueueList == nullptr, "completionQueueList cannot be NULL");
 			LOG_INFO("About to post completion to queue " + std::to_string(completionQueue.getQueueId()) + ". Head (just before moving): " +
@@ -327,13 +1221,70 @@ namespace cnvme
 
 			completionQueue.incrementAndGetHeadCloserToTail(); // Move up CQ head
 
-			// ring doorbell after placing data in completion queue.
+			// ring doorbell after placing data in completion queue (unless the caller is coalescing a batch).
+			if (ringDoorbell)
+			{
+				UINT_16* dbell = completionQueue.getDoorbell();
+				dbell[0] = completionQueue.getHeadPointer();
+			}
+
+			// the entry is visible in CQ memory: fire the queue's interrupt vector to wake blocked waiters
+			this->fireCompletionInterrupt(completionQueue.getQueueId());
+		}
+
+		UINT_64 Controller::waitForCompletionInterrupt(UINT_16 completionQueueId, UINT_64 lastSeenInterruptCount, UINT_32 timeoutInMilliseconds)
+		{
+			std::unique_lock<std::mutex> interruptLock(this->CompletionInterruptMutex);
+			this->CompletionInterruptCondition.wait_for(interruptLock, std::chrono::milliseconds(timeoutInMilliseconds), [&]
+			{
+				return this->CompletionInterruptCounts[completionQueueId] != lastSeenInterruptCount;
+			});
+			return this->CompletionInterruptCounts[completionQueueId];
+		}
+
+		UINT_64 Controller::getCompletionInterruptCount(UINT_16 completionQueueId)
+		{
+			std::lock_guard<std::mutex> interruptLock(this->CompletionInterruptMutex);
+			return this->CompletionInterruptCounts[completionQueueId];
+		}
+
+		UINT_64 Controller::waitForAnyCompletionInterrupt(UINT_64 lastSeenInterruptCount, UINT_32 timeoutInMilliseconds)
+		{
+			std::unique_lock<std::mutex> interruptLock(this->CompletionInterruptMutex);
+			this->CompletionInterruptCondition.wait_for(interruptLock, std::chrono::milliseconds(timeoutInMilliseconds), [&]
+			{
+				return this->TotalCompletionInterruptCount != lastSeenInterruptCount;
+			});
+			return this->TotalCompletionInterruptCount;
+		}
+
+		UINT_64 Controller::getTotalCompletionInterruptCount()
+		{
+			std::lock_guard<std::mutex> interruptLock(this->CompletionInterruptMutex);
+			return this->TotalCompletionInterruptCount;
+		}
+
+		void Controller::fireCompletionInterrupt(UINT_16 completionQueueId)
+		{
+			{
+				std::lock_guard<std::mutex> interruptLock(this->CompletionInterruptMutex);
+				this->CompletionInterruptCounts[completionQueueId]++;
+				this->TotalCompletionInterruptCount++;
+			}
+			this->CompletionInterruptCondition.notify_all();
+		}
+
+		void Controller::ringCompletionQueueDoorbell(Queue &completionQueue)
+		{
 			UINT_16* dbell = completionQueue.getDoorbell();
 			dbell[0] = completionQueue.getHeadPointer();
 		}
 
 		bool Controller::isValidCommandIdentifier(UINT_16 commandId, UINT_16 submissionQueueId)
 		{
+			// Queue workers can check CIDs concurrently; the shared map needs serialization
+			std::lock_guard<std::mutex> postLock(this->PostCompletionMutex);
+
 			if (SubmissionQueueIdToCommandIdentifiers.find(submissionQueueId) == SubmissionQueueIdToCommandIdentifiers.end())
 			{
 				// SQID hasn't been used yet?
@@ -363,6 +1314,12 @@ namespace cnvme
 			return false;
 		}
 
+		void Controller::invalidateIdentifyResponseCache()
+		{
+			std::lock_guard<std::mutex> cacheLock(this->IdentifyResponseCacheMutex);
+			this->IdentifyResponseCache.clear();
+		}
+
 		void Controller::resetIdentifyController()
 		{
 			auto pciRegistersWrapper = this->getPCIExpressRegisters();
@@ -409,15 +1366,18 @@ namespace cnvme
 			// Optional Commands Supported
 			this->IdentifyController.FormatNVMSupported = true;
 			this->IdentifyController.FirmwareDownloadAndCommitSupported = true;
+			this->IdentifyController.DoorbellBufferConfigSupported = true;
 
 			// Optional Features Supported
 			this->IdentifyController.FirmwareActivationWithoutResetSupported = true;
 			this->IdentifyController.NumberOfFirmwareSlots = constants::commands::identify::sizes::MAX_FW_SLOTS; // Support 7 FW slots
 
 			// Also I'm not setting the power state to anything. It lets us get away with all 0s for not reported. Wow.
+
+			this->invalidateIdentifyResponseCache();
 		}
 
-		Payload Controller::getNamespaceListFromMap(std::map<UINT_32, ns::Namespace> namespaceMap, UINT_32 startingNsid, COMPLETION_QUEUE_ENTRY& completionQueueEntryToPost)
+		Payload Controller::getNamespaceListFromMap(const std::map<UINT_32, ns::Namespace> &namespaceMap, UINT_32 startingNsid, COMPLETION_QUEUE_ENTRY& completionQueueEntryToPost)
 		{
 			Payload transferPayload(constants::commands::identify::sizes::MAX_NSID_IN_NAMESPACE_LIST * sizeof(UINT_32));
 
@@ -496,6 +1456,18 @@ namespace cnvme
 				PRP prps(nvmeCommand.DPTR.DPTR1, nvmeCommand.DPTR.DPTR2, (size_t)transferSizeInBytes, this->getControllerRegisters()->getMemoryPageSize());
 				auto transferData = prps.getPayloadCopy();
 
+				// Persistent mode: talk to the long lived worker over pipes instead of
+				// spawning a process and rewriting the files for every single command.
+				if (this->CommandResponseApiPersistent)
+				{
+					std::lock_guard<std::mutex> crapiLock(this->CommandResponseApiMutex);
+					if (this->startCommandResponseWorkerIfNeeded())
+					{
+						return this->exchangeWithCommandResponseWorker(nvmeCommand, completionQueueEntry, SQID, prps, transferData);
+					}
+					LOG_ERROR("Couldn't start the persistent CRAPI worker. Falling back to the file protocol.");
+				}
+
 				// Write command binary
 				// These brackets force the ofstreams to go out of scope and get closed.
 				{
@@ -550,6 +1522,177 @@ namespace cnvme
 			return false;
 		}
 
+#ifndef _WIN32
+		namespace
+		{
+			/// <summary>
+			/// Writes exactly length bytes to the given fd. Returns false on any failure.
+			/// </summary>
+			bool writeAllToFd(int fd, const void* buffer, size_t length)
+			{
+				const BYTE* cursor = (const BYTE*)buffer;
+				while (length > 0)
+				{
+					ssize_t bytesWritten = write(fd, cursor, length);
+					if (bytesWritten <= 0)
+					{
+						return false;
+					}
+					cursor += bytesWritten;
+					length -= bytesWritten;
+				}
+				return true;
+			}
+
+			/// <summary>
+			/// Reads exactly length bytes from the given fd. Returns false on EOF or any failure.
+			/// </summary>
+			bool readAllFromFd(int fd, void* buffer, size_t length)
+			{
+				BYTE* cursor = (BYTE*)buffer;
+				while (length > 0)
+				{
+					ssize_t bytesRead = read(fd, cursor, length);
+					if (bytesRead <= 0)
+					{
+						return false;
+					}
+					cursor += bytesRead;
+					length -= bytesRead;
+				}
+				return true;
+			}
+		}
+#endif // !_WIN32
+
+		bool Controller::startCommandResponseWorkerIfNeeded()
+		{
+#ifdef _WIN32
+			// No fork/pipes here. The file protocol keeps working on Windows.
+			return false;
+#else // Linux
+			if (this->CommandResponseWorkerPid > 0)
+			{
+				return true;
+			}
+
+			int toWorker[2] = { -1, -1 };
+			int fromWorker[2] = { -1, -1 };
+			if (pipe(toWorker) != 0)
+			{
+				return false;
+			}
+			if (pipe(fromWorker) != 0)
+			{
+				close(toWorker[0]);
+				close(toWorker[1]);
+				return false;
+			}
+
+			int workerPid = fork();
+			if (workerPid < 0)
+			{
+				close(toWorker[0]);
+				close(toWorker[1]);
+				close(fromWorker[0]);
+				close(fromWorker[1]);
+				return false;
+			}
+
+			if (workerPid == 0)
+			{
+				// child: wire the pipes to stdin/stdout and become the worker
+				dup2(toWorker[0], STDIN_FILENO);
+				dup2(fromWorker[1], STDOUT_FILENO);
+				close(toWorker[0]);
+				close(toWorker[1]);
+				close(fromWorker[0]);
+				close(fromWorker[1]);
+				execl("/bin/sh", "sh", "-c", ("\"" + this->CommandResponseApiFilePath + "\" --persistent").c_str(), (char*)NULL);
+				_exit(127); // exec failed
+			}
+
+			// parent: keep our ends, close the worker's
+			close(toWorker[0]);
+			close(fromWorker[1]);
+			this->CommandResponseWorkerStdinFd = toWorker[1];
+			this->CommandResponseWorkerStdoutFd = fromWorker[0];
+			this->CommandResponseWorkerPid = workerPid;
+
+			LOG_INFO("Started the persistent CRAPI worker (pid " + std::to_string(workerPid) + ")");
+			return true;
+#endif // _WIN32
+		}
+
+		void Controller::stopCommandResponseWorker()
+		{
+#ifndef _WIN32
+			if (this->CommandResponseWorkerPid > 0)
+			{
+				// EOF on stdin tells the worker to exit
+				close(this->CommandResponseWorkerStdinFd);
+				close(this->CommandResponseWorkerStdoutFd);
+				waitpid(this->CommandResponseWorkerPid, NULL, 0);
+
+				this->CommandResponseWorkerPid = 0;
+				this->CommandResponseWorkerStdinFd = -1;
+				this->CommandResponseWorkerStdoutFd = -1;
+			}
+#endif // !_WIN32
+		}
+
+		bool Controller::exchangeWithCommandResponseWorker(NVME_COMMAND& nvmeCommand, COMPLETION_QUEUE_ENTRY& completionQueueEntry, UINT_16 SQID, PRP& prps, Payload& transferData)
+		{
+#ifdef _WIN32
+			return false; // shouldn't get here: the worker never starts on Windows
+#else // Linux
+			UINT_64 dataSize = transferData.getSize();
+
+			bool sentOk = writeAllToFd(this->CommandResponseWorkerStdinFd, &SQID, sizeof(SQID)) &&
+				writeAllToFd(this->CommandResponseWorkerStdinFd, &dataSize, sizeof(dataSize)) &&
+				writeAllToFd(this->CommandResponseWorkerStdinFd, &nvmeCommand, sizeof(nvmeCommand)) &&
+				writeAllToFd(this->CommandResponseWorkerStdinFd, &completionQueueEntry, sizeof(completionQueueEntry)) &&
+				writeAllToFd(this->CommandResponseWorkerStdinFd, transferData.getBuffer(), (size_t)dataSize);
+
+			// read the complete response before deciding anything, so the stream stays framed
+			UINT_8 returnCode = 0;
+			NVME_COMMAND returnedCommand = { 0 };
+			COMPLETION_QUEUE_ENTRY returnedCompletion = { 0 };
+			bool receivedOk = sentOk &&
+				readAllFromFd(this->CommandResponseWorkerStdoutFd, &returnCode, sizeof(returnCode)) &&
+				readAllFromFd(this->CommandResponseWorkerStdoutFd, &returnedCommand, sizeof(returnedCommand)) &&
+				readAllFromFd(this->CommandResponseWorkerStdoutFd, &returnedCompletion, sizeof(returnedCompletion)) &&
+				readAllFromFd(this->CommandResponseWorkerStdoutFd, transferData.getBuffer(), (size_t)dataSize);
+
+			if (!receivedOk)
+			{
+				// the worker died mid-exchange. Reap it so a retry can fall back (or respawn).
+				this->stopCommandResponseWorker();
+				ASSERT("The persistent CRAPI worker's pipe broke mid-exchange");
+				return false; // Release: treat as not handled
+			}
+
+			switch (returnCode)
+			{
+			case constants::crapi::CRAPI_HANDLED:
+				break;
+			case constants::crapi::CNVME_HANDLED:
+				return false;
+			case constants::crapi::ASSERT_FROM_CRAPI:
+				ASSERT("CRAPI ASSERT: " + std::string((char*)transferData.getBuffer(), strnlen((char*)transferData.getBuffer(), transferData.getSize())));
+			default:
+				ASSERT("Unknown CRAPI return code: " + std::to_string(returnCode));
+			}
+
+			// Worker handled the command: take its command/completion/data back.
+			nvmeCommand = returnedCommand;
+			completionQueueEntry = returnedCompletion;
+			prps.placePayloadInExistingPRPs(transferData);
+
+			return true;
+#endif // _WIN32
+		}
+
 		void Controller::replaceRunningFirmwareWithOneInSlot(UINT_8 firmwareSlot)
 		{
 			this->FirmwareSlotInfo.AFI.ActiveFirmwareSlot = firmwareSlot;
@@ -559,6 +1702,7 @@ namespace cnvme
 			// The firmware revision/name is the last 8 bytes of the binary data.
 			std::string firmwareRevision(this->FirmwareSlotInfo.FRS[ZERO_BASED_FROM_ONE_BASED(firmwareSlot)], sizeof(this->FirmwareSlotInfo.FRS[ZERO_BASED_FROM_ONE_BASED(firmwareSlot)]));
 			memcpy_s(&this->IdentifyController.FR, sizeof(this->IdentifyController.FR), firmwareRevision.c_str(), firmwareRevision.size());
+			this->invalidateIdentifyResponseCache(); // the running FR just changed
 		}
 
 		NVME_CALLER_IMPLEMENTATION(adminIdentify)
@@ -569,6 +1713,20 @@ namespace cnvme
 			if (command.DPTR.DPTR1)
 			{
 				PRP prp(command.DPTR.DPTR1, command.DPTR.DPTR2, memoryPageSize, memoryPageSize);
+
+				// Identify data only changes on format/firmware/reset, so serve repeat
+				//  (CNS, NSID) asks from the cache instead of rebuilding the structures
+				std::pair<UINT_8, UINT_32> cacheKey((UINT_8)command.DW10_Identify.CNS, command.NSID);
+				{
+					std::lock_guard<std::mutex> cacheLock(this->IdentifyResponseCacheMutex);
+					auto cacheItr = this->IdentifyResponseCache.find(cacheKey);
+					if (cacheItr != this->IdentifyResponseCache.end())
+					{
+						prp.placePayloadInExistingPRPs(cacheItr->second);
+						return;
+					}
+				}
+
 				auto transferPayload = prp.getPayloadCopy();
 				transferPayload.clear();
 
@@ -643,6 +1801,10 @@ namespace cnvme
 
 				if (completionQueueEntryToPost.succeeded())
 				{
+					{
+						std::lock_guard<std::mutex> cacheLock(this->IdentifyResponseCacheMutex);
+						this->IdentifyResponseCache[cacheKey] = transferPayload;
+					}
 					prp.placePayloadInExistingPRPs(transferPayload);
 				}
 			}
@@ -705,7 +1867,11 @@ namespace cnvme
 				(UINT_16*)&(doorbells->CQHDBL), // doorbell
 				command.DPTR.DPTR1
 			);
-			this->ValidCompletionQueues.push_back(q);
+
+			{
+				std::lock_guard<std::mutex> queueLock(this->QueueCollectionMutex);
+				this->ValidCompletionQueues.push_back(q);
+			}
 
 			LOG_INFO("Held onto completion queue with an id of " + std::to_string(command.DW10_CreateIoQueue.QID));
 		}
@@ -777,11 +1943,21 @@ namespace cnvme
 				(UINT_16*)&(doorbells->CQHDBL), // doorbell
 				command.DPTR.DPTR1
 			);
-			this->ValidSubmissionQueues.push_back(subQ);
 
+			subQ->setPriority((UINT_8)command.DW11_CreateIoSubmissionQueue.QPRIO);
 			subQ->setMappedQueue(mappedCompletionQueue); // SQ -> CQ
 			mappedCompletionQueue->setMappedQueue(subQ); // CQ -> SQ
 
+			{
+				std::lock_guard<std::mutex> queueLock(this->QueueCollectionMutex);
+				this->ValidSubmissionQueues.push_back(subQ);
+			}
+
+			if (this->IoQueueWorkersEnabled)
+			{
+				startIoQueueWorker(command.DW10_CreateIoQueue.QID);
+			}
+
 			LOG_INFO("Held onto submission queue with an id of " + std::to_string(command.DW10_CreateIoQueue.QID));
 		}
 
@@ -828,14 +2004,21 @@ namespace cnvme
 				return;
 			}
 
+			// Stop the worker before freeing the queue it services
+			stopIoQueueWorker(command.DW10_DeleteIoQueue.QID);
+
 			// don't let the completion queue map here anymore
 			q->getMappedQueue()->setMappedQueue(nullptr);
 
+			// Remove from validity
+			{
+				std::lock_guard<std::mutex> queueLock(this->QueueCollectionMutex);
+				this->ValidSubmissionQueues.erase(std::remove(this->ValidSubmissionQueues.begin(), this->ValidSubmissionQueues.end(), q), this->ValidSubmissionQueues.end());
+			}
+
 			// free the memory!
 			delete q;
 
-			// Remove from validity
-			this->ValidSubmissionQueues.erase(std::remove(this->ValidSubmissionQueues.begin(), this->ValidSubmissionQueues.end(), q), this->ValidSubmissionQueues.end());
 			this->SubmissionQueueIdToCommandIdentifiers[command.DW10_DeleteIoQueue.QID].clear();
 		}
 
@@ -862,25 +2045,22 @@ namespace cnvme
 
 			if (command.DW10_FirmwareCommit.CA == REPLACE_IN_SLOT_NO_ACTIVATE || command.DW10_FirmwareCommit.CA == REPLACE_IN_SLOT_AND_ACTIVATE_ON_RESET)
 			{
-				UINT_64 currentDwOffset = 0;
-				Payload completeFirmwareBinary;
+				// The download path already landed every chunk in the arena, merged the
+				//  received extents, and checked the eye catcher as the data streamed in.
+				//  The image is contiguous exactly when one extent starting at 0 is left,
+				//  so committing is just bookkeeping - no walk of the image bytes.
+				UINT_64 imageSizeBytes = this->FirmwareDownloadDWordCount * sizeof(UINT_32);
 
-				// Check if this->FirmwareImageDWordOffsetToData is valid and contiguous.
-				for (auto &fwDwOffsetToData : this->FirmwareImageDWordOffsetToData)
+				if (this->FirmwareDownloadExtents.size() != 1 || this->FirmwareDownloadExtents.begin()->first != 0)
 				{
-					if (fwDwOffsetToData.first != currentDwOffset)
-					{
-						LOG_INFO("Attempted to commit a FW to a FW slot without a contiguous FW binary");
-						completionQueueEntryToPost.SCT = constants::status::types::COMMAND_SPECIFIC;
-						completionQueueEntryToPost.SC = constants::status::codes::specific::INVALID_FIRMWARE_IMAGE;
-						return;
-					}
-					currentDwOffset += fwDwOffsetToData.second.getSize() / sizeof(UINT_32);
-					completeFirmwareBinary.append(fwDwOffsetToData.second);
+					LOG_INFO("Attempted to commit a FW to a FW slot without a contiguous FW binary");
+					completionQueueEntryToPost.SCT = constants::status::types::COMMAND_SPECIFIC;
+					completionQueueEntryToPost.SC = constants::status::codes::specific::INVALID_FIRMWARE_IMAGE;
+					return;
 				}
 
-				if (completeFirmwareBinary.getSize() <  (sizeof(identify::structures::IDENTIFY_CONTROLLER::FR) + sizeof(FIRMWARE_EYE_CATCHER)) ||
-					memcmp(completeFirmwareBinary.getBuffer(), FIRMWARE_EYE_CATCHER, sizeof(FIRMWARE_EYE_CATCHER) != 0))
+				if (imageSizeBytes < (sizeof(identify::structures::IDENTIFY_CONTROLLER::FR) + sizeof(FIRMWARE_EYE_CATCHER)) ||
+					!this->FirmwareDownloadEyeCatcherValid)
 				{
 					LOG_INFO("Attempt to commit a FW to a slot with an invalid FW buffer");
 					completionQueueEntryToPost.SCT = constants::status::types::COMMAND_SPECIFIC;
@@ -890,7 +2070,7 @@ namespace cnvme
 
 				// Copy firmware name to FirmwareSlotInfo
 				memcpy_s(this->FirmwareSlotInfo.FRS[ZERO_BASED_FROM_ONE_BASED(firmwareSlot)], sizeof(this->FirmwareSlotInfo.FRS[ZERO_BASED_FROM_ONE_BASED(firmwareSlot)]),
-					completeFirmwareBinary.getBuffer() + completeFirmwareBinary.getSize() - sizeof(identify::structures::IDENTIFY_CONTROLLER::FR), sizeof(identify::structures::IDENTIFY_CONTROLLER::FR));
+					this->FirmwareDownloadArena.getBuffer() + imageSizeBytes - sizeof(identify::structures::IDENTIFY_CONTROLLER::FR), sizeof(identify::structures::IDENTIFY_CONTROLLER::FR));
 
 				if (command.DW10_FirmwareCommit.CA == REPLACE_IN_SLOT_AND_ACTIVATE_ON_RESET)
 				{
@@ -982,33 +2162,86 @@ namespace cnvme
 				}
 			}
 
-			// Clear all cached data on an offset of 0.
+			// Starting over at an offset of 0 drops any earlier download.
 			if (minOffsetInDwords == 0)
 			{
-				this->FirmwareImageDWordOffsetToData.clear();
+				this->clearFirmwareDownloadState();
+			}
+
+			// Check for overlapping range against the merged extents: only the extent at or
+			//  after this chunk and the one before it can possibly intersect it.
+			auto followingExtent = this->FirmwareDownloadExtents.lower_bound(minOffsetInDwords);
+			bool overlaps = (followingExtent != this->FirmwareDownloadExtents.end() && followingExtent->first < maxOffsetInDwords);
+			if (!overlaps && followingExtent != this->FirmwareDownloadExtents.begin())
+			{
+				auto precedingExtent = std::prev(followingExtent);
+				overlaps = (precedingExtent->first + precedingExtent->second > minOffsetInDwords);
+			}
+			if (overlaps)
+			{
+				completionQueueEntryToPost.SCT = constants::status::types::COMMAND_SPECIFIC;
+				completionQueueEntryToPost.SC = constants::status::codes::specific::OVERLAPPING_RANGE;
+				completionQueueEntryToPost.DNR = 1;
+				return;
 			}
 
-			// Check for overlapping range. 
-			for (auto &fwDwOffsetToPayload : this->FirmwareImageDWordOffsetToData)
+			// Land the chunk straight into the arena at its final spot. Growing geometrically
+			//  means a large image copies each byte once, not once per later chunk.
+			UINT_64 arenaByteOffset = (UINT_64)minOffsetInDwords * sizeof(UINT_32);
+			UINT_64 requiredArenaBytes = arenaByteOffset + transferBytes;
+			if (this->FirmwareDownloadArena.getSize() < requiredArenaBytes)
 			{
-				auto &dWordOffset = fwDwOffsetToPayload.first;
-				auto &payload = fwDwOffsetToPayload.second;
+				this->FirmwareDownloadArena.resize((size_t)std::max(requiredArenaBytes,
+					std::max((UINT_64)FIRMWARE_DOWNLOAD_ARENA_INITIAL_BYTES, (UINT_64)this->FirmwareDownloadArena.getSize() * 2)));
+			}
 
-				UINT_64 minCachedOffset = dWordOffset;
-				UINT_64 maxCachedOffset = dWordOffset + (payload.getSize() / sizeof(UINT_32));
+			PRP prps(command.DPTR.DPTR1, command.DPTR.DPTR2, (UINT_32)transferBytes, this->getControllerRegisters()->getMemoryPageSize());
+			Payload firmwareChunk = prps.getPayloadCopy();
+			memcpy_s(this->FirmwareDownloadArena.getBuffer() + arenaByteOffset, (size_t)transferBytes, firmwareChunk.getBuffer(), (size_t)transferBytes);
 
-				// If the range overlaps, fail the command now.
-				if ((minOffsetInDwords > minCachedOffset && minOffsetInDwords < maxCachedOffset) || (maxOffsetInDwords < maxCachedOffset && maxOffsetInDwords > minCachedOffset))
+			// Record the extent, merging with its neighbors. Out of order chunks just leave
+			//  more extents until the gaps between them fill in.
+			UINT_64 extentStart = minOffsetInDwords;
+			UINT_64 extentDWords = transferBytes / sizeof(UINT_32);
+			auto nextExtent = this->FirmwareDownloadExtents.find(maxOffsetInDwords);
+			if (nextExtent != this->FirmwareDownloadExtents.end())
+			{
+				extentDWords += nextExtent->second;
+				this->FirmwareDownloadExtents.erase(nextExtent);
+			}
+			if (extentStart != 0)
+			{
+				auto beforeExtent = this->FirmwareDownloadExtents.lower_bound(extentStart);
+				if (beforeExtent != this->FirmwareDownloadExtents.begin())
 				{
-					completionQueueEntryToPost.SCT = constants::status::types::COMMAND_SPECIFIC;
-					completionQueueEntryToPost.SC = constants::status::codes::specific::OVERLAPPING_RANGE;
-					completionQueueEntryToPost.DNR = 1;
-					return;
+					beforeExtent = std::prev(beforeExtent);
+					if (beforeExtent->first + beforeExtent->second == extentStart)
+					{
+						extentStart = beforeExtent->first;
+						extentDWords += beforeExtent->second;
+						this->FirmwareDownloadExtents.erase(beforeExtent);
+					}
 				}
 			}
+			this->FirmwareDownloadExtents[extentStart] = extentDWords;
+			this->FirmwareDownloadDWordCount = std::max(this->FirmwareDownloadDWordCount, maxOffsetInDwords);
 
-			PRP prps(command.DPTR.DPTR1, command.DPTR.DPTR2, (UINT_32)transferBytes, this->getControllerRegisters()->getMemoryPageSize());
-			this->FirmwareImageDWordOffsetToData[minOffsetInDwords] = prps.getPayloadCopy();
+			// Verify the eye catcher the moment the start of the image shows up, overlapping
+			//  validation with the transfer. A bad image still fails at Firmware Commit.
+			if (!this->FirmwareDownloadEyeCatcherChecked && minOffsetInDwords == 0 && transferBytes >= sizeof(FIRMWARE_EYE_CATCHER))
+			{
+				this->FirmwareDownloadEyeCatcherChecked = true;
+				this->FirmwareDownloadEyeCatcherValid = (memcmp(this->FirmwareDownloadArena.getBuffer(), FIRMWARE_EYE_CATCHER, sizeof(FIRMWARE_EYE_CATCHER)) == 0);
+			}
+		}
+
+		void Controller::clearFirmwareDownloadState()
+		{
+			this->FirmwareDownloadArena = Payload();
+			this->FirmwareDownloadExtents.clear();
+			this->FirmwareDownloadDWordCount = 0;
+			this->FirmwareDownloadEyeCatcherChecked = false;
+			this->FirmwareDownloadEyeCatcherValid = false;
 		}
 
 		NVME_CALLER_IMPLEMENTATION(adminFormatNvm)
@@ -1069,6 +2302,42 @@ namespace cnvme
 					break; // make sure we leave this loop now.
 				}
 			}
+
+			// The formats may have changed the namespaces' identify data (current LBA format, etc)
+			this->invalidateIdentifyResponseCache();
+		}
+
+		NVME_CALLER_IMPLEMENTATION(adminDoorbellBufferConfig)
+		{
+			UINT_64 memoryPageSize = ControllerRegisters->getMemoryPageSize();
+
+			// Both buffers are required, must be distinct, and must be page aligned
+			if (command.DPTR.DPTR1 == 0 || command.DPTR.DPTR2 == 0 || command.DPTR.DPTR1 == command.DPTR.DPTR2 ||
+				(command.DPTR.DPTR1 % memoryPageSize) != 0 || (command.DPTR.DPTR2 % memoryPageSize) != 0)
+			{
+				completionQueueEntryToPost.SC = constants::status::codes::generic::INVALID_FIELD_IN_COMMAND;
+				completionQueueEntryToPost.DNR = 1;
+				return;
+			}
+
+			UINT_32* shadowDoorbells = (UINT_32*)MEMORY_ADDRESS_TO_8POINTER(command.DPTR.DPTR1);
+			UINT_32* eventIdxs = (UINT_32*)MEMORY_ADDRESS_TO_8POINTER(command.DPTR.DPTR2);
+
+			// Seed every existing queue's slots with its current tail before the queue watchers
+			//  can see the buffers, so the switch-over doesn't look like a tail moving backwards.
+			{
+				std::lock_guard<std::mutex> queueLock(this->QueueCollectionMutex);
+				for (auto &validSubmissionQueue : this->ValidSubmissionQueues)
+				{
+					shadowDoorbells[validSubmissionQueue->getQueueId() * 2] = validSubmissionQueue->getTailPointer();
+					eventIdxs[validSubmissionQueue->getQueueId() * 2] = validSubmissionQueue->getTailPointer();
+				}
+			}
+
+			this->EventIdxs.store(eventIdxs, std::memory_order_release);
+			this->ShadowDoorbells.store(shadowDoorbells, std::memory_order_release);
+
+			LOG_INFO("Doorbell Buffer Config accepted: submission tails now come from the shadow buffer");
 		}
 
 		NVME_CALLER_IMPLEMENTATION(adminKeepAlive)
@@ -1076,6 +2345,82 @@ namespace cnvme
 			// nop. We do nothing here.
 		}
 
+		NVME_CALLER_IMPLEMENTATION(adminGetLogPage)
+		{
+			UINT_32 memoryPageSize = ControllerRegisters->getMemoryPageSize();
+
+			// Do we have a PRP?
+			if (!command.DPTR.DPTR1)
+			{
+				completionQueueEntryToPost.SC = constants::status::codes::generic::PRP_OFFSET_INVALID;
+				completionQueueEntryToPost.DNR = 1;
+				return;
+			}
+
+			// NUMD is 0-based and in dwords, split across DW10/DW11
+			UINT_64 numberOfDwords = (((UINT_64)command.DW11_GetLogPage.NUMDU << 16) | command.DW10_GetLogPage.NUMDL) + 1;
+			UINT_64 transferSizeInBytes = numberOfDwords * sizeof(UINT_32);
+
+			Payload logPayload;
+			switch (command.DW10_GetLogPage.LID)
+			{
+			case constants::commands::log_page_ids::SMART_HEALTH_INFORMATION:
+				logPayload = this->getSmartHealthLogPage();
+				break;
+			case constants::commands::log_page_ids::FIRMWARE_SLOT_INFORMATION:
+				logPayload = Payload((BYTE*)&this->FirmwareSlotInfo, sizeof(this->FirmwareSlotInfo));
+				break;
+			case constants::commands::log_page_ids::VENDOR_PERFORMANCE:
+				logPayload = this->getPerformanceLogPage();
+				break;
+			default:
+				completionQueueEntryToPost.SC = constants::status::codes::generic::INVALID_FIELD_IN_COMMAND;
+				completionQueueEntryToPost.DNR = 1;
+				return;
+			}
+
+			// give the host exactly what it asked for (zero padded if it asked past the end)
+			logPayload.resize((size_t)transferSizeInBytes);
+
+			PRP prp(command.DPTR.DPTR1, command.DPTR.DPTR2, (size_t)transferSizeInBytes, memoryPageSize);
+			prp.placePayloadInExistingPRPs(logPayload);
+		}
+
+		NVME_CALLER_IMPLEMENTATION(adminSetFeatures)
+		{
+			switch (command.DW10_SetFeatures.FID)
+			{
+			case constants::commands::features::ARBITRATION:
+				this->ArbitrationBurst = (UINT_8)command.DW11_Arbitration.AB;
+				this->LowPriorityWeight = (UINT_8)command.DW11_Arbitration.LPW;
+				this->MediumPriorityWeight = (UINT_8)command.DW11_Arbitration.MPW;
+				this->HighPriorityWeight = (UINT_8)command.DW11_Arbitration.HPW;
+				LOG_INFO("Set arbitration to AB=" + std::to_string(this->ArbitrationBurst) + " LPW=" + std::to_string(this->LowPriorityWeight) +
+					" MPW=" + std::to_string(this->MediumPriorityWeight) + " HPW=" + std::to_string(this->HighPriorityWeight));
+				break;
+			default:
+				completionQueueEntryToPost.DNR = 1; // Do Not Retry
+				completionQueueEntryToPost.SCT = constants::status::types::GENERIC_COMMAND;
+				completionQueueEntryToPost.SC = constants::status::codes::generic::INVALID_FIELD_IN_COMMAND;
+			}
+		}
+
+		NVME_CALLER_IMPLEMENTATION(adminGetFeatures)
+		{
+			switch (command.DW10_SetFeatures.FID)
+			{
+			case constants::commands::features::ARBITRATION:
+				// pack the feature's current value into DW0 the same way DW11 lays it out
+				completionQueueEntryToPost.DWord0 = ((UINT_32)this->HighPriorityWeight << 24) | ((UINT_32)this->MediumPriorityWeight << 16) |
+					((UINT_32)this->LowPriorityWeight << 8) | this->ArbitrationBurst;
+				break;
+			default:
+				completionQueueEntryToPost.DNR = 1; // Do Not Retry
+				completionQueueEntryToPost.SCT = constants::status::types::GENERIC_COMMAND;
+				completionQueueEntryToPost.SC = constants::status::codes::generic::INVALID_FIELD_IN_COMMAND;
+			}
+		}
+
 		NVME_CALLER_IMPLEMENTATION(nvmFlush)
 		{
 			// TODO: See if we can push this code higher up as it applies to all NVM commands.
@@ -1125,10 +2470,8 @@ namespace cnvme
 			// Do we have a PRP?
 			if (command.DPTR.DPTR1)
 			{
-				Payload readData;
-				completionQueueEntryToPost = namespacePair->second.read(command, readData);
-				PRP prps(command.DPTR.DPTR1, command.DPTR.DPTR2, readData.getSize(), ControllerRegisters->getMemoryPageSize());
-				prps.placePayloadInExistingPRPs(readData);
+				UINT_32 memoryPageSize = ControllerRegisters->getMemoryPageSize();
+				completionQueueEntryToPost = namespacePair->second.read(command, memoryPageSize);
 			}
 			else
 			{
@@ -1168,6 +2511,10 @@ namespace cnvme
 		{
 			LOG_INFO("Recv'd a controllerResetCallback request.");
 
+			// Finish/drop background work and stop the workers before their queues go away
+			stopBackgroundCommandThread();
+			stopAllIoQueueWorkers();
+
 			for (size_t i = ValidSubmissionQueues.size() - 1; i != -1; i--)
 			{
 				if (ValidSubmissionQueues[i]->getQueueId() != ADMIN_QUEUE_ID)
@@ -1192,8 +2539,12 @@ namespace cnvme
 			// Clear phase tags.
 			this->QueueToPhaseTag.clear();
 
+			// Forget the host's shadow doorbell buffers; Doorbell Buffer Config must be re-sent.
+			this->ShadowDoorbells.store(nullptr, std::memory_order_release);
+			this->EventIdxs.store(nullptr, std::memory_order_release);
+
 			// Clear FW Image Download Cache
-			this->FirmwareImageDWordOffsetToData.clear();
+			this->clearFirmwareDownloadState();
 
 			// If a FW slot is given to update to on reset, do it now.
 			if (this->FirmwareSlotInfo.AFI.FirmwareSlotForNextControllerReset)
@@ -1205,16 +2556,61 @@ namespace cnvme
 		void Controller::waitForChangeLoop()
 		{
 #ifndef SINGLE_THREADED
+			ensureWatchersStarted();
 			DoorbellWatcher.waitForFlip();
 #else
 			checkForChanges();
 #endif
 		}
 
-		void Controller::setCommandResponseFilePath(const std::string filePath)
+		void Controller::step()
+		{
+			ensureWatchersStarted(); // no-op when SINGLE_THREADED (step's usual home)
+
+			// Bottom up: PCIe config space first, then BAR0, then the queues
+			PCIExpressRegisters->waitForChangeLoop();
+			ControllerRegisters->waitForChangeLoop();
+			this->waitForChangeLoop();
+		}
+
+		void Controller::notifyChange()
+		{
+#ifndef SINGLE_THREADED
+			ensureWatchersStarted();
+			DoorbellWatcher.wakeUp();
+
+			// Wake the IO queue workers too (if there are any)
+			{
+				std::lock_guard<std::mutex> queueLock(this->QueueCollectionMutex);
+				for (auto &itr : this->IoQueueWorkers)
+				{
+					itr.second->wakeUp();
+				}
+			}
+#else
+			checkForChanges();
+#endif
+		}
+
+		void Controller::setCommandResponseFilePath(const std::string filePath, bool persistentWorker)
 		{
 			LOG_INFO("Set CRAPI-F to " + filePath);
+
+			std::lock_guard<std::mutex> crapiLock(this->CommandResponseApiMutex);
+
+			// a running worker belongs to the old path
+			this->stopCommandResponseWorker();
+
 			this->CommandResponseApiFilePath = filePath;
+			this->CommandResponseApiPersistent = persistentWorker;
+
+#ifdef _WIN32
+			if (persistentWorker)
+			{
+				LOG_ERROR("Persistent CRAPI workers aren't supported here. Using the file protocol.");
+				this->CommandResponseApiPersistent = false;
+			}
+#endif // _WIN32
 		}
 
 		const std::map<UINT_8, NVMeCaller> Controller::AdminCommandCallers = {
@@ -1222,11 +2618,15 @@ namespace cnvme
 			{ cnvme::constants::opcodes::admin::CREATE_IO_SUBMISSION_QUEUE, &cnvme::controller::Controller::adminCreateIoSubmissionQueue},
 			{ cnvme::constants::opcodes::admin::DELETE_IO_COMPLETION_QUEUE, &cnvme::controller::Controller::adminDeleteIoCompletionQueue},
 			{ cnvme::constants::opcodes::admin::DELETE_IO_SUBMISSION_QUEUE, &cnvme::controller::Controller::adminDeleteIoSubmissionQueue},
+			{ cnvme::constants::opcodes::admin::DOORBELL_BUFFER_CONFIG, &cnvme::controller::Controller::adminDoorbellBufferConfig},
 			{ cnvme::constants::opcodes::admin::FIRMWARE_COMMIT, &cnvme::controller::Controller::adminFirmwareCommit},
 			{ cnvme::constants::opcodes::admin::FIRMWARE_IMAGE_DOWNLOAD, &cnvme::controller::Controller::adminFirmwareImageDownload},
 			{ cnvme::constants::opcodes::admin::FORMAT_NVM, &cnvme::controller::Controller::adminFormatNvm},
+			{ cnvme::constants::opcodes::admin::GET_FEATURES, &cnvme::controller::Controller::adminGetFeatures},
+			{ cnvme::constants::opcodes::admin::GET_LOG_PAGE, &cnvme::controller::Controller::adminGetLogPage},
 			{ cnvme::constants::opcodes::admin::IDENTIFY, &cnvme::controller::Controller::adminIdentify},
-			{ cnvme::constants::opcodes::admin::KEEP_ALIVE, &cnvme::controller::Controller::adminKeepAlive}
+			{ cnvme::constants::opcodes::admin::KEEP_ALIVE, &cnvme::controller::Controller::adminKeepAlive},
+			{ cnvme::constants::opcodes::admin::SET_FEATURES, &cnvme::controller::Controller::adminSetFeatures}
 		};
 
 		const std::map<UINT_8, NVMeCaller> Controller::NVMCommandCallers = {
@@ -31,11 +31,16 @@ Controller.h - A header file for the NVMe Controller
 #include "LogPages.h"
 #include "Namespace.h"
 #include "PCIe.h"
+#include "PRP.h"
+#include "Timing.h"
+#include "Trace.h"
 #include "Types.h"
 #include "Queue.h"
 
 #define ADMIN_QUEUE_ID 0
 #define FIRMWARE_EYE_CATCHER "cNVMe"
+#define FIRMWARE_DOWNLOAD_ARENA_INITIAL_BYTES (1024 * 1024) // first allocation for a streamed firmware image
+#define IO_QUEUE_PIPELINE_MAX_STAGED 64 // commands an IO queue's execute stage will hold before the fetch stage runs them inline
 #define MAX_COMMAND_IDENTIFIER 0xFFFF
 #define MAX_SUBMISSION_QUEUES  0xFFFF
 
@@ -59,6 +64,14 @@ namespace cnvme
 			/// </summary>
 			Controller();
 
+			/// <summary>
+			/// Constructor that runs this controller's doorbell and register watchers on a
+			/// shared pool instead of dedicated threads, so many controllers in one process
+			/// keep thread count O(cores). Pass nullptr for dedicated threads.
+			/// </summary>
+			/// <param name="watcherPool">Pool for the watchers, or nullptr</param>
+			Controller(cnvme::WatcherPool* watcherPool);
+
 			/// <summary>
 			/// Destructor for the controller
 			/// </summary>
@@ -88,11 +101,125 @@ namespace cnvme
 			/// </summary>
 			void waitForChangeLoop();
 
+			/// <summary>
+			/// Wakes the doorbell watcher right away instead of waiting for its next poll.
+			/// Called when someone (like the Driver) knows they just rang a doorbell.
+			/// </summary>
+			void notifyChange();
+
+			/// <summary>
+			/// Synchronously runs one full service pass: PCIe registers, controller
+			/// registers, then the doorbells/queues. This is the driving API for the
+			/// SINGLE_THREADED profile, where no watcher threads exist: a frontend that
+			/// pokes registers or doorbells directly calls step() to have the controller
+			/// observe the writes, and one command costs one function call chain. In
+			/// threaded builds it returns once each watcher has completed a pass.
+			/// </summary>
+			void step();
+
+			/// <summary>
+			/// Blocks until an interrupt fires for the given completion queue, the given timeout
+			/// elapses, or the interrupt count already differs from lastSeenInterruptCount.
+			/// This emulates a per-queue MSI-X vector: the driver blocks here instead of
+			/// spin-polling the completion queue memory.
+			/// </summary>
+			/// <param name="completionQueueId">Completion queue to wait on</param>
+			/// <param name="lastSeenInterruptCount">The caller's last value from getCompletionInterruptCount()</param>
+			/// <param name="timeoutInMilliseconds">Max time to block</param>
+			/// <returns>The completion queue's current interrupt count</returns>
+			UINT_64 waitForCompletionInterrupt(UINT_16 completionQueueId, UINT_64 lastSeenInterruptCount, UINT_32 timeoutInMilliseconds);
+
+			/// <summary>
+			/// Gets the number of interrupts fired so far for the given completion queue
+			/// </summary>
+			/// <param name="completionQueueId">Completion queue to check</param>
+			/// <returns>Interrupt count</returns>
+			UINT_64 getCompletionInterruptCount(UINT_16 completionQueueId);
+
+			/// <summary>
+			/// Blocks until an interrupt fires for any completion queue, the given timeout
+			/// elapses, or the total interrupt count already differs from lastSeenInterruptCount.
+			/// </summary>
+			/// <param name="lastSeenInterruptCount">The caller's last value from getTotalCompletionInterruptCount()</param>
+			/// <param name="timeoutInMilliseconds">Max time to block</param>
+			/// <returns>The current total interrupt count</returns>
+			UINT_64 waitForAnyCompletionInterrupt(UINT_64 lastSeenInterruptCount, UINT_32 timeoutInMilliseconds);
+
+			/// <summary>
+			/// Gets the number of interrupts fired so far across all completion queues
+			/// </summary>
+			/// <returns>Total interrupt count</returns>
+			UINT_64 getTotalCompletionInterruptCount();
+
+			/// <summary>
+			/// Returns the number of long-running admin commands queued or executing in the background
+			/// </summary>
+			/// <returns>Count of background commands not yet completed</returns>
+			size_t getBackgroundCommandsInFlight();
+
+			/// <summary>
+			/// Builds the vendor performance log page (header plus one entry per submission
+			/// queue that has completed commands). This is the direct C++ accessor; hosts can
+			/// fetch the same data with Get Log Page LID 0xC0.
+			/// </summary>
+			/// <returns>Payload with a PERFORMANCE_LOG_HEADER and QUEUE_PERFORMANCE_STATS entries</returns>
+			Payload getPerformanceLogPage();
+
+			/// <summary>
+			/// Builds the SMART / Health Information log page from the live counters.
+			/// This is the direct C++ accessor; hosts can fetch the same data with
+			/// Get Log Page LID 0x02.
+			/// </summary>
+			/// <returns>Payload with a SMART_HEALTH_INFO structure</returns>
+			Payload getSmartHealthLogPage();
+
 			/// <summary>
 			/// Sets the CRAPI-F
 			/// </summary>
 			/// <param name="filePath">path to file</param>
-			void setCommandResponseFilePath(const std::string filePath);
+			/// <param name="persistentWorker">If true, keep the handler running as a persistent worker
+			/// process and exchange commands over pipes instead of spawning it (and rewriting the
+			/// files) per command. Falls back to the file protocol if the worker can't be used.</param>
+			void setCommandResponseFilePath(const std::string filePath, bool persistentWorker = false);
+
+			/// <summary>
+			/// Enables/disables servicing each IO submission queue with its own worker thread.
+			/// When enabled, the DoorbellWatcher only services the admin queue (keeping admin ordering),
+			/// and IO queues process commands in parallel. Disabled by default.
+			/// </summary>
+			/// <param name="enabled">true to give each IO queue its own worker</param>
+			void setIoQueueWorkersEnabled(bool enabled);
+
+			/// <summary>
+			/// Starts recording every completed command to a binary trace ring file.
+			/// Replaces any trace already in progress.
+			/// </summary>
+			/// <param name="traceFilePath">File to write the trace into</param>
+			/// <param name="recordCapacity">Ring capacity in records</param>
+			void enableCommandTracing(const std::string& traceFilePath, UINT_64 recordCapacity);
+
+			/// <summary>
+			/// Stops recording and finalizes the trace file
+			/// </summary>
+			void disableCommandTracing();
+
+			/// <summary>
+			/// Attaches (or, given null, detaches) a timing engine. With one attached, the
+			/// controller holds each completion back for the opcode's modeled latency (see
+			/// Timing.h). The caller keeps a reference too, for configuring latencies and
+			/// driving a virtual clock.
+			/// </summary>
+			/// <param name="timingEngine">The engine to model latency with, or null for none</param>
+			void setTimingEngine(const std::shared_ptr<timing::TimingEngine>& timingEngine);
+
+			/// <summary>
+			/// Returns the controller to (close to) its just-built state so it can be handed
+			/// out again (see ControllerPool): disables it through the normal reset path,
+			/// drops every queue, and puts the identify/namespace/accounting state back to
+			/// the constructor's defaults. The register spaces and watcher threads stay up,
+			/// which is the point - a recycled controller skips construction cost entirely.
+			/// </summary>
+			void recycle();
 
 		private:
 
@@ -128,17 +255,158 @@ namespace cnvme
 			/// </summary>
 			std::map<UINT_16, std::set<UINT_16>> SubmissionQueueIdToCommandIdentifiers;
 
+			/// <summary>
+			/// If true, each IO submission queue gets serviced by its own worker thread
+			/// </summary>
+			std::atomic<bool> IoQueueWorkersEnabled;
+
+			/// <summary>
+			/// Map from submission queue id to the worker thread servicing that queue
+			/// </summary>
+			std::map<UINT_16, LoopingThread*> IoQueueWorkers;
+
+			/// <summary>
+			/// True once ensureWatchersStarted() has kicked off the register/doorbell watchers
+			/// </summary>
+			std::atomic<bool> WatchersStarted;
+
+			/// <summary>
+			/// Starts the register and doorbell watchers if they haven't started yet. The
+			/// constructor defers them (register setup happens inline), so bring-up costs no
+			/// watcher handshakes; the first register handout or change wait/notify pays it.
+			/// </summary>
+			void ensureWatchersStarted();
+
+			/// <summary>
+			/// Protects the ValidSubmissionQueues/ValidCompletionQueues/IoQueueWorkers containers
+			/// </summary>
+			std::mutex QueueCollectionMutex;
+
+			/// <summary>
+			/// Serializes completion posting and CID tracking across queue workers
+			/// </summary>
+			std::mutex PostCompletionMutex;
+
 			/// <summary>
 			/// Function to be called in loop looking for changes
 			/// </summary>
 			void checkForChanges();
 
+			/// <summary>
+			/// Checks the given submission queue's doorbell and processes any new commands on it
+			/// </summary>
+			/// <param name="submissionQueue">The submission queue to service</param>
+			/// <param name="doorbells">Pointer to the start of the queue doorbells</param>
+			/// <param name="maxCommands">Max commands to process this call. 0 means no limit.</param>
+			/// <returns>Number of commands processed</returns>
+			UINT_32 serviceSubmissionQueue(Queue* submissionQueue, controller::registers::QUEUE_DOORBELLS* doorbells, UINT_32 maxCommands = 0);
+
+			/// <summary>
+			/// Services all submission queues using weighted round robin with urgent priority class
+			/// arbitration (NVMe spec section 4.13.2): admin and urgent queues are strict priority,
+			/// high/medium/low queues share service per their Set Features (Arbitration) weights,
+			/// fetched in bursts of up to the arbitration burst per queue turn.
+			/// </summary>
+			/// <param name="doorbells">Pointer to the queue doorbells</param>
+			void arbitrateAndServiceSubmissionQueues(controller::registers::QUEUE_DOORBELLS* doorbells);
+
+			/// <summary>
+			/// A single iteration of an IO queue worker: finds the queue and services it
+			/// </summary>
+			/// <param name="queueId">The submission queue id this worker owns</param>
+			void ioQueueWorkerIteration(UINT_16 queueId);
+
+			/// <summary>
+			/// Spins up a worker thread for the given IO submission queue (if workers are enabled)
+			/// </summary>
+			/// <param name="queueId">The submission queue id</param>
+			void startIoQueueWorker(UINT_16 queueId);
+
+			/// <summary>
+			/// Stops and deletes the worker thread for the given IO submission queue (if one exists)
+			/// </summary>
+			/// <param name="queueId">The submission queue id</param>
+			void stopIoQueueWorker(UINT_16 queueId);
+
+			/// <summary>
+			/// Stops and deletes all IO queue worker threads
+			/// </summary>
+			void stopAllIoQueueWorkers();
+
+			/// <summary>
+			/// A command the fetch/decode stage of an IO queue's pipeline has handed off,
+			/// waiting for (or in) the execute stage
+			/// </summary>
+			typedef struct PIPELINED_COMMAND
+			{
+				NVME_COMMAND Command;								// Copy of the command (the SQ slot gets reused)
+				Queue* CompletionQueue;								// Where to post the completion
+				UINT_16 SubmissionQueueId;							// Queue the command came from (for accounting)
+				std::chrono::steady_clock::time_point PickupTime;	// When the fetch stage picked the command up
+			} PIPELINED_COMMAND;
+
+			/// <summary>
+			/// The execute stage of one IO queue's two stage pipeline. The queue's worker thread
+			/// is the fetch/decode stage: it pulls the command off the queue, validates the CID
+			/// and stages the command here, then goes straight back for the next one while this
+			/// stage's thread runs the execute and complete phases. That overlaps command N+1's
+			/// fetch/decode (and doorbell bookkeeping) with command N's execute. A single stage
+			/// thread per queue keeps execution in submission order.
+			/// </summary>
+			typedef struct IO_QUEUE_PIPELINE
+			{
+				std::deque<PIPELINED_COMMAND> StagedCommands;	// Decoded commands waiting to execute (guarded by Mutex)
+				std::mutex Mutex;								// Guards StagedCommands / Running
+				std::condition_variable Condition;				// Wakes the execute stage for new work or a stop
+				std::thread ExecuteThread;						// Runs pipelineExecuteLoop
+				bool Running;									// False once the pipeline is draining to stop
+			} IO_QUEUE_PIPELINE;
+
+			/// <summary>
+			/// Map from submission queue id to that queue's pipeline execute stage.
+			/// Guarded by QueueCollectionMutex; lifetime matches IoQueueWorkers.
+			/// </summary>
+			std::map<UINT_16, std::shared_ptr<IO_QUEUE_PIPELINE>> IoQueuePipelines;
+
+			/// <summary>
+			/// Hands a decoded NVM command to its queue's pipeline execute stage. Returns false
+			/// (so the caller executes inline) if the queue has no pipeline or the stage is
+			/// full or stopping.
+			/// </summary>
+			/// <param name="submissionQueue">The queue the command came from</param>
+			/// <param name="command">The decoded command (copied out of the SQ slot)</param>
+			/// <param name="completionQueue">Where the completion should post</param>
+			/// <param name="pickupTime">When the command was picked up (for accounting)</param>
+			/// <returns>true if the execute stage took the command</returns>
+			bool stagePipelinedCommand(Queue& submissionQueue, const NVME_COMMAND& command, Queue* completionQueue, std::chrono::steady_clock::time_point pickupTime);
+
+			/// <summary>
+			/// Loop run by a pipeline's execute stage thread: runs staged commands in order
+			/// through their execute and complete phases. Drains before exiting.
+			/// </summary>
+			/// <param name="pipeline">The pipeline this thread serves</param>
+			void pipelineExecuteLoop(std::shared_ptr<IO_QUEUE_PIPELINE> pipeline);
+
+			/// <summary>
+			/// The execute and complete phases for one staged command: NVM dispatch, completion
+			/// posting (with doorbell ring) and performance/trace accounting
+			/// </summary>
+			/// <param name="pipelinedCommand">The staged command</param>
+			void processPipelinedCommand(PIPELINED_COMMAND& pipelinedCommand);
+
+			/// <summary>
+			/// Signals the given queue's pipeline execute stage to stop, lets it drain and joins it
+			/// </summary>
+			/// <param name="queueId">The submission queue id</param>
+			void stopIoQueuePipeline(UINT_16 queueId);
+
 			/// <summary>
 			/// This call will take the command of the given submission queue, process the command and
 			/// pass back completion via the completion queue doorbell.
 			/// </summary>
 			/// <param name="submissionQueue">The internal submission queue object for this command</param>
-			void processCommandAndPostCompletion(Queue &submissionQueue);
+			/// <param name="ringCompletionDoorbell">If false, skip the completion doorbell write (the caller rings once per batch)</param>
+			void processCommandAndPostCompletion(Queue &submissionQueue, bool ringCompletionDoorbell = true);
 
 			/// <summary>
 			/// Returns a Queue matching the given id
@@ -156,7 +424,15 @@ namespace cnvme
 			/// <param name="completionQueue">Queue to post to</param>
 			/// <param name="completionEntry">Entry to post to the queue</param>
 			/// <param name="command">The NVMe Command that is having its completion posted</param>
-			void postCompletion(Queue &completionQueue, command::COMPLETION_QUEUE_ENTRY completionEntry, command::NVME_COMMAND* command);
+			/// <param name="ringDoorbell">If false, skip the doorbell write (the caller rings once per batch)</param>
+			void postCompletion(Queue &completionQueue, command::COMPLETION_QUEUE_ENTRY completionEntry, command::NVME_COMMAND* command, bool ringDoorbell = true);
+
+			/// <summary>
+			/// Writes the given completion queue's doorbell from its current head pointer.
+			/// Used to coalesce the doorbell write to one per batch of posted completions.
+			/// </summary>
+			/// <param name="completionQueue">Queue whose doorbell should be written</param>
+			void ringCompletionQueueDoorbell(Queue &completionQueue);
 
 			/// <summary>
 			/// Returns true if the command id 
@@ -198,7 +474,7 @@ namespace cnvme
 			/// <param name="startingNsid">NSID to start with</param>
 			/// <param name="completionQueueEntryToPost">CQE for an identify call to get this data</param>
 			/// <returns>Payload</returns>
-			Payload getNamespaceListFromMap(std::map<UINT_32, ns::Namespace> namespaceMap, UINT_32 startingNsid, COMPLETION_QUEUE_ENTRY& completionQueueEntryToPost);
+			Payload getNamespaceListFromMap(const std::map<UINT_32, ns::Namespace> &namespaceMap, UINT_32 startingNsid, COMPLETION_QUEUE_ENTRY& completionQueueEntryToPost);
 
 			/// <summary>
 			/// Gets a map of all namespaces (active or inactive)
@@ -215,6 +491,31 @@ namespace cnvme
 			/// <returns>true if CRAPI handled the command</returns>
 			bool handledByCommandResponseApiFile(NVME_COMMAND& nvmeCommand, COMPLETION_QUEUE_ENTRY& completionQueueEntry, UINT_16 SQID);
 
+			/// <summary>
+			/// Starts the persistent CRAPI worker process if it isn't running yet.
+			/// The worker is launched once with --persistent and spoken to over its stdin/stdout.
+			/// </summary>
+			/// <returns>true if the worker is running</returns>
+			bool startCommandResponseWorkerIfNeeded();
+
+			/// <summary>
+			/// Stops the persistent CRAPI worker. Closing its pipes gives it EOF, which tells it to exit.
+			/// </summary>
+			void stopCommandResponseWorker();
+
+			/// <summary>
+			/// Sends one command to the persistent CRAPI worker and reads back its verdict.
+			/// Frame out: SQID, data size, NVMe command, completion entry, data.
+			/// Frame back: return code (see constants::crapi), NVMe command, completion entry, data.
+			/// </summary>
+			/// <param name="nvmeCommand">The command being processed</param>
+			/// <param name="completionQueueEntry">Completion entry to (possibly) post back</param>
+			/// <param name="SQID">Submission queue the command came from</param>
+			/// <param name="prps">PRPs for the command's data transfer</param>
+			/// <param name="transferData">Copy of the command's data to hand to the worker</param>
+			/// <returns>true if the worker handled the command</returns>
+			bool exchangeWithCommandResponseWorker(NVME_COMMAND& nvmeCommand, COMPLETION_QUEUE_ENTRY& completionQueueEntry, UINT_16 SQID, PRP& prps, Payload& transferData);
+
 			/// <summary>
 			/// Updates the running firmware to the one with the given slot
 			/// </summary>
@@ -222,9 +523,39 @@ namespace cnvme
 			void replaceRunningFirmwareWithOneInSlot(UINT_8 firmwareSlot);
 
 			/// <summary>
-			/// Used to store the data downloaded by Firmware Image Download
+			/// Arena the streamed firmware image lands in. Each Firmware Image Download
+			/// chunk is copied straight to its DWord offset (out of order is fine), and the
+			/// arena grows geometrically so large images don't get recopied per chunk.
+			/// </summary>
+			Payload FirmwareDownloadArena;
+
+			/// <summary>
+			/// DWord extents received so far, as offset to DWord count. Adjacent extents
+			/// get merged as chunks arrive, so the image is contiguous exactly when one
+			/// extent starting at offset 0 remains. Makes Firmware Commit O(1).
+			/// </summary>
+			std::map<UINT_64, UINT_64> FirmwareDownloadExtents;
+
+			/// <summary>
+			/// One past the highest DWord received; the image's size once it is contiguous
 			/// </summary>
-			std::map<UINT_32, Payload> FirmwareImageDWordOffsetToData;
+			UINT_64 FirmwareDownloadDWordCount;
+
+			/// <summary>
+			/// True once the start of the image has arrived and the eye catcher was compared
+			/// </summary>
+			bool FirmwareDownloadEyeCatcherChecked;
+
+			/// <summary>
+			/// Result of the eye catcher compare. Checked during download so commit doesn't
+			/// have to walk the image; the failure still surfaces on Firmware Commit.
+			/// </summary>
+			bool FirmwareDownloadEyeCatcherValid;
+
+			/// <summary>
+			/// Drops all streamed firmware download state (arena, extents, eye catcher check)
+			/// </summary>
+			void clearFirmwareDownloadState();
 
 			/// <summary>
 			/// Map from the admin command opcode to the function that processes it
@@ -241,6 +572,277 @@ namespace cnvme
 			/// </summary>
 			std::string CommandResponseApiFilePath;
 
+			/// <summary>
+			/// True if the CRAPI handler should be kept running as a persistent worker process
+			/// </summary>
+			bool CommandResponseApiPersistent;
+
+			/// <summary>
+			/// Pid of the persistent CRAPI worker. 0 when not running. (POSIX only)
+			/// </summary>
+			int CommandResponseWorkerPid;
+
+			/// <summary>
+			/// Write end of the pipe to the worker's stdin. -1 when not running. (POSIX only)
+			/// </summary>
+			int CommandResponseWorkerStdinFd;
+
+			/// <summary>
+			/// Read end of the pipe from the worker's stdout. -1 when not running. (POSIX only)
+			/// </summary>
+			int CommandResponseWorkerStdoutFd;
+
+			/// <summary>
+			/// Serializes exchanges with the CRAPI worker (queue workers can process commands concurrently)
+			/// </summary>
+			std::mutex CommandResponseApiMutex;
+
+			/// <summary>
+			/// Fires the (emulated) interrupt vector for the given completion queue.
+			/// Called after a completion is visible in the queue's memory.
+			/// </summary>
+			/// <param name="completionQueueId">Completion queue whose vector should fire</param>
+			void fireCompletionInterrupt(UINT_16 completionQueueId);
+
+			/// <summary>
+			/// Per completion queue count of interrupts fired (the emulated MSI-X vectors)
+			/// </summary>
+			std::map<UINT_16, UINT_64> CompletionInterruptCounts;
+
+			/// <summary>
+			/// Count of interrupts fired across all completion queues
+			/// </summary>
+			UINT_64 TotalCompletionInterruptCount;
+
+			/// <summary>
+			/// Guards CompletionInterruptCounts
+			/// </summary>
+			std::mutex CompletionInterruptMutex;
+
+			/// <summary>
+			/// Signaled whenever any completion queue's interrupt fires
+			/// </summary>
+			std::condition_variable CompletionInterruptCondition;
+
+			/// <summary>
+			/// Arbitration Burst: max commands fetched from one submission queue per arbitration
+			/// turn, as 2^n. constants::commands::arbitration::AB_UNLIMITED means no limit.
+			/// </summary>
+			UINT_8 ArbitrationBurst;
+
+			/// <summary>
+			/// Weight (0-based) for high priority submission queues under WRR arbitration
+			/// </summary>
+			UINT_8 HighPriorityWeight;
+
+			/// <summary>
+			/// Weight (0-based) for medium priority submission queues under WRR arbitration
+			/// </summary>
+			UINT_8 MediumPriorityWeight;
+
+			/// <summary>
+			/// Weight (0-based) for low priority submission queues under WRR arbitration
+			/// </summary>
+			UINT_8 LowPriorityWeight;
+
+			/// <summary>
+			/// Live (atomic) counters behind one QUEUE_PERFORMANCE_STATS entry
+			/// </summary>
+			typedef struct ATOMIC_QUEUE_PERFORMANCE_COUNTERS
+			{
+				std::atomic<UINT_64> CommandsCompleted;
+				std::atomic<UINT_64> BytesTransferred;
+				std::atomic<UINT_64> TotalLatencyMicroseconds;
+				std::atomic<UINT_64> MaxLatencyMicroseconds;
+				std::atomic<UINT_64> LatencyHistogram[PERFORMANCE_LOG_LATENCY_BUCKETS];
+			} ATOMIC_QUEUE_PERFORMANCE_COUNTERS;
+
+			/// <summary>
+			/// Live counters behind the SMART / Health Information log. Each counter sits on
+			/// its own cache line so commands completing on different threads don't bounce
+			/// a shared line while bumping different counters.
+			/// </summary>
+			typedef struct ATOMIC_SMART_COUNTERS
+			{
+				alignas(64) std::atomic<UINT_64> BytesRead;
+				alignas(64) std::atomic<UINT_64> BytesWritten;
+				alignas(64) std::atomic<UINT_64> HostReadCommands;
+				alignas(64) std::atomic<UINT_64> HostWriteCommands;
+				alignas(64) std::atomic<UINT_64> BusyTimeMicroseconds;
+			} ATOMIC_SMART_COUNTERS;
+
+			/// <summary>
+			/// The live SMART counters for this controller
+			/// </summary>
+			ATOMIC_SMART_COUNTERS SmartCounters;
+
+			/// <summary>
+			/// Records one completed command into the performance counters.
+			/// The counter updates are lock-free; the mutex is only taken to find or create
+			/// the queue's counter block.
+			/// </summary>
+			/// <param name="submissionQueueId">Queue the command came from</param>
+			/// <param name="adminCommand">True if this was an admin command</param>
+			/// <param name="opcode">The command's opcode</param>
+			/// <param name="latencyMicroseconds">Doorbell-pickup to completion-post latency</param>
+			/// <param name="bytesTransferred">Bytes moved by the command</param>
+			void recordCommandPerformance(UINT_16 submissionQueueId, bool adminCommand, UINT_8 opcode, UINT_64 latencyMicroseconds, UINT_64 bytesTransferred);
+
+			/// <summary>
+			/// Performance counters per submission queue
+			/// </summary>
+			std::map<UINT_16, std::shared_ptr<ATOMIC_QUEUE_PERFORMANCE_COUNTERS>> SubmissionQueueIdToPerformanceCounters;
+
+			/// <summary>
+			/// Guards the shape of SubmissionQueueIdToPerformanceCounters (not the counters)
+			/// </summary>
+			std::mutex PerformanceCountersMutex;
+
+			/// <summary>
+			/// Records completed commands when tracing is enabled (null otherwise)
+			/// </summary>
+			std::shared_ptr<tracing::CommandTracer> CommandTracer;
+
+			/// <summary>
+			/// Guards swapping CommandTracer (recording goes through a grabbed shared_ptr)
+			/// </summary>
+			std::mutex CommandTracerMutex;
+
+			/// <summary>
+			/// Models device latency before completions post when attached (null otherwise)
+			/// </summary>
+			std::shared_ptr<timing::TimingEngine> TimingEngine;
+
+			/// <summary>
+			/// Guards swapping TimingEngine (delays go through a grabbed shared_ptr)
+			/// </summary>
+			std::mutex TimingEngineMutex;
+
+			/// <summary>
+			/// Blocks for the opcode's modeled latency if a timing engine is attached.
+			/// Called right before a completion posts.
+			/// </summary>
+			/// <param name="adminCommand">true if the command was an admin command</param>
+			/// <param name="opcode">The command's opcode</param>
+			/// <param name="modeledLatencyMicroseconds">Gets the sampled latency</param>
+			/// <returns>true if the modeled latency should be accounted instead of the measured one</returns>
+			bool applyModeledLatency(bool adminCommand, UINT_8 opcode, UINT_64& modeledLatencyMicroseconds);
+
+			/// <summary>
+			/// Host-provided shadow doorbell buffer (Doorbell Buffer Config). Slot q * 2 holds
+			/// the host's latest submission tail for queue q; once this is set the queue watchers
+			/// trust it over the real doorbell registers. Null until the host sends the command.
+			/// </summary>
+			std::atomic<UINT_32*> ShadowDoorbells;
+
+			/// <summary>
+			/// Host-provided EventIdx buffer. Slot q * 2 is the submission tail we have consumed
+			/// through; the host only writes the real doorbell when its tail crosses this value.
+			/// </summary>
+			std::atomic<UINT_32*> EventIdxs;
+
+			/// <summary>
+			/// Commands completed per admin opcode
+			/// </summary>
+			std::atomic<UINT_64> AdminOpcodeCounts[256];
+
+			/// <summary>
+			/// Commands completed per NVM opcode
+			/// </summary>
+			std::atomic<UINT_64> NvmOpcodeCounts[256];
+
+			/// <summary>
+			/// When this controller was constructed, for the log page's up-time field
+			/// </summary>
+			std::chrono::steady_clock::time_point ControllerStartTime;
+
+			/// <summary>
+			/// Prebuilt Identify responses keyed by (CNS, NSID), so identify storms don't rebuild
+			/// the same structures per command (guarded by IdentifyResponseCacheMutex)
+			/// </summary>
+			std::map<std::pair<UINT_8, UINT_32>, Payload> IdentifyResponseCache;
+
+			/// <summary>
+			/// Guards IdentifyResponseCache
+			/// </summary>
+			std::mutex IdentifyResponseCacheMutex;
+
+			/// <summary>
+			/// Drops every cached Identify response. Called when the underlying data actually
+			/// changes (format, firmware activation, identify reset, controller reset).
+			/// </summary>
+			void invalidateIdentifyResponseCache();
+
+			/// <summary>
+			/// Everything needed to execute an admin command off the doorbell thread and post
+			/// its completion later
+			/// </summary>
+			typedef struct BACKGROUND_COMMAND
+			{
+				NVME_COMMAND Command;								// Copy of the command (the SQ slot gets reused)
+				Queue* CompletionQueue;								// Where to post the completion
+				UINT_16 SubmissionQueueId;							// Queue the command came from (for accounting)
+				bool RingCompletionDoorbell;						// Whether to ring the CQ doorbell on post
+				std::chrono::steady_clock::time_point PickupTime;	// When the doorbell thread picked the command up
+			} BACKGROUND_COMMAND;
+
+			/// <summary>
+			/// True if the given admin command is long-running and should execute in the background
+			/// instead of stalling the doorbell thread
+			/// </summary>
+			/// <param name="command">The command in question</param>
+			/// <returns>true to hand the command to the background executor</returns>
+			bool shouldExecuteInBackground(const NVME_COMMAND& command);
+
+			/// <summary>
+			/// Hands a command to the background executor (starting its thread if needed)
+			/// </summary>
+			/// <param name="backgroundCommand">The command and its completion plumbing</param>
+			void queueBackgroundCommand(const BACKGROUND_COMMAND& backgroundCommand);
+
+			/// <summary>
+			/// Loop run by the background executor thread: executes queued commands and posts
+			/// their completions
+			/// </summary>
+			void backgroundCommandExecutionLoop();
+
+			/// <summary>
+			/// Stops the background executor thread, finishing the command it is on and dropping
+			/// anything still queued. Used on reset and teardown.
+			/// </summary>
+			void stopBackgroundCommandThread();
+
+			/// <summary>
+			/// Commands waiting for the background executor (guarded by BackgroundCommandMutex)
+			/// </summary>
+			std::deque<BACKGROUND_COMMAND> BackgroundCommandQueue;
+
+			/// <summary>
+			/// Number of background commands queued or executing. Separate from the deque so a
+			/// command still counts while the executor is working on it.
+			/// </summary>
+			size_t BackgroundCommandsInFlight;
+
+			/// <summary>
+			/// Guards BackgroundCommandQueue / BackgroundCommandsInFlight / the thread state
+			/// </summary>
+			std::mutex BackgroundCommandMutex;
+
+			/// <summary>
+			/// Wakes the background executor when work arrives or it should stop
+			/// </summary>
+			std::condition_variable BackgroundCommandCondition;
+
+			/// <summary>
+			/// The background executor thread (started lazily on the first background command)
+			/// </summary>
+			std::thread BackgroundCommandThread;
+
+			/// <summary>
+			/// True while the background executor thread should keep running
+			/// </summary>
+			bool BackgroundCommandThreadRunning;
+
 			/// <summary>
 			/// Holds info for LID=3 / Firmware Slot Info
 			/// </summary>
@@ -286,11 +888,31 @@ namespace cnvme
 			/// </summary>
 			NVME_CALLER_HEADER(adminFormatNvm);
 
+			/// <summary>
+			/// Handling for the NVMe Doorbell Buffer Config Command
+			/// </summary>
+			NVME_CALLER_HEADER(adminDoorbellBufferConfig);
+
 			/// <summary>
 			/// Handling for the NVMe Keep Alive Command
 			/// </summary>
 			NVME_CALLER_HEADER(adminKeepAlive);
 
+			/// <summary>
+			/// Set Features (only the Arbitration feature is supported so far)
+			/// </summary>
+			NVME_CALLER_HEADER(adminSetFeatures);
+
+			/// <summary>
+			/// Get Features (only the Arbitration feature is supported so far)
+			/// </summary>
+			NVME_CALLER_HEADER(adminGetFeatures);
+
+			/// <summary>
+			/// Get Log Page (firmware slot info and the vendor performance log)
+			/// </summary>
+			NVME_CALLER_HEADER(adminGetLogPage);
+
 			/// <summary>
 			/// Handling for the NVM Flush command
 			/// </summary>
@@ -0,0 +1,81 @@
+/*
+###########################################################################################
+// cNVMe - An Open Source NVMe Device Simulation - MIT License
+// Copyright 2018 - Intel Corporation
+
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+// INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+// PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+// LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT
+// OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+// OTHER DEALINGS IN THE SOFTWARE.
+############################################################################################
+ControllerPool.cpp - An implementation file for the ControllerPool class
+*/
+
+#include "ControllerPool.h"
+
+namespace cnvme
+{
+	namespace controller
+	{
+		ControllerPool::ControllerPool()
+		{
+			this->OutstandingCount = 0;
+		}
+
+		ControllerPool::~ControllerPool()
+		{
+			std::lock_guard<std::mutex> poolLock(this->Mutex);
+			ASSERT_IF(this->OutstandingCount != 0, "A ControllerPool was destroyed with controllers still out. Release them first: they lean on the pool's watcher threads.");
+
+			for (Controller* parkedController : this->ParkedControllers)
+			{
+				delete parkedController;
+			}
+			this->ParkedControllers.clear();
+		}
+
+		Controller* ControllerPool::acquire()
+		{
+			std::lock_guard<std::mutex> poolLock(this->Mutex);
+
+			Controller* controller = nullptr;
+			if (!this->ParkedControllers.empty())
+			{
+				controller = this->ParkedControllers.back();
+				this->ParkedControllers.pop_back();
+			}
+			else
+			{
+				controller = new Controller(&this->Watchers);
+			}
+
+			this->OutstandingCount++;
+			return controller;
+		}
+
+		void ControllerPool::release(Controller* controller)
+		{
+			ASSERT_IF(controller == nullptr, "Can't release a null controller");
+
+			// Recycle outside the lock: a disable handshake can take a few watcher passes
+			controller->recycle();
+
+			std::lock_guard<std::mutex> poolLock(this->Mutex);
+			ASSERT_IF(this->OutstandingCount == 0, "release() without a matching acquire()");
+			this->ParkedControllers.push_back(controller);
+			this->OutstandingCount--;
+		}
+	}
+}
@@ -0,0 +1,94 @@
+/*
+###########################################################################################
+// cNVMe - An Open Source NVMe Device Simulation - MIT License
+// Copyright 2018 - Intel Corporation
+
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+// INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+// PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+// LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT
+// OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+// OTHER DEALINGS IN THE SOFTWARE.
+############################################################################################
+ControllerPool.h - A header file for the ControllerPool class
+*/
+
+#pragma once
+
+#include "Controller.h"
+#include "WatcherPool.h"
+
+namespace cnvme
+{
+	namespace controller
+	{
+		/// <summary>
+		/// ControllerPool hands out ready Controller instances and recycles released ones
+		/// instead of tearing them down, for hosts (fuzzers, test matrices) that churn
+		/// through controllers faster than they can be built. A reused controller is a
+		/// parked-instance pop; only the first acquire of each instance pays construction.
+		/// All of the pool's controllers share one WatcherPool, so instance count doesn't
+		/// multiply watcher threads. Release every acquired controller before the pool
+		/// goes away: they lean on its watcher threads.
+		/// </summary>
+		class ControllerPool
+		{
+		public:
+			/// <summary>
+			/// Creates an empty pool (controllers get built on demand)
+			/// </summary>
+			ControllerPool();
+
+			/// <summary>
+			/// Destructor. Deletes the parked controllers. Asserts if any are still out.
+			/// </summary>
+			~ControllerPool();
+
+			/// <summary>
+			/// Hands out a controller: a recycled parked one when available, a freshly
+			/// built one otherwise. The pool keeps ownership; give it back via release().
+			/// </summary>
+			/// <returns>A controller in its just-built state</returns>
+			Controller* acquire();
+
+			/// <summary>
+			/// Takes a controller back, recycles it to its just-built state and parks it
+			/// for the next acquire(). Nothing of the old user may still be in flight.
+			/// </summary>
+			/// <param name="controller">The controller to give back</param>
+			void release(Controller* controller);
+
+		private:
+
+			/// <summary>
+			/// Watcher threads shared by every controller this pool builds
+			/// </summary>
+			cnvme::WatcherPool Watchers;
+
+			/// <summary>
+			/// Recycled controllers waiting to be handed out again (guarded by Mutex)
+			/// </summary>
+			std::vector<Controller*> ParkedControllers;
+
+			/// <summary>
+			/// Number of controllers currently handed out
+			/// </summary>
+			size_t OutstandingCount;
+
+			/// <summary>
+			/// Guards ParkedControllers / OutstandingCount
+			/// </summary>
+			std::mutex Mutex;
+		};
+	}
+}
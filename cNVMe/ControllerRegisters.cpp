@@ -226,19 +226,26 @@ namespace cnvme
 				Controller = nullptr;
 			}
 
-			ControllerRegisters::ControllerRegisters(UINT_64 memoryLocation) : ControllerRegisters::ControllerRegisters()
+			ControllerRegisters::ControllerRegisters(UINT_64 memoryLocation) : ControllerRegisters(memoryLocation, nullptr)
+			{
+			}
+
+			ControllerRegisters::ControllerRegisters(UINT_64 memoryLocation, cnvme::controller::Controller* controller) : ControllerRegisters(memoryLocation, controller, nullptr)
+			{
+			}
+
+			ControllerRegisters::ControllerRegisters(UINT_64 memoryLocation, cnvme::controller::Controller* controller, cnvme::WatcherPool* watcherPool) : ControllerRegisters::ControllerRegisters()
 			{
 				ControllerRegistersPointer = (CONTROLLER_REGISTERS*)memoryLocation;
 				controllerReset();
 
 #ifndef SINGLE_THREADED
+				// controllerReset() above brought the registers up inline, so the watcher can
+				//  start lazily on the first change wait/notify instead of handshaking here
 				RegisterWatcher = LoopingThread([&] {ControllerRegisters::checkForChanges(); }, CHANGE_CHECK_SLEEP_MS);
-				RegisterWatcher.start();
+				RegisterWatcher.setPool(watcherPool);
 #endif
-			}
 
-			ControllerRegisters::ControllerRegisters(UINT_64 memoryLocation, cnvme::controller::Controller* controller) : ControllerRegisters(memoryLocation)
-			{
 				Controller = controller;
 			}
 
@@ -278,15 +285,34 @@ namespace cnvme
 					+ sizeof(registers::CONTROLLER_REGISTERS));
 			}
 
+			void ControllerRegisters::startRegisterWatcher()
+			{
+#ifndef SINGLE_THREADED
+				std::lock_guard<std::mutex> startLock(WatcherStartMutex);
+				RegisterWatcher.start(); // no-op if already running
+#endif
+			}
+
 			void ControllerRegisters::waitForChangeLoop()
 			{
 #ifndef SINGLE_THREADED
+				startRegisterWatcher();
 				RegisterWatcher.waitForFlip();
 #else
 				checkForChanges();
 #endif
 			}
 
+			void ControllerRegisters::notifyChange()
+			{
+#ifndef SINGLE_THREADED
+				startRegisterWatcher();
+				RegisterWatcher.wakeUp();
+#else
+				checkForChanges();
+#endif
+			}
+
 			UINT_32 ControllerRegisters::getMemoryPageSize()
 			{
 				CONTROLLER_REGISTERS* controllerRegisters = getControllerRegisters();
@@ -314,6 +340,7 @@ namespace cnvme
 
 					ControllerRegistersPointer->CAP.MPSMAX = 0; // 4096 max
 					ControllerRegistersPointer->CAP.MPSMIN = 0; // 4096 min
+					ControllerRegistersPointer->CAP.AMS = 1;    // Weighted round robin with urgent supported
 					ControllerRegistersPointer->CAP.CSS = 1;    // NVM Command set
 					ControllerRegistersPointer->CAP.NSSRS = 1;  // NVM Subsystem Reset Supported
 					ControllerRegistersPointer->CAP.TO = 32;    // Worst case of 16 seconds
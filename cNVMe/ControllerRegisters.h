@@ -246,6 +246,15 @@ namespace cnvme
 				/// <param name="controller">Poi8nter to the controller</param>
 				ControllerRegisters(UINT_64 memoryLocation, cnvme::controller::Controller* controller);
 
+				/// <summary>
+				/// Like the above, though the register watcher runs on a shared pool instead
+				/// of a dedicated thread. Pass nullptr for the dedicated-thread behavior.
+				/// </summary>
+				/// <param name="memoryLocation">Location of BAR0</param>
+				/// <param name="controller">Pointer to the controller</param>
+				/// <param name="watcherPool">Pool for the register watcher, or nullptr</param>
+				ControllerRegisters(UINT_64 memoryLocation, cnvme::controller::Controller* controller, cnvme::WatcherPool* watcherPool);
+
 				/// <summary>
 				/// Destructor
 				/// </summary>
@@ -268,6 +277,20 @@ namespace cnvme
 				/// </summary>
 				void waitForChangeLoop();
 
+				/// <summary>
+				/// Wakes the register watcher right away instead of waiting for its next poll.
+				/// Called when someone (like the Driver) knows they just wrote a register.
+				/// </summary>
+				void notifyChange();
+
+				/// <summary>
+				/// Starts the register watcher thread if it isn't already running. The
+				/// constructor defers this so bring-up doesn't pay a watcher handshake;
+				/// the first change wait/notify (or the owning controller's first register
+				/// handout) starts it.
+				/// </summary>
+				void startRegisterWatcher();
+
 				/// <summary>
 				/// Gets the memory page size via CC.MPS
 				/// </summary>
@@ -286,6 +309,11 @@ namespace cnvme
 				/// </summary>
 				LoopingThread RegisterWatcher;
 
+				/// <summary>
+				/// Serializes lazy RegisterWatcher starts
+				/// </summary>
+				std::mutex WatcherStartMutex;
+
 				/// <summary>
 				/// The controller that owns this.
 				/// </summary>
@@ -25,17 +25,29 @@ DLL.cpp - Implementation file for DLL exports
 
 #ifdef DLL_BUILD
 #include "DLL.h"
+#include "LoopingThread.h"
 
 using namespace cnvme;
 static driver::Driver* staticDriver;
+static LoopingThread* staticCommandRingThread;
 
 typedef enum StatusCodes {
 	NO_ERRORS,
 	ALREADY_INITIALIZED,
 	ALREADY_UNINITIALIZED,
 	CONTROLLER_RESET_FAILED,
+	INVALID_BATCH_BUFFER,
+	COMMAND_RING_ALREADY_RUNNING,
+	COMMAND_RING_NOT_RUNNING,
+	INVALID_COMMAND_RING_GEOMETRY,
 } StatusCodes;
 
+// Command ring slot states. The state word leads each slot; ownership passes
+//  host -> library at SUBMITTED and back to the host at COMPLETED.
+#define COMMAND_RING_SLOT_HOST_OWNED 0
+#define COMMAND_RING_SLOT_SUBMITTED 1
+#define COMMAND_RING_SLOT_COMPLETED 2
+
 char* getCharStarOfStringToSendOut(std::string retStr)
 {
 	// Add 1 for \0
@@ -68,6 +80,86 @@ long SendCommand(UINT_8* driverCommandData, size_t driverCommandDataLength)
 	return ALREADY_UNINITIALIZED;
 }
 
+long SendCommands(UINT_8* driverCommandsData, size_t driverCommandsDataLength, UINT_32 commandCount)
+{
+	if (!staticDriver)
+	{
+		return ALREADY_UNINITIALIZED;
+	}
+
+	size_t offset = 0;
+	for (UINT_32 commandIndex = 0; commandIndex < commandCount; commandIndex++)
+	{
+		if (offset + sizeof(driver::DRIVER_COMMAND) > driverCommandsDataLength)
+		{
+			return INVALID_BATCH_BUFFER; // walked off the end of the buffer
+		}
+
+		auto pDriverCommand = (driver::PDRIVER_COMMAND)(driverCommandsData + offset);
+		size_t commandSize = sizeof(driver::DRIVER_COMMAND) + pDriverCommand->TransferDataSize;
+		if (offset + commandSize > driverCommandsDataLength)
+		{
+			return INVALID_BATCH_BUFFER;
+		}
+
+		staticDriver->sendCommand(driverCommandsData + offset, commandSize);
+		offset += commandSize;
+	}
+
+	return NO_ERRORS;
+}
+
+long StartCommandRing(UINT_8* ringBuffer, size_t ringBufferSize, UINT_32 slotCount, UINT_32 slotSizeInBytes)
+{
+	if (!staticDriver)
+	{
+		return ALREADY_UNINITIALIZED;
+	}
+
+	if (staticCommandRingThread)
+	{
+		return COMMAND_RING_ALREADY_RUNNING;
+	}
+
+	if (slotCount == 0 || slotSizeInBytes < sizeof(UINT_32) + sizeof(driver::DRIVER_COMMAND) || \
+		((size_t)slotCount * slotSizeInBytes) > ringBufferSize)
+	{
+		return INVALID_COMMAND_RING_GEOMETRY;
+	}
+
+	staticCommandRingThread = new LoopingThread([ringBuffer, slotCount, slotSizeInBytes]()
+	{
+		for (UINT_32 slotIndex = 0; slotIndex < slotCount; slotIndex++)
+		{
+			UINT_8* slot = ringBuffer + ((size_t)slotIndex * slotSizeInBytes);
+			auto pSlotState = (std::atomic<UINT_32>*)slot;
+
+			if (pSlotState->load(std::memory_order_acquire) == COMMAND_RING_SLOT_SUBMITTED)
+			{
+				staticDriver->sendCommand(slot + sizeof(UINT_32), slotSizeInBytes - sizeof(UINT_32));
+				pSlotState->store(COMMAND_RING_SLOT_COMPLETED, std::memory_order_release); // hand the slot back
+			}
+		}
+	}, 1); // poll the ring every millisecond when idle
+	staticCommandRingThread->start();
+
+	return NO_ERRORS;
+}
+
+long StopCommandRing()
+{
+	if (!staticCommandRingThread)
+	{
+		return COMMAND_RING_NOT_RUNNING;
+	}
+
+	staticCommandRingThread->end();
+	delete staticCommandRingThread;
+	staticCommandRingThread = nullptr;
+
+	return NO_ERRORS;
+}
+
 char* GetStatusString(long statusCode)
 {
 	std::string retStr = "Unknown Status";
@@ -87,6 +179,22 @@ char* GetStatusString(long statusCode)
 	{
 		retStr = "The controller reset failed";
 	}
+	else if (statusCode == INVALID_BATCH_BUFFER)
+	{
+		retStr = "The batch buffer was too small for the given command count";
+	}
+	else if (statusCode == COMMAND_RING_ALREADY_RUNNING)
+	{
+		retStr = "The command ring is already running";
+	}
+	else if (statusCode == COMMAND_RING_NOT_RUNNING)
+	{
+		retStr = "The command ring is not running";
+	}
+	else if (statusCode == INVALID_COMMAND_RING_GEOMETRY)
+	{
+		retStr = "The command ring geometry doesn't fit the given buffer";
+	}
 
 	return getCharStarOfStringToSendOut(retStr);
 }
@@ -102,6 +210,8 @@ long Uninitialize()
 {
 	if (staticDriver)
 	{
+		StopCommandRing(); // in case the caller left the ring running
+
 		delete staticDriver;
 		staticDriver = nullptr;
 		return NO_ERRORS;
@@ -58,6 +58,27 @@ extern "C" {
 	/// </summary>
 	EXPORT long SendCommand(UINT_8* driveCommandData, size_t driveCommandDataLength);
 
+	/// <summary>
+	/// Batched version of SendCommand to amortize the FFI boundary: the buffer holds commandCount
+	/// packed DRIVER_COMMANDs (each sizeof(DRIVER_COMMAND) plus its TransferDataSize). Every command
+	/// is sent in order and its completion is written back in place.
+	/// </summary>
+	EXPORT long SendCommands(UINT_8* driverCommandsData, size_t driverCommandsDataLength, UINT_32 commandCount);
+
+	/// <summary>
+	/// Starts the command ring: a caller-owned buffer of slotCount slots, each slotSizeInBytes
+	/// large, polled by a worker thread inside the library. Each slot is a UINT_32 state word
+	/// (0 = host owns, 1 = submitted, 2 = completed) followed by a DRIVER_COMMAND. A long-running
+	/// harness writes a command, sets the state word to 1, and polls for 2 - no per-command FFI
+	/// crossing. The buffer must stay valid until StopCommandRing().
+	/// </summary>
+	EXPORT long StartCommandRing(UINT_8* ringBuffer, size_t ringBufferSize, UINT_32 slotCount, UINT_32 slotSizeInBytes);
+
+	/// <summary>
+	/// Stops the command ring worker. In-flight slots finish before this returns.
+	/// </summary>
+	EXPORT long StopCommandRing();
+
 	/// <summary>
 	/// Returns a NULL-delmitied char* for the status string of the given status code.
 	/// It is the responsibility of caller to free the memory returned!
@@ -78,6 +78,14 @@ namespace cnvme
 			{
 				return "The IEN field must be set to 1 as we do not support disabled interrupt queues";
 			}
+			else if (s == INVALID_COMMAND_FOR_ASYNC)
+			{
+				return "The command needs driver-side bookkeeping on completion and must go through the synchronous sendCommand";
+			}
+			else if (s == UNKNOWN_MEMORY_REGION_TOKEN)
+			{
+				return "The given memory region token doesn't name a registered memory region";
+			}
 
 			ASSERT("Status not found in statusToString()");
 			return "Unknown";
@@ -108,6 +116,12 @@ namespace cnvme
 
 		Driver::Driver()
 		{
+			this->NextCommandHandle = 1; // 0 is INVALID_COMMAND_HANDLE
+			this->NextMemoryRegionToken = 1; // 0 is INVALID_MEMORY_REGION_TOKEN
+			this->ShadowDoorbells = nullptr;
+			this->EventIdxs = nullptr;
+			this->ShadowDoorbellsEnabled = false;
+
 			// We have a controller... it is not running.
 			auto controllerRegisters = this->TheController.getControllerRegisters()->getControllerRegisters();
 
@@ -158,6 +172,7 @@ namespace cnvme
 
 			// Enable the controller
 			controllerRegisters->CC.EN = 1;
+			this->TheController.getControllerRegisters()->notifyChange(); // wake the register watcher for the CC.EN write
 
 			// Wait for CSTS.RDY to go to 1
 			UINT_64 numberOfSecondsMaxToWait = (controllerRegisters->CAP.TO / 2);
@@ -196,7 +211,7 @@ namespace cnvme
 			DRIVER_COMMAND* pDriverCommand = (DRIVER_COMMAND*)driverCommandBuffer;
 
 			// If we should return an invalid buffer size, do.
-			if (driverCommandBufferSize < sizeof(DRIVER_COMMAND) || (driverCommandBufferSize < pDriverCommand->TransferDataSize + sizeof(DRIVER_COMMAND)))
+			if (driverCommandBufferSize < sizeof(DRIVER_COMMAND) || (pDriverCommand->MemoryRegionToken == INVALID_MEMORY_REGION_TOKEN && driverCommandBufferSize < pDriverCommand->TransferDataSize + sizeof(DRIVER_COMMAND)))
 			{
 				LOG_ERROR("The provided buffer was not large enough");
 				pDriverCommand->DriverStatus = BUFFER_NOT_LARGE_ENOUGH;
@@ -211,8 +226,9 @@ namespace cnvme
 				return;
 			}
 
-			// If the data length is invalid, fail now
-			if (pDriverCommand->TransferDataSize == 0 && pDriverCommand->TransferDataDirection != NO_DATA)
+			// If the data length is invalid, fail now (MANUAL_PRPS is the one direction where
+			//  a 0 length is expected, since the user owns the data pointers)
+			if (pDriverCommand->TransferDataSize == 0 && pDriverCommand->TransferDataDirection != NO_DATA && pDriverCommand->TransferDataDirection != MANUAL_PRPS)
 			{
 				LOG_ERROR("Transfer data size was 0 but the data direction is not no-data");
 				pDriverCommand->DriverStatus = INVALID_DATA_LENGTH;
@@ -227,6 +243,16 @@ namespace cnvme
 				return;
 			}
 
+			// Registered regions replace the driver's PRP construction; they can't combine
+			//  with directions that bypass it or move no data
+			if (pDriverCommand->MemoryRegionToken != INVALID_MEMORY_REGION_TOKEN && \
+				(pDriverCommand->TransferDataDirection == NO_DATA || pDriverCommand->TransferDataDirection == MANUAL_PRPS))
+			{
+				LOG_ERROR("A memory region token was given but the data direction doesn't move data through the driver");
+				pDriverCommand->DriverStatus = INVALID_DATA_DIRECTION;
+				return;
+			}
+
 			// If the user gave Create IO Completion Queue, we need to check the command for what the driver supports
 			if (this->commandRequiresContiguousBufferInsteadOfPrp(pDriverCommand->Command, pDriverCommand->QueueId == ADMIN_QUEUE_ID))
 			{
@@ -301,6 +327,15 @@ namespace cnvme
 					contiguousBufferAddress = POINTER_TO_MEMORY_ADDRESS(contig);    // DONT FORGET TO FREE ME... later.
 					pDriverCommand->Command.DPTR.DPTR1 = contiguousBufferAddress;   // Give drive new queue location
 				}
+				else if (pDriverCommand->MemoryRegionToken != INVALID_MEMORY_REGION_TOKEN)
+				{
+					// Zero copy path: the controller reads/writes the registered buffer directly
+					std::lock_guard<std::mutex> asyncLock(this->AsyncCommandsMutex);
+					if (!this->resolveMemoryRegion(pDriverCommand))
+					{
+						return;
+					}
+				}
 				else
 				{
 					prps.constructFromPayloadAndMemoryPageSize(cnvme::Payload(pDriverCommand->TransferData, pDriverCommand->TransferDataSize), this->TheController.getControllerRegisters()->getMemoryPageSize());
@@ -326,6 +361,9 @@ namespace cnvme
 			// Move the tail pointer up and ring the doorbell. This is the 'sending' per-say.
 			pSubmissionQueue->incrementTailPointerAndRingDoorbell();
 
+			// Let the controller know right away instead of waiting for its next doorbell poll
+			this->TheController.notifyChange();
+
 			// The head pointer is not used here. Just the tail.
 
 			// The command has been sent!! 
@@ -333,6 +371,9 @@ namespace cnvme
 			// Watch for timeout and the completion queue 
 			UINT_64 deathTime = helpers::getTimeInMilliseconds() + (pDriverCommand->Timeout * 1000);
 
+			// Grab the interrupt count before scanning so a completion posted mid-scan still wakes us
+			UINT_64 lastSeenInterruptCount = this->TheController.getCompletionInterruptCount(pDriverCommand->QueueId);
+
 			bool commandTimedOut = true;
 			while (helpers::getTimeInMilliseconds() < deathTime)
 			{
@@ -349,11 +390,11 @@ namespace cnvme
 
 						memcpy_s(&pDriverCommand->CompletionQueueEntry, sizeof(pDriverCommand->CompletionQueueEntry), pCompletionQueueEntry, sizeof(COMPLETION_QUEUE_ENTRY));
 
-						// copy data back if this was a read.
-						if (pDriverCommand->TransferDataDirection == READ)
+						// copy data back if this was a read (registered regions already hold the data).
+						if (pDriverCommand->TransferDataDirection == READ && pDriverCommand->MemoryRegionToken == INVALID_MEMORY_REGION_TOKEN)
 						{
-							auto payloadOfReadData = prps.getPayloadCopy();
-							memcpy_s(&pDriverCommand->TransferData, driverCommandBufferSize - sizeof(DRIVER_COMMAND), payloadOfReadData.getBuffer(), pDriverCommand->TransferDataSize);
+							// gather straight from the PRP pages into the caller's buffer (no intermediate payload)
+							prps.copySegmentsToBuffer((BYTE*)&pDriverCommand->TransferData, pDriverCommand->TransferDataSize);
 						}
 
 						pDriverCommand->DriverStatus = SENT_SUCCESSFULLY;
@@ -368,6 +409,20 @@ namespace cnvme
 					commandTimedOut = false;
 					break;
 				}
+
+				// Block on the queue's (emulated) interrupt vector instead of spinning on its memory
+				UINT_64 currentTime = helpers::getTimeInMilliseconds();
+				if (currentTime >= deathTime)
+				{
+					break;
+				}
+#ifdef SINGLE_THREADED
+				// The command ran inline when the doorbell rang; if its completion isn't
+				//  posted by now it never will be, so there is nothing to wait on.
+				break;
+#else
+				lastSeenInterruptCount = this->TheController.waitForCompletionInterrupt(pDriverCommand->QueueId, lastSeenInterruptCount, (UINT_32)(deathTime - currentTime));
+#endif
 			}
 
 			if (commandTimedOut)
@@ -425,6 +480,12 @@ namespace cnvme
 
 					subQ->setMappedQueue(mappedCompletionQueueItr->second); // SQ -> CQ
 					mappedCompletionQueueItr->second->setMappedQueue(subQ); // CQ -> SQ
+
+					if (this->ShadowDoorbellsEnabled)
+					{
+						subQ->setShadowDoorbell(&this->ShadowDoorbells[pDriverCommand->Command.DW10_CreateIoQueue.QID * 2],
+							&this->EventIdxs[pDriverCommand->Command.DW10_CreateIoQueue.QID * 2]);
+					}
 				}
 			}
 			else if ((pDriverCommand->CompletionQueueEntry.SC | pDriverCommand->CompletionQueueEntry.SCT) == 0) // command passed
@@ -467,12 +528,256 @@ namespace cnvme
 			}
 		}
 
+		COMMAND_HANDLE Driver::submitCommand(UINT_8* driverCommandBuffer, size_t driverCommandBufferSize, COMMAND_CALLBACK callback)
+		{
+			// Make sure the buffer is large enough
+			ASSERT_IF(driverCommandBufferSize < sizeof(Status), "The passed in buffer size wasn't even large enough to return a status");
+			DRIVER_COMMAND* pDriverCommand = (DRIVER_COMMAND*)driverCommandBuffer;
+
+			// If we should return an invalid buffer size, do.
+			if (driverCommandBufferSize < sizeof(DRIVER_COMMAND) || (pDriverCommand->MemoryRegionToken == INVALID_MEMORY_REGION_TOKEN && driverCommandBufferSize < pDriverCommand->TransferDataSize + sizeof(DRIVER_COMMAND)))
+			{
+				LOG_ERROR("The provided buffer was not large enough");
+				pDriverCommand->DriverStatus = BUFFER_NOT_LARGE_ENOUGH;
+				return INVALID_COMMAND_HANDLE;
+			}
+
+			// If the data direction is invalid, fail now
+			if (pDriverCommand->TransferDataDirection >= DATA_DIRECTION_MAX)
+			{
+				LOG_ERROR("Invalid data direction was provided");
+				pDriverCommand->DriverStatus = INVALID_DATA_DIRECTION;
+				return INVALID_COMMAND_HANDLE;
+			}
+
+			// If the data length is invalid, fail now (MANUAL_PRPS is the one direction where
+			//  a 0 length is expected, since the user owns the data pointers)
+			if (pDriverCommand->TransferDataSize == 0 && pDriverCommand->TransferDataDirection != NO_DATA && pDriverCommand->TransferDataDirection != MANUAL_PRPS)
+			{
+				LOG_ERROR("Transfer data size was 0 but the data direction is not no-data");
+				pDriverCommand->DriverStatus = INVALID_DATA_LENGTH;
+				return INVALID_COMMAND_HANDLE;
+			}
+
+			// If the user gave data but also wanted to passdown their own PRPs
+			if (pDriverCommand->TransferDataDirection == MANUAL_PRPS && pDriverCommand->TransferDataSize != 0)
+			{
+				LOG_ERROR("The user specified that they wanted to create/use their own PRPs, and yet they gave the driver transfer data... Where would it go?");
+				pDriverCommand->DriverStatus = INVALID_DATA_LENGTH_FOR_MANUAL_PRPS;
+				return INVALID_COMMAND_HANDLE;
+			}
+
+			// Registered regions replace the driver's PRP construction; they can't combine
+			//  with directions that bypass it or move no data
+			if (pDriverCommand->MemoryRegionToken != INVALID_MEMORY_REGION_TOKEN && \
+				(pDriverCommand->TransferDataDirection == NO_DATA || pDriverCommand->TransferDataDirection == MANUAL_PRPS))
+			{
+				LOG_ERROR("A memory region token was given but the data direction doesn't move data through the driver");
+				pDriverCommand->DriverStatus = INVALID_DATA_DIRECTION;
+				return INVALID_COMMAND_HANDLE;
+			}
+
+			// Queue management commands update the driver's queue bookkeeping when they complete,
+			//  which needs the completion in hand. Those have to stay synchronous.
+			if (this->commandRequiresContiguousBufferInsteadOfPrp(pDriverCommand->Command, pDriverCommand->QueueId == ADMIN_QUEUE_ID) || \
+				(pDriverCommand->QueueId == ADMIN_QUEUE_ID && \
+				(pDriverCommand->Command.DWord0Breakdown.OPC == constants::opcodes::admin::DELETE_IO_SUBMISSION_QUEUE || \
+					pDriverCommand->Command.DWord0Breakdown.OPC == constants::opcodes::admin::DELETE_IO_COMPLETION_QUEUE)))
+			{
+				LOG_ERROR("Queue management commands cannot be submitted asynchronously. Use sendCommand.");
+				pDriverCommand->DriverStatus = INVALID_COMMAND_FOR_ASYNC;
+				return INVALID_COMMAND_HANDLE;
+			}
+
+			// If we don't have a submission queue that matches, fail now
+			auto submissionQueueItr = this->SubmissionQueues.find(pDriverCommand->QueueId);
+			if (submissionQueueItr == this->SubmissionQueues.end())
+			{
+				LOG_ERROR("Couldn't find a submission queue with the id: " + std::to_string(pDriverCommand->QueueId));
+				pDriverCommand->DriverStatus = NO_MATCHING_SUBMISSION_QUEUE;
+				return INVALID_COMMAND_HANDLE;
+			}
+
+			// If we don't know what completion queue that submission queue maps to, fail now.
+			auto pSubmissionQueue = submissionQueueItr->second;
+			if (!pSubmissionQueue->getMappedQueue())
+			{
+				LOG_ERROR("Couldn't find a linked completion queue for a submission queue with the id: " + std::to_string(pDriverCommand->QueueId));
+				pDriverCommand->DriverStatus = NO_LINKED_COMPLETION_QUEUE;
+				return INVALID_COMMAND_HANDLE;
+			}
+
+			// From here on we touch shared bookkeeping (CIDs, the queue tail, OutstandingCommands),
+			//  so serialize with the other submitters/reapers
+			std::lock_guard<std::mutex> asyncLock(this->AsyncCommandsMutex);
+
+			// Add the CID to the command
+			pDriverCommand->Command.DWord0Breakdown.CID = getCommandIdForSubmissionQueueIdViaIncrementIfNeeded(pSubmissionQueue->getQueueId());
+
+			// PRPs have to stay in scope until the command is reaped, so they go on the heap with the bookkeeping
+			auto prps = std::make_shared<PRP>();
+			if (pDriverCommand->TransferDataDirection != MANUAL_PRPS)
+			{
+				if (pDriverCommand->MemoryRegionToken != INVALID_MEMORY_REGION_TOKEN)
+				{
+					// Zero copy path: the controller reads/writes the registered buffer directly
+					//  (AsyncCommandsMutex is already held here)
+					if (!this->resolveMemoryRegion(pDriverCommand))
+					{
+						return INVALID_COMMAND_HANDLE;
+					}
+				}
+				else
+				{
+					prps->constructFromPayloadAndMemoryPageSize(cnvme::Payload(pDriverCommand->TransferData, pDriverCommand->TransferDataSize), this->TheController.getControllerRegisters()->getMemoryPageSize());
+					if (pDriverCommand->TransferDataDirection == READ || pDriverCommand->TransferDataDirection == WRITE || pDriverCommand->TransferDataDirection == BI_DIRECTIONAL)
+					{
+						pDriverCommand->Command.DPTR.DPTR1 = prps->getPRP1();
+						pDriverCommand->Command.DPTR.DPTR2 = prps->getPRP2();
+					}
+				}
+			}
+
+			// Get a pointer to the location to place the command
+			UINT_8* theRawSubmissionQueue = MEMORY_ADDRESS_TO_8POINTER(pSubmissionQueue->getMemoryAddress());
+			NVME_COMMAND* nvmeCommand = (NVME_COMMAND*)theRawSubmissionQueue;
+			nvmeCommand += pSubmissionQueue->getTailPointer(); // Make sure we increment to the correct command.
+
+			LOG_INFO("About to copy a command with an opcode of 0x" + cnvme::strings::toHexString(pDriverCommand->Command.DWord0Breakdown.OPC) + \
+				" to submission queue 0x" + cnvme::strings::toHexString(pDriverCommand->QueueId) + " and CID of 0x" + cnvme::strings::toHexString(pDriverCommand->Command.DWord0Breakdown.CID) + " (async)");
+
+			memcpy_s(nvmeCommand, sizeof(NVME_COMMAND), &pDriverCommand->Command, sizeof(pDriverCommand->Command));
+
+			// Move the tail pointer up and ring the doorbell. This is the 'sending' per-say.
+			pSubmissionQueue->incrementTailPointerAndRingDoorbell();
+
+			// Let the controller know right away instead of waiting for its next doorbell poll
+			this->TheController.notifyChange();
+
+			// The command is in flight. Remember it for reapCompletions().
+			OUTSTANDING_COMMAND outstandingCommand;
+			outstandingCommand.Handle = this->NextCommandHandle++;
+			outstandingCommand.DriverCommand = pDriverCommand;
+			outstandingCommand.DriverCommandBufferSize = driverCommandBufferSize;
+			outstandingCommand.Prps = prps;
+			outstandingCommand.Callback = callback;
+			this->OutstandingCommands[outstandingCommand.Handle] = outstandingCommand;
+
+			return outstandingCommand.Handle;
+		}
+
+		UINT_32 Driver::reapCompletions(UINT_32 maxCompletions, UINT_16 timeoutSeconds)
+		{
+			UINT_32 reapedCount = 0;
+			UINT_64 deathTime = helpers::getTimeInMilliseconds() + ((UINT_64)timeoutSeconds * 1000);
+
+			// Grab the interrupt count before scanning so a completion posted mid-pass still wakes us
+			UINT_64 lastSeenInterruptCount = this->TheController.getTotalCompletionInterruptCount();
+
+			std::unique_lock<std::mutex> asyncLock(this->AsyncCommandsMutex);
+
+			while (reapedCount < maxCompletions && !this->OutstandingCommands.empty() && helpers::getTimeInMilliseconds() < deathTime)
+			{
+				UINT_32 reapedThisPass = 0;
+
+				for (auto itr = this->OutstandingCommands.begin(); itr != this->OutstandingCommands.end() && reapedCount < maxCompletions;)
+				{
+					if (this->tryToReapCompletion(itr->second))
+					{
+						itr = this->OutstandingCommands.erase(itr);
+						reapedCount++;
+						reapedThisPass++;
+					}
+					else
+					{
+						++itr;
+					}
+				}
+
+				// If we have a batch going and this pass came up dry, hand back what we have
+				//  instead of burning the rest of the timeout waiting on stragglers.
+				if (reapedThisPass == 0 && reapedCount > 0)
+				{
+					break;
+				}
+
+				// Nothing reaped yet: block on any queue's interrupt instead of spinning over the queues
+				if (reapedThisPass == 0)
+				{
+					UINT_64 currentTime = helpers::getTimeInMilliseconds();
+					if (currentTime >= deathTime)
+					{
+						break;
+					}
+					asyncLock.unlock(); // don't hold up submitters while we sleep on the interrupt
+					lastSeenInterruptCount = this->TheController.waitForAnyCompletionInterrupt(lastSeenInterruptCount, (UINT_32)(deathTime - currentTime));
+					asyncLock.lock();
+				}
+			}
+
+			return reapedCount;
+		}
+
+		size_t Driver::getOutstandingCommandCount()
+		{
+			std::lock_guard<std::mutex> asyncLock(this->AsyncCommandsMutex);
+			return this->OutstandingCommands.size();
+		}
+
+		bool Driver::tryToReapCompletion(OUTSTANDING_COMMAND &outstandingCommand)
+		{
+			auto pDriverCommand = outstandingCommand.DriverCommand;
+
+			auto submissionQueueItr = this->SubmissionQueues.find(pDriverCommand->QueueId);
+			if (submissionQueueItr == this->SubmissionQueues.end() || !submissionQueueItr->second->getMappedQueue())
+			{
+				// The queue went away underneath the command (should not happen since queue management is synchronous)
+				ASSERT("An outstanding command's queue disappeared before the command was reaped");
+				return false;
+			}
+			auto pCompletionQueue = submissionQueueItr->second->getMappedQueue();
+
+			COMPLETION_QUEUE_ENTRY* pCompletionQueueEntry = (COMPLETION_QUEUE_ENTRY*)MEMORY_ADDRESS_TO_8POINTER(pCompletionQueue->getMemoryAddress());
+
+			// Look for a completion queue entry with a matching Command ID
+			for (UINT_16 completionEntryIndex = 0; completionEntryIndex < pCompletionQueue->getQueueSize(); completionEntryIndex++)
+			{
+				if (pCompletionQueueEntry->CID == pDriverCommand->Command.DWord0Breakdown.CID)
+				{
+					LOG_INFO("Found matching completion entry for CID " + strings::toHexString(pCompletionQueueEntry->CID) + " in CQE index " + \
+						strings::toHexString(completionEntryIndex));
+
+					memcpy_s(&pDriverCommand->CompletionQueueEntry, sizeof(pDriverCommand->CompletionQueueEntry), pCompletionQueueEntry, sizeof(COMPLETION_QUEUE_ENTRY));
+
+					// copy data back if this was a read (registered regions already hold the data).
+					if (pDriverCommand->TransferDataDirection == READ && pDriverCommand->MemoryRegionToken == INVALID_MEMORY_REGION_TOKEN)
+					{
+						// gather straight from the PRP pages into the caller's buffer (no intermediate payload)
+						outstandingCommand.Prps->copySegmentsToBuffer((BYTE*)&pDriverCommand->TransferData, pDriverCommand->TransferDataSize);
+					}
+
+					pDriverCommand->DriverStatus = SENT_SUCCESSFULLY;
+
+					if (outstandingCommand.Callback)
+					{
+						outstandingCommand.Callback(pDriverCommand);
+					}
+
+					return true;
+				}
+				pCompletionQueueEntry++; // Increment through the completion queue
+			}
+
+			return false;
+		}
+
 		bool Driver::controllerReset()
 		{
 			auto CR = this->TheController.getControllerRegisters()->getControllerRegisters();
 			auto timeoutMs = CR->CAP.TO * 500; // CAP.TO is in 500 millisecond intervals
 
 			CR->CC.EN = 0; // Begin Reset
+			this->TheController.getControllerRegisters()->notifyChange(); // wake the register watcher for the CC.EN write
 			auto deathTime = helpers::getTimeInMilliseconds() + timeoutMs;
 			bool rdyTo0 = false;
 			while (helpers::getTimeInMilliseconds() < deathTime)
@@ -487,6 +792,7 @@ namespace cnvme
 			FAIL_IF(rdyTo0 == false, "CSTS.RDY did not transition to 0 after CC.EN was set to 0");
 
 			CR->CC.EN = 1; // Enable controller and wait till ready
+			this->TheController.getControllerRegisters()->notifyChange();
 			bool rdyTo1 = false;
 			deathTime = helpers::getTimeInMilliseconds() + timeoutMs;
 			while (helpers::getTimeInMilliseconds() < deathTime)
@@ -501,6 +807,15 @@ namespace cnvme
 
 			LOG_INFO("Deleting all IO Queues");
 			this->deleteAllIoQueues();
+
+			if (this->ShadowDoorbellsEnabled)
+			{
+				// The reset dropped the controller's shadow buffer pointers: go back to real
+				//  doorbell writes until someone re-sends Doorbell Buffer Config.
+				this->ShadowDoorbellsEnabled = false;
+				this->SubmissionQueues[ADMIN_QUEUE_ID]->setShadowDoorbell(nullptr, nullptr);
+			}
+
 			LOG_INFO("Controller Reset succeeded!");
 
 			return true;
@@ -511,6 +826,130 @@ namespace cnvme
 			this->TheController.setCommandResponseFilePath(filePath);
 		}
 
+		void Driver::enableCommandTracing(const std::string& traceFilePath, UINT_64 recordCapacity)
+		{
+			this->TheController.enableCommandTracing(traceFilePath, recordCapacity);
+		}
+
+		void Driver::disableCommandTracing()
+		{
+			this->TheController.disableCommandTracing();
+		}
+
+		void Driver::setTimingEngine(const std::shared_ptr<timing::TimingEngine>& timingEngine)
+		{
+			this->TheController.setTimingEngine(timingEngine);
+		}
+
+		MEMORY_REGION_TOKEN Driver::registerMemoryRegion(BYTE* buffer, size_t bufferSize)
+		{
+			ASSERT_IF(buffer == nullptr || bufferSize == 0, "A memory region needs a buffer and a non-zero size");
+
+			std::lock_guard<std::mutex> asyncLock(this->AsyncCommandsMutex);
+
+			MEMORY_REGION_TOKEN token = this->NextMemoryRegionToken++;
+			auto &region = this->TokenToMemoryRegion[token];
+			region.Buffer = buffer;
+			region.Size = bufferSize;
+			region.DescribedBytes = 0;
+			region.Prp1 = 0;
+			region.Prp2 = 0;
+
+			LOG_INFO("Registered a memory region of " + std::to_string(bufferSize) + " bytes with the token " + std::to_string(token));
+			return token;
+		}
+
+		bool Driver::unregisterMemoryRegion(MEMORY_REGION_TOKEN token)
+		{
+			std::lock_guard<std::mutex> asyncLock(this->AsyncCommandsMutex);
+			return this->TokenToMemoryRegion.erase(token) != 0;
+		}
+
+		bool Driver::resolveMemoryRegion(PDRIVER_COMMAND pDriverCommand)
+		{
+			auto regionItr = this->TokenToMemoryRegion.find(pDriverCommand->MemoryRegionToken);
+			if (regionItr == this->TokenToMemoryRegion.end())
+			{
+				LOG_ERROR("No memory region is registered with the token: " + std::to_string(pDriverCommand->MemoryRegionToken));
+				pDriverCommand->DriverStatus = UNKNOWN_MEMORY_REGION_TOKEN;
+				return false;
+			}
+
+			auto &region = regionItr->second;
+			if (pDriverCommand->TransferDataSize > region.Size)
+			{
+				LOG_ERROR("The transfer is larger than the registered memory region");
+				pDriverCommand->DriverStatus = INVALID_DATA_LENGTH;
+				return false;
+			}
+
+			// Only rebuild the PRP view when the transfer size changes; repeat transfers of
+			//  the same size (the common case for a benchmark loop) reuse it as-is.
+			if (region.DescribedBytes != pDriverCommand->TransferDataSize)
+			{
+				PRP regionPrps;
+				regionPrps.constructFromExternalBuffer(region.Buffer, pDriverCommand->TransferDataSize,
+					this->TheController.getControllerRegisters()->getMemoryPageSize(), region.PrpListChainArena);
+				region.Prp1 = regionPrps.getPRP1();
+				region.Prp2 = regionPrps.getPRP2();
+				region.DescribedBytes = pDriverCommand->TransferDataSize;
+			}
+
+			pDriverCommand->Command.DPTR.DPTR1 = region.Prp1;
+			pDriverCommand->Command.DPTR.DPTR2 = region.Prp2;
+			return true;
+		}
+
+		bool Driver::enableShadowDoorbells()
+		{
+			UINT_64 memoryPageSize = this->TheController.getControllerRegisters()->getMemoryPageSize();
+
+			// Over-allocate so a page aligned buffer can be carved out of each payload.
+			//  One UINT_32 pair per possible queue id fits well within a single page.
+			this->ShadowDoorbellBuffer = Payload((UINT_32)(memoryPageSize * 2));
+			this->EventIdxBuffer = Payload((UINT_32)(memoryPageSize * 2));
+
+			UINT_64 shadowAddress = (this->ShadowDoorbellBuffer.getMemoryAddress() + memoryPageSize - 1) & ~(memoryPageSize - 1);
+			UINT_64 eventIdxAddress = (this->EventIdxBuffer.getMemoryAddress() + memoryPageSize - 1) & ~(memoryPageSize - 1);
+
+			UINT_32 driverCommandSize = sizeof(DRIVER_COMMAND);
+			Payload commandPayload(driverCommandSize);
+			auto pDriverCommand = (PDRIVER_COMMAND)commandPayload.getBuffer();
+			pDriverCommand->QueueId = ADMIN_QUEUE_ID;
+			pDriverCommand->Timeout = 5;
+			pDriverCommand->TransferDataDirection = MANUAL_PRPS; // the addresses are raw buffers, not PRPs for the driver to build
+			pDriverCommand->Command.DWord0Breakdown.OPC = constants::opcodes::admin::DOORBELL_BUFFER_CONFIG;
+			pDriverCommand->Command.DPTR.DPTR1 = shadowAddress;
+			pDriverCommand->Command.DPTR.DPTR2 = eventIdxAddress;
+
+			this->sendCommand(commandPayload.getBuffer(), driverCommandSize);
+
+			if (pDriverCommand->DriverStatus != SENT_SUCCESSFULLY || (pDriverCommand->CompletionQueueEntry.SC | pDriverCommand->CompletionQueueEntry.SCT) != 0)
+			{
+				LOG_ERROR("The controller did not accept Doorbell Buffer Config");
+				return false;
+			}
+
+			// The controller seeded each queue's slots with its current tail before going live,
+			//  so the Queue objects can start publishing tails to the shadow slots right away.
+			this->ShadowDoorbells = (UINT_32*)MEMORY_ADDRESS_TO_8POINTER(shadowAddress);
+			this->EventIdxs = (UINT_32*)MEMORY_ADDRESS_TO_8POINTER(eventIdxAddress);
+			this->ShadowDoorbellsEnabled = true;
+
+			std::lock_guard<std::mutex> asyncCommandsLock(this->AsyncCommandsMutex);
+			for (auto &submissionQueueItr : this->SubmissionQueues)
+			{
+				submissionQueueItr.second->setShadowDoorbell(&this->ShadowDoorbells[submissionQueueItr.first * 2], &this->EventIdxs[submissionQueueItr.first * 2]);
+			}
+
+			return true;
+		}
+
+		void Driver::setIoQueueWorkersEnabled(bool enabled)
+		{
+			this->TheController.setIoQueueWorkersEnabled(enabled);
+		}
+
 		UINT_16 Driver::getCommandIdForSubmissionQueueIdViaIncrementIfNeeded(UINT_16 submissionQueueId)
 		{
 			auto entry = this->SubmissionQueueIdToCurrentCommandIdentifiers.find(submissionQueueId);
@@ -26,6 +26,7 @@ Driver.h - A header file for the cNVMe 'Driver'
 #pragma once
 
 #include "Controller.h"
+#include "PRP.h"
 #include "Queue.h"
 #include "Types.h"
 
@@ -48,6 +49,8 @@ namespace cnvme
 			INVALID_DATA_LENGTH_FOR_MANUAL_PRPS,
 			INVALID_IO_QUEUE_MANAGEMENT_PC,
 			INVALID_IO_QUEUE_MANAGEMENT_IEN,
+			INVALID_COMMAND_FOR_ASYNC,
+			UNKNOWN_MEMORY_REGION_TOKEN,
 		};
 
 		/// <summary>
@@ -75,6 +78,14 @@ namespace cnvme
 		/// </summary>
 		std::string dataDirectionToString(DataDirection d);
 
+		/// <summary>
+		/// Token naming a buffer registered with Driver::registerMemoryRegion()
+		/// </summary>
+		typedef UINT_32 MEMORY_REGION_TOKEN;
+
+// Means no registered memory region; the DRIVER_COMMAND's TransferData tail holds the data
+#define INVALID_MEMORY_REGION_TOKEN 0
+
 #ifdef _WIN32
 #pragma warning (push)
 #pragma warning	(disable: 4200)	// Disable 0-sized array warning.
@@ -91,12 +102,27 @@ namespace cnvme
 			COMPLETION_QUEUE_ENTRY CompletionQueueEntry;// Filled out by the driver
 			DataDirection TransferDataDirection;		// Filled out by the user
 			UINT_32 TransferDataSize;					// Filled out by the user
-			UINT_8 TransferData[0];						// Filled out by the driver on reads, user on writes, both on bidirectional
+			MEMORY_REGION_TOKEN MemoryRegionToken;		// Filled out by the user: a region from registerMemoryRegion() the data moves through zero copy, or INVALID_MEMORY_REGION_TOKEN to use TransferData
+			UINT_8 TransferData[0];						// Filled out by the driver on reads, user on writes, both on bidirectional. Unused when MemoryRegionToken is set
 		} DRIVER_COMMAND, *PDRIVER_COMMAND;
 #ifdef _WIN32
 #pragma warning(pop) // Disable 0-sized array warning.
 #endif
 
+		/// <summary>
+		/// Handle used to track a command sent via submitCommand().
+		/// </summary>
+		typedef UINT_64 COMMAND_HANDLE;
+
+// Returned by submitCommand() when the command could not be submitted. Check the DRIVER_COMMAND's DriverStatus for why.
+#define INVALID_COMMAND_HANDLE 0
+
+		/// <summary>
+		/// Optional per-command callback invoked by reapCompletions() when a submitted command completes.
+		/// Gets the (by then filled out) DRIVER_COMMAND that was submitted.
+		/// </summary>
+		typedef std::function<void(PDRIVER_COMMAND)> COMMAND_CALLBACK;
+
 		/// <summary>
 		/// Production Driver class used by the DLL (and everything other than internal testing)
 		/// </summary>
@@ -120,6 +146,92 @@ namespace cnvme
 			/// <param name="driverCommandBufferSize">Size of the data pointed to in driverCommandBuffer</param>
 			void sendCommand(UINT_8* driverCommandBuffer, size_t driverCommandBufferSize);
 
+			/// <summary>
+			/// Asynchronous version of sendCommand(): rings the doorbell and returns a handle
+			/// immediately instead of polling for the completion. This lets a single caller keep an
+			/// entire submission queue full. The caller owns the DRIVER_COMMAND buffer and must keep
+			/// it alive and unmodified until the command is reaped via reapCompletions().
+			/// Queue management commands (create/delete IO queues) need driver-side bookkeeping when
+			/// they complete and so must go through the synchronous sendCommand() instead.
+			/// The caller should not have more commands outstanding on a queue than it has entries.
+			/// </summary>
+			/// <param name="driverCommandBuffer">Pointer to the filled out DRIVER_COMMAND structure</param>
+			/// <param name="driverCommandBufferSize">Size of the data pointed to in driverCommandBuffer</param>
+			/// <param name="callback">Optional callback fired (on the reaping thread) when this command gets reaped</param>
+			/// <returns>Handle for the submitted command, or INVALID_COMMAND_HANDLE with DriverStatus set on failure</returns>
+			COMMAND_HANDLE submitCommand(UINT_8* driverCommandBuffer, size_t driverCommandBufferSize, COMMAND_CALLBACK callback = nullptr);
+
+			/// <summary>
+			/// Harvests completions for commands submitted via submitCommand(). Fills out each
+			/// completed command's DRIVER_COMMAND (status / completion entry / read data), fires its
+			/// callback if one was given, and returns once a batch has been gathered.
+			/// </summary>
+			/// <param name="maxCompletions">Max number of completions to reap in this call</param>
+			/// <param name="timeoutSeconds">Max seconds to wait for at least one completion</param>
+			/// <returns>The number of completions reaped</returns>
+			UINT_32 reapCompletions(UINT_32 maxCompletions, UINT_16 timeoutSeconds);
+
+			/// <summary>
+			/// Returns the number of submitted commands that have not been reaped yet
+			/// </summary>
+			/// <returns>Number of outstanding commands</returns>
+			size_t getOutstandingCommandCount();
+
+			/// <summary>
+			/// Starts recording every command the underlying controller completes to a
+			/// binary trace ring file (see Trace.h)
+			/// </summary>
+			/// <param name="traceFilePath">File to write the trace into</param>
+			/// <param name="recordCapacity">Ring capacity in records</param>
+			void enableCommandTracing(const std::string& traceFilePath, UINT_64 recordCapacity);
+
+			/// <summary>
+			/// Stops recording and finalizes the trace file
+			/// </summary>
+			void disableCommandTracing();
+
+			/// <summary>
+			/// Attaches (or, given null, detaches) a timing engine to the underlying
+			/// controller so completions take the opcode's modeled latency (see Timing.h).
+			/// The caller keeps a reference for configuring latencies and driving a
+			/// virtual clock.
+			/// </summary>
+			/// <param name="timingEngine">The engine to model latency with, or null for none</param>
+			void setTimingEngine(const std::shared_ptr<timing::TimingEngine>& timingEngine);
+
+			/// <summary>
+			/// Sends Doorbell Buffer Config (NVMe 1.3) so submission doorbells go through
+			/// host-memory shadow buffers. After this succeeds, ringing a submission doorbell
+			/// usually just writes the shadow slot; the real doorbell register only gets
+			/// touched when the tail crosses the controller's EventIdx. Applies to existing
+			/// and future submission queues. Call while no other commands are in flight.
+			/// A controller reset turns this back off (re-send to turn it back on).
+			/// </summary>
+			/// <returns>True if the controller accepted the command</returns>
+			bool enableShadowDoorbells();
+
+			/// <summary>
+			/// Registers a caller owned contiguous buffer for zero copy transfers, like an
+			/// RDMA memory region. A command that names the returned token as its
+			/// MemoryRegionToken moves data straight between the controller and this buffer:
+			/// the driver builds PRPs pointing into the buffer (instead of copying the
+			/// command's TransferData into fresh PRP pages), and the controller reads and
+			/// writes the buffer through them directly. The buffer must stay alive and in
+			/// place until the region is unregistered and no command using it is in flight.
+			/// </summary>
+			/// <param name="buffer">Contiguous buffer to register</param>
+			/// <param name="bufferSize">Size of the buffer in bytes</param>
+			/// <returns>Token commands can reference the region by</returns>
+			MEMORY_REGION_TOKEN registerMemoryRegion(BYTE* buffer, size_t bufferSize);
+
+			/// <summary>
+			/// Unregisters a region from registerMemoryRegion(). The caller must make sure
+			/// no command using the region is still in flight.
+			/// </summary>
+			/// <param name="token">The region's token</param>
+			/// <returns>True if the token named a registered region</returns>
+			bool unregisterMemoryRegion(MEMORY_REGION_TOKEN token);
+
 			/// <summary>
 			/// Issues a controller reset (CC.EN->0) and will wait for CC.EN->1.
 			/// </summary>
@@ -132,6 +244,12 @@ namespace cnvme
 			/// <param name="filePath">path to the file</param>
 			void setControllerCommandResponseProcessingFile(std::string filePath);
 
+			/// <summary>
+			/// Enables/disables the underlying controller servicing each IO queue with its own worker thread
+			/// </summary>
+			/// <param name="enabled">true to give each IO queue its own worker</param>
+			void setIoQueueWorkersEnabled(bool enabled);
+
 		private:
 			/// <summary>
 			/// The controller that this driver is connected to
@@ -153,6 +271,93 @@ namespace cnvme
 			/// </summary>
 			std::map<UINT_16, UINT_16> SubmissionQueueIdToCurrentCommandIdentifiers;
 
+			/// <summary>
+			/// Backing memory for the shadow doorbell buffer. Over-allocated so a page
+			/// aligned buffer can be carved out of it (the command requires page alignment).
+			/// </summary>
+			Payload ShadowDoorbellBuffer;
+
+			/// <summary>
+			/// Backing memory for the EventIdx buffer (same alignment story)
+			/// </summary>
+			Payload EventIdxBuffer;
+
+			/// <summary>
+			/// Page aligned view into ShadowDoorbellBuffer (slot q * 2 is queue q's tail)
+			/// </summary>
+			UINT_32* ShadowDoorbells;
+
+			/// <summary>
+			/// Page aligned view into EventIdxBuffer (slot q * 2 is queue q's EventIdx)
+			/// </summary>
+			UINT_32* EventIdxs;
+
+			/// <summary>
+			/// True once enableShadowDoorbells() has succeeded (cleared by controllerReset())
+			/// </summary>
+			bool ShadowDoorbellsEnabled;
+
+			/// <summary>
+			/// A buffer registered via registerMemoryRegion() plus the PRP view the driver
+			/// built over it. The arena holds any chained PRP list pages; the entries point
+			/// into the caller's buffer, so commands using the region transfer zero copy.
+			/// </summary>
+			typedef struct REGISTERED_MEMORY_REGION
+			{
+				BYTE* Buffer;								// The caller's buffer (caller owned)
+				size_t Size;								// Size of the buffer in bytes
+				Payload PrpListChainArena;					// Backing memory for the chained PRP lists
+				size_t DescribedBytes;						// Transfer size the cached PRPs describe (0 if none built yet)
+				UINT_64 Prp1;								// PRP1 for a DescribedBytes sized transfer
+				UINT_64 Prp2;								// PRP2 for a DescribedBytes sized transfer
+			} REGISTERED_MEMORY_REGION, *PREGISTERED_MEMORY_REGION;
+
+			/// <summary>
+			/// Map from token to registered memory region. Guarded by AsyncCommandsMutex.
+			/// </summary>
+			std::map<MEMORY_REGION_TOKEN, REGISTERED_MEMORY_REGION> TokenToMemoryRegion;
+
+			/// <summary>
+			/// The token the next registered memory region will get
+			/// </summary>
+			MEMORY_REGION_TOKEN NextMemoryRegionToken;
+
+			/// <summary>
+			/// Bookkeeping for a command submitted via submitCommand() that has not been reaped yet
+			/// </summary>
+			typedef struct OUTSTANDING_COMMAND
+			{
+				COMMAND_HANDLE Handle;						// Handle returned to the submitter
+				PDRIVER_COMMAND DriverCommand;				// The submitter's command buffer (submitter owned)
+				size_t DriverCommandBufferSize;				// Size of the submitter's command buffer
+				std::shared_ptr<PRP> Prps;					// Keeps the PRP memory alive until the command is reaped
+				COMMAND_CALLBACK Callback;					// Optional completion callback
+			} OUTSTANDING_COMMAND, *POUTSTANDING_COMMAND;
+
+			/// <summary>
+			/// Map from handle to commands submitted via submitCommand() awaiting their completion
+			/// </summary>
+			std::map<COMMAND_HANDLE, OUTSTANDING_COMMAND> OutstandingCommands;
+
+			/// <summary>
+			/// The handle the next submitted command will get
+			/// </summary>
+			COMMAND_HANDLE NextCommandHandle;
+
+			/// <summary>
+			/// Guards the async command bookkeeping (OutstandingCommands, NextCommandHandle, CIDs and
+			/// submission queue tails) so multiple threads can submit/reap against one driver
+			/// </summary>
+			std::mutex AsyncCommandsMutex;
+
+			/// <summary>
+			/// Checks the given outstanding command's completion queue for its completion.
+			/// If found, fills out the command's DRIVER_COMMAND and fires its callback.
+			/// </summary>
+			/// <param name="outstandingCommand">The outstanding command to look for</param>
+			/// <returns>True if the command completed and was filled out</returns>
+			bool tryToReapCompletion(OUTSTANDING_COMMAND &outstandingCommand);
+
 			/// <summary>
 			/// Will update SubmissionQueueIdToCurrentCommandIdentifiers and return the next CID.
 			/// </summary>
@@ -166,6 +371,16 @@ namespace cnvme
 			/// <returns>bool</returns>
 			bool commandRequiresContiguousBufferInsteadOfPrp(NVME_COMMAND& nvmeCommand, bool admin);
 
+			/// <summary>
+			/// Points the given command's DPTR at its registered memory region, rebuilding
+			/// the region's cached PRPs if the transfer size changed since the region was
+			/// last used. Fills out DriverStatus and returns false on a bad token or size.
+			/// Caller must hold AsyncCommandsMutex.
+			/// </summary>
+			/// <param name="pDriverCommand">Command naming a registered region</param>
+			/// <returns>True if the DPTR now points at the region</returns>
+			bool resolveMemoryRegion(PDRIVER_COMMAND pDriverCommand);
+
 			/// <summary>
 			/// Deallocates all IO queues
 			/// </summary>
@@ -50,5 +50,75 @@ namespace cnvme
 		} FIRMWARE_SLOT_INFO, *PFIRMWARE_SLOT_INFO;
 
 		static_assert(sizeof(FIRMWARE_SLOT_INFO) == 512, "Firmware Slot Info is 512 bytes");
+
+/// <summary>
+/// Number of power-of-two latency buckets in the vendor performance log.
+/// Bucket n counts commands whose latency was under 2^n microseconds
+/// (the last bucket also holds everything slower).
+/// </summary>
+#define PERFORMANCE_LOG_LATENCY_BUCKETS 16
+
+		/// <summary>
+		/// Per submission queue counters in the vendor performance log (LID=0xC0)
+		/// </summary>
+		typedef struct _QUEUE_PERFORMANCE_STATS
+		{
+			UINT_32 SubmissionQueueId;
+			UINT_32 RSVD_0;
+			UINT_64 CommandsCompleted;
+			UINT_64 BytesTransferred;
+			UINT_64 TotalLatencyMicroseconds;
+			UINT_64 MaxLatencyMicroseconds;
+			UINT_64 LatencyHistogram[PERFORMANCE_LOG_LATENCY_BUCKETS];
+		} QUEUE_PERFORMANCE_STATS, *PQUEUE_PERFORMANCE_STATS;
+
+		static_assert(sizeof(QUEUE_PERFORMANCE_STATS) == 168, "Queue performance stats should be 168 bytes");
+
+		/// <summary>
+		/// Header of the vendor performance log (LID=0xC0).
+		/// QueueCount QUEUE_PERFORMANCE_STATS entries follow directly after this header.
+		/// ControllerUpMilliseconds lets the host turn the counters into IOPS/throughput.
+		/// </summary>
+		typedef struct _PERFORMANCE_LOG_HEADER
+		{
+			UINT_32 QueueCount;
+			UINT_32 LatencyBucketCount;
+			UINT_64 ControllerUpMilliseconds;
+			UINT_64 AdminOpcodeCounts[256];
+			UINT_64 NvmOpcodeCounts[256];
+		} PERFORMANCE_LOG_HEADER, *PPERFORMANCE_LOG_HEADER;
+
+		static_assert(sizeof(PERFORMANCE_LOG_HEADER) == 4112, "Performance log header should be 4112 bytes");
+
+		/// <summary>
+		/// SMART / Health Information Log for LID=0x02.
+		/// The 128 bit counters are byte arrays to keep the layout packed; only the low
+		/// 8 bytes ever get filled (good for a few hundred exabytes of simulated IO).
+		/// </summary>
+		typedef struct _SMART_HEALTH_INFO
+		{
+			UINT_8 CriticalWarning;							// Byte 0
+			UINT_8 CompositeTemperature[2];					// Bytes 1-2, in Kelvin
+			UINT_8 AvailableSpare;							// Byte 3, percentage
+			UINT_8 AvailableSpareThreshold;					// Byte 4, percentage
+			UINT_8 PercentageUsed;							// Byte 5
+			UINT_8 RSVD_06_31[26];
+			UINT_8 DataUnitsRead[16];						// Thousands of 512 byte units
+			UINT_8 DataUnitsWritten[16];					// Thousands of 512 byte units
+			UINT_8 HostReadCommands[16];
+			UINT_8 HostWriteCommands[16];
+			UINT_8 ControllerBusyTime[16];					// Minutes
+			UINT_8 PowerCycles[16];
+			UINT_8 PowerOnHours[16];
+			UINT_8 UnsafeShutdowns[16];
+			UINT_8 MediaAndDataIntegrityErrors[16];
+			UINT_8 NumberOfErrorInformationLogEntries[16];
+			UINT_32 WarningCompositeTemperatureTime;		// Bytes 192-195, minutes
+			UINT_32 CriticalCompositeTemperatureTime;		// Bytes 196-199, minutes
+			UINT_8 TemperatureSensors[8][2];				// Bytes 200-215, in Kelvin
+			UINT_8 RSVD_216_511[296];
+		} SMART_HEALTH_INFO, *PSMART_HEALTH_INFO;
+
+		static_assert(sizeof(SMART_HEALTH_INFO) == 512, "SMART / Health Information log is 512 bytes");
 	}
 }
\ No newline at end of file
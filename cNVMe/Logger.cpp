@@ -40,9 +40,25 @@ namespace cnvme
 		{
 			Level = SILENT;
 			AssertLoud = true;
+			WriterThreadStarted = false;
+			ShuttingDown = false;
 			clearStatus();
 		}
 
+		Logger::~Logger()
+		{
+			{
+				std::unique_lock<std::mutex> lock(Mutex);
+				ShuttingDown = true;
+			}
+			PendingLogCondition.notify_all();
+
+			if (WriterThread.joinable())
+			{
+				WriterThread.join(); // flushes whatever is still queued
+			}
+		}
+
 		void Logger::setLevel(LOGGING_LEVEL level)
 		{
 			Level = level;
@@ -55,12 +71,57 @@ namespace cnvme
 
 		void Logger::log(std::string txt, LOGGING_LEVEL level)
 		{
-			Mutex.lock();
-			if (level <= Level && HiddenThreads.find(std::this_thread::get_id()) == HiddenThreads.end())
+			// The LOG_* macros check the level before formatting, but direct callers may not have
+			if (level > Level)
 			{
-				std::cerr << getCurrentTime() << " - " << txt << std::endl;
+				return;
+			}
+
+			{
+				std::unique_lock<std::mutex> lock(Mutex);
+
+				if (HiddenThreads.find(std::this_thread::get_id()) != HiddenThreads.end())
+				{
+					return;
+				}
+
+				if (!WriterThreadStarted)
+				{
+					// Lazily spin up the writer on the first record, to not make threads pre-main
+					WriterThread = std::thread(&Logger::writerThreadLoop, this);
+					WriterThreadStarted = true;
+				}
+
+				// Hand the record to the writer thread: the caller only pays for the queue push,
+				//  the console I/O happens off the command path
+				PendingLogRecords.push_back(getCurrentTime() + " - " + txt);
+			}
+			PendingLogCondition.notify_one();
+		}
+
+		void Logger::writerThreadLoop()
+		{
+			std::unique_lock<std::mutex> lock(Mutex);
+			for (;;)
+			{
+				PendingLogCondition.wait(lock, [this]() { return ShuttingDown || !PendingLogRecords.empty(); });
+
+				while (!PendingLogRecords.empty())
+				{
+					std::string record = std::move(PendingLogRecords.front());
+					PendingLogRecords.pop_front();
+
+					// Print without the lock so producers don't block on console I/O
+					lock.unlock();
+					std::cerr << record << std::endl;
+					lock.lock();
+				}
+
+				if (ShuttingDown)
+				{
+					break;
+				}
 			}
-			Mutex.unlock();
 		}
 
 		void Logger::setStatus(std::string status)
@@ -25,6 +25,9 @@ Logger.h - A header file for the Logging
 
 #pragma once
 
+#include <atomic>
+#include <condition_variable>
+#include <deque>
 #include <iostream>
 #include <mutex>
 #include <set>
@@ -34,8 +37,9 @@ Logger.h - A header file for the Logging
 
 // Macros to make this easier to work with
 #define _LOGGING_INFO() std::string(std::string(__FILE__) + ":" + std::string(__func__) + ":" + std::to_string(__LINE__))
-#define LOG_ERROR(txt) cnvme::logging::theLogger.log(_LOGGING_INFO() + " - [Error] - " + txt, cnvme::logging::ERROR)
-#define LOG_INFO(txt) cnvme::logging::theLogger.log(_LOGGING_INFO() + " - [Info] - " + txt, cnvme::logging::INFO)
+// Check the level before building the message so disabled logging doesn't pay for string formatting
+#define LOG_ERROR(txt) do { if (cnvme::logging::theLogger.getLevel() >= cnvme::logging::ERROR) { cnvme::logging::theLogger.log(_LOGGING_INFO() + " - [Error] - " + txt, cnvme::logging::ERROR); } } while (0)
+#define LOG_INFO(txt) do { if (cnvme::logging::theLogger.getLevel() >= cnvme::logging::INFO) { cnvme::logging::theLogger.log(_LOGGING_INFO() + " - [Info] - " + txt, cnvme::logging::INFO); } } while (0)
 #define LOG_SET_LEVEL(level) cnvme::logging::theLogger.setLevel((cnvme::logging::LOGGING_LEVEL)level)
 #define ASSERT(txt) cnvme::logging::theLogger._assert(std::string(__func__), txt, __LINE__, "")
 #define ASSERT_IF(cond, txt) cnvme::logging::theLogger._assert_if(std::string(__func__), cond, txt, __LINE__)
@@ -78,6 +82,11 @@ namespace cnvme
 			/// </summary>
 			Logger();
 
+			/// <summary>
+			/// Destructor. Flushes any queued log records and stops the writer thread.
+			/// </summary>
+			~Logger();
+
 			/// <summary>
 			/// Function to set the logging level
 			/// </summary>
@@ -200,6 +209,37 @@ namespace cnvme
 			/// Set of threads that are currently not asserting
 			/// </summary>
 			std::set<std::thread::id> AssertQuietThreads;
+
+			/// <summary>
+			/// Records queued by log() waiting for the writer thread to print them
+			/// </summary>
+			std::deque<std::string> PendingLogRecords;
+
+			/// <summary>
+			/// Signaled when records get queued (and on shutdown)
+			/// </summary>
+			std::condition_variable PendingLogCondition;
+
+			/// <summary>
+			/// Background thread that does the actual console I/O, so log() callers
+			/// only pay for a queue push on the command path
+			/// </summary>
+			std::thread WriterThread;
+
+			/// <summary>
+			/// True once the writer thread has been started (it starts on the first log)
+			/// </summary>
+			bool WriterThreadStarted;
+
+			/// <summary>
+			/// Set by the destructor to tell the writer thread to flush and stop
+			/// </summary>
+			std::atomic<bool> ShuttingDown;
+
+			/// <summary>
+			/// The writer thread's loop: waits for records and prints them
+			/// </summary>
+			void writerThreadLoop();
 		};
 
 		/// <summary>
@@ -24,6 +24,7 @@ LoopingThread.cpp - An implementation file for the LoopingThread class
 */
 
 #include "LoopingThread.h"
+#include "WatcherPool.h"
 
 namespace cnvme
 {
@@ -39,6 +40,8 @@ namespace cnvme
 		Flipper = false;
 		IsRunning = false;
 		SleepDuration = 0;
+		WakeRequested = false;
+		Pool = nullptr;
 	}
 
 	LoopingThread::LoopingThread(const LoopingThread & other) : LoopingThread::LoopingThread()
@@ -58,6 +61,7 @@ namespace cnvme
 		Flipper = other.Flipper.load();
 		SleepDuration = other.SleepDuration;
 		FunctionToLoop = other.FunctionToLoop;
+		Pool = other.Pool;
 
 		return *this;
 	}
@@ -72,8 +76,16 @@ namespace cnvme
 		if (!isRunning())
 		{
 			ContinueLoop = true;
-			TheThread = std::thread(&LoopingThread::loopingFunction, this);
-			IsRunning = true;
+			if (Pool)
+			{
+				IsRunning = true;
+				Pool->add(this); // the pool's workers drive runPooledIteration() from here on
+			}
+			else
+			{
+				TheThread = std::thread(&LoopingThread::loopingFunction, this);
+				IsRunning = true;
+			}
 			waitForFlip(); // wait for one iteration, to make sure it is running
 		}
 	}
@@ -84,6 +96,15 @@ namespace cnvme
 		{
 			ContinueLoop = false;
 
+			if (Pool)
+			{
+				Pool->remove(this); // blocks till no worker is mid-iteration on us
+				IsRunning = false;
+				return;
+			}
+
+			wakeUp(); // don't make the teardown wait out the sleep
+
 			RunningMutex.lock();  // Shouldn't pass till the loopingFunction() ends
 			IsRunning = false;
 			RunningMutex.unlock();
@@ -97,6 +118,43 @@ namespace cnvme
 		return IsRunning;
 	}
 
+	void LoopingThread::wakeUp()
+	{
+		if (Pool)
+		{
+			if (isRunning())
+			{
+				Pool->wake();
+			}
+			return;
+		}
+
+		{
+			std::unique_lock<std::mutex> wakeLock(WakeMutex);
+			WakeRequested = true;
+		}
+		WakeCondition.notify_all();
+	}
+
+	void LoopingThread::setPool(WatcherPool* pool)
+	{
+		ASSERT_IF(isRunning(), "Cannot change a LoopingThread's pool while it is running");
+		Pool = pool;
+	}
+
+	void LoopingThread::runPooledIteration()
+	{
+		if (!ContinueLoop)
+		{
+			return; // end() is underway
+		}
+
+		std::unique_lock<std::mutex> flipLock(FlipMutex);
+		FunctionToLoop();
+		Flipper = !Flipper;
+		FlipCondition.notify_all();
+	}
+
 	bool LoopingThread::waitForFlip()
 	{
 		// Get lock before any other flips can happen
@@ -130,7 +188,16 @@ namespace cnvme
 				FlipCondition.notify_all();
 			}
 
-			std::this_thread::sleep_for(std::chrono::milliseconds(SleepDuration));
+			// Sleep till either the sleep duration passes or someone calls wakeUp() to notify us of a change.
+			//  The timed wait keeps the old polling behavior as a fallback.
+			{
+				std::unique_lock<std::mutex> wakeLock(WakeMutex);
+				if (!WakeRequested)
+				{
+					WakeCondition.wait_for(wakeLock, std::chrono::milliseconds(SleepDuration));
+				}
+				WakeRequested = false;
+			}
 		}
 
 		RunningMutex.unlock();
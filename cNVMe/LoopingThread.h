@@ -29,6 +29,8 @@ LoopingThread.h - A header file for the LoopingThread class
 
 namespace cnvme
 {
+	class WatcherPool; // forward declared since WatcherPool.h includes this file
+
 	/// <summary>
 	/// This class can do something over and over and over
 	/// </summary>
@@ -87,7 +89,22 @@ namespace cnvme
 		/// <returns></returns>
 		bool waitForFlip();
 
+		/// <summary>
+		/// Wakes the thread up right away instead of waiting for the sleep between iterations to expire.
+		/// Used for event-driven notification. If the thread isn't running, this does nothing.
+		/// </summary>
+		void wakeUp();
+
+		/// <summary>
+		/// Makes this LoopingThread run on the given pool's workers instead of its own
+		/// std::thread. Must be called before start(). Pass nullptr for a dedicated thread.
+		/// </summary>
+		/// <param name="pool">The pool to run on, or nullptr</param>
+		void setPool(WatcherPool* pool);
+
 	private:
+		friend class WatcherPool; // the pool drives runPooledIteration() and reads SleepDuration
+
 		/// <summary>
 		/// The function to loop
 		/// </summary>
@@ -133,10 +150,36 @@ namespace cnvme
 		/// </summary>
 		std::mutex FlipMutex;
 
+		/// <summary>
+		/// Set via wakeUp() to cut the sleep between loop iterations short
+		/// </summary>
+		std::atomic<bool> WakeRequested;
+
+		/// <summary>
+		/// Used to interrupt the sleep between loop iterations
+		/// </summary>
+		std::condition_variable WakeCondition;
+
+		/// <summary>
+		/// A mutex for the WakeCondition
+		/// </summary>
+		std::mutex WakeMutex;
+
+		/// <summary>
+		/// The pool this LoopingThread runs on instead of its own thread (nullptr for dedicated)
+		/// </summary>
+		WatcherPool* Pool;
+
 		/// <summary>
 		/// The function that does the looping
 		/// </summary>
 		void loopingFunction();
 
+		/// <summary>
+		/// Runs one iteration on behalf of a pool worker: the body of loopingFunction()'s
+		/// loop without the thread or the sleep
+		/// </summary>
+		void runPooledIteration();
+
 	};
 }
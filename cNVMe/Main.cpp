@@ -23,7 +23,9 @@
 Main.cpp - An implementation file for the Main entry
 */
 
+#include "Benchmark.h"
 #include "Driver.h"
+#include "Trace.h"
 #include "Strings.h"
 #include "System.h"
 #include "Tests.h"
@@ -32,8 +34,92 @@ using namespace cnvme;
 using namespace cnvme::command;
 using namespace cnvme::driver;
 
-int main()
+int main(int argc, char* argv[])
 {
+	// Run as a benchmark harness instead of the test suite when asked:
+	//  cNVMe64.out --benchmark [--qpairs N] [--qdepth N] [--bs BYTES] [--readpercent N] [--threads N] [--seconds N]
+	if (argc > 1 && std::string(argv[1]) == "--benchmark")
+	{
+		LOG_SET_LEVEL(0); // per-command logging would dominate the run
+
+		benchmark::BENCHMARK_CONFIG config;
+		for (int i = 2; i + 1 < argc; i += 2)
+		{
+			std::string flag = argv[i];
+			UINT_32 value = (UINT_32)std::stoul(argv[i + 1]);
+			if (flag == "--qpairs")
+			{
+				config.QueuePairCount = value;
+			}
+			else if (flag == "--qdepth")
+			{
+				config.QueueDepth = value;
+			}
+			else if (flag == "--bs")
+			{
+				config.BlockSizeInBytes = value;
+			}
+			else if (flag == "--readpercent")
+			{
+				config.ReadPercent = value;
+			}
+			else if (flag == "--threads")
+			{
+				config.WorkerThreadCount = value;
+			}
+			else if (flag == "--seconds")
+			{
+				config.DurationInSeconds = value;
+			}
+			else
+			{
+				std::cout << "Unknown benchmark flag: " << flag << std::endl;
+				return 1;
+			}
+		}
+
+		benchmark::BENCHMARK_RESULTS results;
+		bool passed = benchmark::runBenchmark(config, results);
+		benchmark::printReport(config, results);
+		return (!passed); // 0 is pass
+	}
+
+	// Replay a captured command trace instead of the test suite when asked:
+	//  cNVMe64.out --replay --file TRACE [--timescale X]  (1 is recorded timing, 0 is as fast as possible)
+	if (argc > 1 && std::string(argv[1]) == "--replay")
+	{
+		LOG_SET_LEVEL(0); // per-command logging would dominate the run
+
+		tracing::REPLAY_CONFIG config;
+		for (int i = 2; i + 1 < argc; i += 2)
+		{
+			std::string flag = argv[i];
+			if (flag == "--file")
+			{
+				config.TraceFilePath = argv[i + 1];
+			}
+			else if (flag == "--timescale")
+			{
+				config.TimeScale = std::stod(argv[i + 1]);
+			}
+			else
+			{
+				std::cout << "Unknown replay flag: " << flag << std::endl;
+				return 1;
+			}
+		}
+		if (config.TraceFilePath.empty())
+		{
+			std::cout << "--replay needs --file TRACE" << std::endl;
+			return 1;
+		}
+
+		tracing::REPLAY_RESULTS results;
+		bool passed = tracing::replayTrace(config, results);
+		tracing::printReplayReport(config, results);
+		return (!passed); // 0 is pass
+	}
+
 	// This is testing code.
 	LOG_SET_LEVEL(2);
 
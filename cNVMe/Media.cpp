@@ -0,0 +1,364 @@
+/*
+###########################################################################################
+// cNVMe - An Open Source NVMe Device Simulation - MIT License
+// Copyright 2018 - Intel Corporation
+
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+// INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+// PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+// LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT
+// OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+// OTHER DEALINGS IN THE SOFTWARE.
+############################################################################################
+Media.cpp - An implementation file for sparse namespace media
+*/
+
+#include "Media.h"
+
+#ifdef _WIN32
+#include <Windows.h>
+#else // Linux
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif // _WIN32
+
+#ifdef __linux__
+#include <linux/falloc.h> // FALLOC_FL_PUNCH_HOLE
+#endif // __linux__
+
+namespace cnvme
+{
+	namespace ns
+	{
+		/// <summary>
+		/// FNV-1a hash of a page's contents, used as the deduplication index key
+		/// </summary>
+		static UINT_64 hashPageContents(const BYTE* pageBuffer)
+		{
+			UINT_64 contentHash = 0xCBF29CE484222325ULL;
+			for (size_t byteIndex = 0; byteIndex < SPARSE_MEDIA_PAGE_SIZE; byteIndex++)
+			{
+				contentHash = (contentHash ^ pageBuffer[byteIndex]) * 0x100000001B3ULL;
+			}
+			return contentHash;
+		}
+
+		SparseMedia::SparseMedia()
+		{
+			this->PageMapMutex = std::make_shared<std::mutex>();
+			this->SizeInBytes = 0;
+			this->MappedBuffer = nullptr;
+			this->DeduplicationEnabled = false;
+#ifndef _WIN32
+			this->BackingFileDescriptor = -1;
+#endif // !_WIN32
+		}
+
+		SparseMedia::SparseMedia(UINT_64 sizeInBytes) : SparseMedia()
+		{
+			this->SizeInBytes = sizeInBytes;
+		}
+
+		SparseMedia::SparseMedia(UINT_64 sizeInBytes, const std::string &backingFilePath) : SparseMedia()
+		{
+			this->SizeInBytes = sizeInBytes;
+
+#ifdef _WIN32
+			HANDLE fileHandle = CreateFileA(backingFilePath.c_str(), GENERIC_READ | GENERIC_WRITE, 0, NULL, OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+			ASSERT_IF(fileHandle == INVALID_HANDLE_VALUE, "Unable to open the media backing file");
+
+			// make sure the file is at least the logical size. Never shrink: we may be reopening existing media.
+			LARGE_INTEGER fileSize = { 0 };
+			GetFileSizeEx(fileHandle, &fileSize);
+			if ((UINT_64)fileSize.QuadPart < sizeInBytes)
+			{
+				LARGE_INTEGER newEnd;
+				newEnd.QuadPart = (LONGLONG)sizeInBytes;
+				SetFilePointerEx(fileHandle, newEnd, NULL, FILE_BEGIN);
+				SetEndOfFile(fileHandle);
+			}
+
+			HANDLE mappingHandle = CreateFileMappingA(fileHandle, NULL, PAGE_READWRITE, (DWORD)(sizeInBytes >> 32), (DWORD)(sizeInBytes & 0xFFFFFFFF), NULL);
+			ASSERT_IF(mappingHandle == NULL, "Unable to create a file mapping for the media backing file");
+
+			BYTE* mappedBuffer = (BYTE*)MapViewOfFile(mappingHandle, FILE_MAP_ALL_ACCESS, 0, 0, (SIZE_T)sizeInBytes);
+			ASSERT_IF(mappedBuffer == NULL, "Unable to map a view of the media backing file");
+
+			this->MappedBuffer = mappedBuffer;
+			this->BackingFileMapping = std::shared_ptr<void>(mappedBuffer, [mappedBuffer, mappingHandle, fileHandle](void*)
+			{
+				UnmapViewOfFile(mappedBuffer);
+				CloseHandle(mappingHandle);
+				CloseHandle(fileHandle);
+			});
+#else // Linux
+			int fileDescriptor = open(backingFilePath.c_str(), O_RDWR | O_CREAT, 0644);
+			ASSERT_IF(fileDescriptor < 0, "Unable to open the media backing file");
+
+			// make sure the file is at least the logical size. Never shrink: we may be reopening existing media.
+			// ftruncate() extends sparsely, so a fresh multi-terabyte file takes no actual disk blocks.
+			struct stat fileInfo = { 0 };
+			fstat(fileDescriptor, &fileInfo);
+			if ((UINT_64)fileInfo.st_size < sizeInBytes)
+			{
+				ASSERT_IF(ftruncate(fileDescriptor, sizeInBytes) != 0, "Unable to size the media backing file");
+			}
+
+			BYTE* mappedBuffer = (BYTE*)mmap(NULL, (size_t)sizeInBytes, PROT_READ | PROT_WRITE, MAP_SHARED, fileDescriptor, 0);
+			ASSERT_IF(mappedBuffer == MAP_FAILED, "Unable to memory map the media backing file");
+
+			this->MappedBuffer = mappedBuffer;
+			this->BackingFileDescriptor = fileDescriptor;
+			this->BackingFileMapping = std::shared_ptr<void>(mappedBuffer, [mappedBuffer, sizeInBytes, fileDescriptor](void*)
+			{
+				munmap(mappedBuffer, (size_t)sizeInBytes);
+				close(fileDescriptor);
+			});
+#endif // _WIN32
+		}
+
+		SparseMedia::~SparseMedia()
+		{
+			// the page map and the file mapping clean themselves up.
+		}
+
+		bool SparseMedia::isFileBacked() const
+		{
+			return this->MappedBuffer != nullptr;
+		}
+
+		UINT_64 SparseMedia::getSize() const
+		{
+			return this->SizeInBytes;
+		}
+
+		void SparseMedia::read(UINT_64 offset, BYTE* buffer, UINT_64 length)
+		{
+			ASSERT_IF(offset + length > this->SizeInBytes, "Attempted to read past the end of the media");
+
+			if (this->isFileBacked())
+			{
+				// the OS zero-fills file holes for us
+				memcpy_s(buffer, (size_t)length, this->MappedBuffer + offset, (size_t)length);
+				return;
+			}
+
+			while (length > 0)
+			{
+				UINT_64 pageIndex = offset / SPARSE_MEDIA_PAGE_SIZE;
+				UINT_64 offsetIntoPage = offset % SPARSE_MEDIA_PAGE_SIZE;
+				UINT_64 bytesFromThisPage = std::min(length, (UINT_64)SPARSE_MEDIA_PAGE_SIZE - offsetIntoPage);
+
+				std::shared_ptr<Payload> page;
+				{
+					// only the lookup needs the lock; holding the shared_ptr keeps the page
+					//  alive for the copy below even if a writer copy-on-writes it away
+					std::lock_guard<std::mutex> pageMapLock(*this->PageMapMutex);
+					auto pageItr = this->PageIndexToPage.find(pageIndex);
+					if (pageItr != this->PageIndexToPage.end())
+					{
+						page = pageItr->second;
+					}
+				}
+
+				if (page)
+				{
+					memcpy_s(buffer, (size_t)bytesFromThisPage, page->getBuffer() + offsetIntoPage, (size_t)bytesFromThisPage);
+				}
+				else
+				{
+					// never written: reads back as zeros, no allocation needed
+					memset(buffer, 0, (size_t)bytesFromThisPage);
+				}
+
+				buffer += bytesFromThisPage;
+				offset += bytesFromThisPage;
+				length -= bytesFromThisPage;
+			}
+		}
+
+		std::shared_ptr<Payload> SparseMedia::getWritablePage(UINT_64 pageIndex)
+		{
+			auto &pageSlot = this->PageIndexToPage[pageIndex];
+			if (!pageSlot)
+			{
+				// first touch of this page: allocate it (Payload zero-fills)
+				pageSlot = std::make_shared<Payload>(SPARSE_MEDIA_PAGE_SIZE);
+			}
+			else if (!pageSlot.unique())
+			{
+				// a snapshot, clone, or deduplicated twin still sees this page: copy before
+				//  writing so their view of the data doesn't change underneath them
+				pageSlot = std::make_shared<Payload>(*pageSlot);
+			}
+			return pageSlot;
+		}
+
+		void SparseMedia::write(UINT_64 offset, const BYTE* buffer, UINT_64 length)
+		{
+			ASSERT_IF(offset + length > this->SizeInBytes, "Attempted to write past the end of the media");
+
+			if (this->isFileBacked())
+			{
+				memcpy_s(this->MappedBuffer + offset, (size_t)length, buffer, (size_t)length);
+				return;
+			}
+
+			while (length > 0)
+			{
+				UINT_64 pageIndex = offset / SPARSE_MEDIA_PAGE_SIZE;
+				UINT_64 offsetIntoPage = offset % SPARSE_MEDIA_PAGE_SIZE;
+				UINT_64 bytesForThisPage = std::min(length, (UINT_64)SPARSE_MEDIA_PAGE_SIZE - offsetIntoPage);
+
+				if (this->DeduplicationEnabled)
+				{
+					// deduplicatePage() byte-compares live page buffers against this one, so
+					//  the copy itself has to land under the page map lock too: otherwise a
+					//  concurrent dedup of another index could match this page mid-rewrite and
+					//  share an allocation that no longer holds the matched data
+					std::lock_guard<std::mutex> pageMapLock(*this->PageMapMutex);
+					auto page = this->getWritablePage(pageIndex);
+					memcpy_s(page->getBuffer() + offsetIntoPage, (size_t)bytesForThisPage, buffer, (size_t)bytesForThisPage);
+					this->deduplicatePage(pageIndex, page);
+				}
+				else
+				{
+					std::shared_ptr<Payload> page;
+					{
+						// only the lookup/allocation (and any copy-on-write split) needs the lock
+						std::lock_guard<std::mutex> pageMapLock(*this->PageMapMutex);
+						page = this->getWritablePage(pageIndex);
+					}
+
+					memcpy_s(page->getBuffer() + offsetIntoPage, (size_t)bytesForThisPage, buffer, (size_t)bytesForThisPage);
+				}
+
+				buffer += bytesForThisPage;
+				offset += bytesForThisPage;
+				length -= bytesForThisPage;
+			}
+		}
+
+		void SparseMedia::eraseAll()
+		{
+			if (this->isFileBacked())
+			{
+#ifdef __linux__
+				// punch the whole file out: gives the blocks back to the filesystem and reads as zeros
+				if (fallocate(this->BackingFileDescriptor, FALLOC_FL_PUNCH_HOLE | FALLOC_FL_KEEP_SIZE, 0, (off_t)this->SizeInBytes) == 0)
+				{
+					return;
+				}
+#endif // __linux__
+				// no hole punching here (or it failed): zero the mapping instead
+				memset(this->MappedBuffer, 0, (size_t)this->SizeInBytes);
+				return;
+			}
+
+			std::lock_guard<std::mutex> pageMapLock(*this->PageMapMutex);
+			this->PageIndexToPage.clear(); // snapshots holding page references keep them alive
+		}
+
+		MEDIA_SNAPSHOT SparseMedia::snapshot()
+		{
+			ASSERT_IF(this->isFileBacked(), "Snapshots need the page-indexed layout; file backed media has no page map to share");
+
+			std::lock_guard<std::mutex> pageMapLock(*this->PageMapMutex);
+			return this->PageIndexToPage; // shared_ptr copies: the pages themselves stay put
+		}
+
+		void SparseMedia::restore(const MEDIA_SNAPSHOT& mediaSnapshot)
+		{
+			ASSERT_IF(this->isFileBacked(), "Snapshots need the page-indexed layout; file backed media has no page map to share");
+
+			std::lock_guard<std::mutex> pageMapLock(*this->PageMapMutex);
+			this->PageIndexToPage = mediaSnapshot; // pages written since the snapshot get dropped here
+		}
+
+		void SparseMedia::setDeduplicationEnabled(bool enabled)
+		{
+			ASSERT_IF(this->isFileBacked(), "Deduplication needs the page-indexed layout; file backed media has no page map");
+			this->DeduplicationEnabled = enabled;
+		}
+
+		UINT_64 SparseMedia::getUniquePageAllocationCount() const
+		{
+			if (this->isFileBacked())
+			{
+				return this->getAllocatedPageCount(); // the file never shares pages
+			}
+
+			std::set<Payload*> uniquePages;
+			std::lock_guard<std::mutex> pageMapLock(*this->PageMapMutex);
+			for (auto &indexAndPage : this->PageIndexToPage)
+			{
+				uniquePages.insert(indexAndPage.second.get());
+			}
+			return uniquePages.size();
+		}
+
+		void SparseMedia::deduplicatePage(UINT_64 pageIndex, const std::shared_ptr<Payload>& page)
+		{
+			const BYTE* pageBuffer = page->getBuffer();
+
+			bool pageIsAllZeros = true;
+			for (size_t byteIndex = 0; byteIndex < SPARSE_MEDIA_PAGE_SIZE; byteIndex++)
+			{
+				if (pageBuffer[byteIndex] != 0)
+				{
+					pageIsAllZeros = false;
+					break;
+				}
+			}
+
+			if (pageIsAllZeros)
+			{
+				// absent pages read back as zeros, so a zeroed page doesn't need an allocation at all
+				this->PageIndexToPage.erase(pageIndex);
+				return;
+			}
+
+			auto &indexSlot = this->ContentHashToPage[hashPageContents(pageBuffer)];
+			auto existingPage = indexSlot.lock();
+			if (existingPage && existingPage != page && memcmp(existingPage->getBuffer(), pageBuffer, SPARSE_MEDIA_PAGE_SIZE) == 0)
+			{
+				// identical contents already allocated: share that allocation. A later write
+				//  to either page index copy-on-writes off of it, same as with snapshots. The
+				//  compare is safe because every dedup-enabled write mutates its page under
+				//  the page map lock, which we hold
+				this->PageIndexToPage[pageIndex] = existingPage;
+			}
+			else
+			{
+				// first page with these contents (or the old one is gone): index it
+				indexSlot = page;
+			}
+		}
+
+		UINT_64 SparseMedia::getAllocatedPageCount() const
+		{
+#ifndef _WIN32
+			if (this->isFileBacked())
+			{
+				struct stat fileInfo = { 0 };
+				fstat(this->BackingFileDescriptor, &fileInfo);
+				return ((UINT_64)fileInfo.st_blocks * 512) / SPARSE_MEDIA_PAGE_SIZE; // st_blocks is in 512 byte units
+			}
+#endif // !_WIN32
+
+			return this->PageIndexToPage.size();
+		}
+	}
+}
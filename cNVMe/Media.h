@@ -0,0 +1,230 @@
+/*
+###########################################################################################
+// cNVMe - An Open Source NVMe Device Simulation - MIT License
+// Copyright 2018 - Intel Corporation
+
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+// INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+// PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+// LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT
+// OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+// OTHER DEALINGS IN THE SOFTWARE.
+############################################################################################
+Media.h - A header file for sparse namespace media
+*/
+
+#pragma once
+
+#include "Types.h"
+
+#define SPARSE_MEDIA_PAGE_SIZE 4096 // bytes of media backed by a single allocation
+
+namespace cnvme
+{
+	namespace ns
+	{
+		/// <summary>
+		/// A point-in-time capture of heap backed media: page index to a shared reference
+		/// on the page's allocation. Pages are shared with the live media copy-on-write,
+		/// so taking or restoring a snapshot never copies page data.
+		/// </summary>
+		typedef std::map<UINT_64, std::shared_ptr<Payload>> MEDIA_SNAPSHOT;
+
+		/// <summary>
+		/// SparseMedia is a page-indexed media backing store.
+		/// Pages are only allocated when they are first written, so a very large
+		/// namespace that is mostly unwritten costs almost no memory. Reads of
+		/// unwritten ranges return zeros without allocating anything.
+		/// </summary>
+		class SparseMedia
+		{
+		public:
+			/// <summary>
+			/// Constructor for empty (zero-sized) media
+			/// </summary>
+			SparseMedia();
+
+			/// <summary>
+			/// Constructor for media with the given logical size. No pages are allocated yet.
+			/// </summary>
+			/// <param name="sizeInBytes">Logical size of the media in bytes</param>
+			SparseMedia(UINT_64 sizeInBytes);
+
+			/// <summary>
+			/// Constructor for media backed by a memory mapped sparse file instead of the heap.
+			/// The file is created if it doesn't exist and its contents persist across runs,
+			/// so a namespace can pick up where a previous process left off. The OS pages the
+			/// data in and out as needed, so large namespaces don't have to live in RAM.
+			/// </summary>
+			/// <param name="sizeInBytes">Logical size of the media in bytes</param>
+			/// <param name="backingFilePath">Path to the backing file</param>
+			SparseMedia(UINT_64 sizeInBytes, const std::string &backingFilePath);
+
+			/// <summary>
+			/// Destructor for the media
+			/// </summary>
+			~SparseMedia();
+
+			/// <summary>
+			/// Returns True if this media is backed by a memory mapped file
+			/// </summary>
+			/// <returns>Boolean</returns>
+			bool isFileBacked() const;
+
+			/// <summary>
+			/// Returns the logical size of the media in bytes
+			/// </summary>
+			/// <returns>size in bytes</returns>
+			UINT_64 getSize() const;
+
+			/// <summary>
+			/// Reads length bytes starting at the given byte offset into the given buffer.
+			/// Ranges that have never been written read back as zeros.
+			/// </summary>
+			/// <param name="offset">Byte offset into the media</param>
+			/// <param name="buffer">Destination buffer</param>
+			/// <param name="length">Number of bytes to read</param>
+			void read(UINT_64 offset, BYTE* buffer, UINT_64 length);
+
+			/// <summary>
+			/// Writes length bytes from the given buffer starting at the given byte offset.
+			/// Pages covering the range are allocated on first touch.
+			/// </summary>
+			/// <param name="offset">Byte offset into the media</param>
+			/// <param name="buffer">Source buffer</param>
+			/// <param name="length">Number of bytes to write</param>
+			void write(UINT_64 offset, const BYTE* buffer, UINT_64 length);
+
+			/// <summary>
+			/// Drops all allocated pages. The media keeps its logical size and reads back as zeros.
+			/// </summary>
+			void eraseAll();
+
+			/// <summary>
+			/// Captures the current pages as a copy-on-write snapshot. O(allocated pages)
+			/// reference bumps; no page data is copied. Only supported for heap backed media
+			/// (the page-indexed layout); file backed media has no page map to share.
+			/// </summary>
+			/// <returns>The snapshot</returns>
+			MEDIA_SNAPSHOT snapshot();
+
+			/// <summary>
+			/// Replaces the current pages with the given snapshot's. Pages the media still
+			/// shares with the snapshot cost nothing; only pages written since the snapshot
+			/// was taken get dropped/swapped, so a restore is as cheap as the amount of
+			/// change being undone.
+			/// </summary>
+			/// <param name="mediaSnapshot">Snapshot to restore</param>
+			void restore(const MEDIA_SNAPSHOT& mediaSnapshot);
+
+			/// <summary>
+			/// Turns page-level deduplication on or off. When on, a page whose contents
+			/// match an already allocated page gets pointed at that page's allocation
+			/// instead of keeping its own, and a page written to all zeros gets dropped
+			/// entirely (absent pages already read back as zeros). Writers copy shared
+			/// pages before modifying them, so deduplication is invisible to readers.
+			/// Only supported for heap backed media.
+			/// </summary>
+			/// <param name="enabled">True to deduplicate pages as they are written</param>
+			void setDeduplicationEnabled(bool enabled);
+
+			/// <summary>
+			/// Returns the number of distinct page allocations backing the media. With
+			/// deduplication on this can be much smaller than getAllocatedPageCount().
+			/// Mostly useful for sanity checks and tests.
+			/// </summary>
+			/// <returns>number of distinct page allocations</returns>
+			UINT_64 getUniquePageAllocationCount() const;
+
+			/// <summary>
+			/// Returns the number of pages that are currently backed by an allocation.
+			/// Mostly useful for sanity checks and tests.
+			/// </summary>
+			/// <returns>number of allocated pages</returns>
+			UINT_64 getAllocatedPageCount() const;
+
+		private:
+
+			/// <summary>
+			/// Logical size of the media in bytes
+			/// </summary>
+			UINT_64 SizeInBytes;
+
+			/// <summary>
+			/// Map from page index (offset / SPARSE_MEDIA_PAGE_SIZE) to the page's allocation.
+			/// Pages not in the map are logically all zeros. Unused when file backed.
+			/// A page's allocation may be shared with snapshots/clones: writers copy the
+			/// page first whenever anyone else still references it (copy-on-write).
+			/// </summary>
+			MEDIA_SNAPSHOT PageIndexToPage;
+
+			/// <summary>
+			/// Guards the shape of PageIndexToPage so concurrent IO to disjoint ranges can
+			/// look up / allocate pages safely. Page contents are protected by the
+			/// namespace's LBA range locks, not this mutex. Held by shared_ptr because
+			/// SparseMedia gets copied around (and mutexes can't be).
+			/// </summary>
+			std::shared_ptr<std::mutex> PageMapMutex;
+
+			/// <summary>
+			/// True if pages should be deduplicated as they are written
+			/// </summary>
+			bool DeduplicationEnabled;
+
+			/// <summary>
+			/// Map from a hash of a page's contents to the page that had those contents.
+			/// Only an index: weak references so it never keeps dead pages alive, and a
+			/// hash hit is always verified with a byte compare before pages are shared.
+			/// Guarded by PageMapMutex. Unused unless deduplication is enabled.
+			/// </summary>
+			std::map<UINT_64, std::weak_ptr<Payload>> ContentHashToPage;
+
+			/// <summary>
+			/// Looks up the page for the given index, allocating it on first touch and
+			/// splitting it copy-on-write if anything else still references it.
+			/// The caller must hold PageMapMutex.
+			/// </summary>
+			/// <param name="pageIndex">Index of the page about to be written</param>
+			/// <returns>The page the write should land in</returns>
+			std::shared_ptr<Payload> getWritablePage(UINT_64 pageIndex);
+
+			/// <summary>
+			/// Points the given page index at an existing allocation with identical
+			/// contents (or drops it if it is all zeros). Called after a write lands;
+			/// the caller must hold PageMapMutex across both the write and this call,
+			/// so pages can't change contents mid-compare.
+			/// </summary>
+			/// <param name="pageIndex">Index of the page that was just written</param>
+			/// <param name="page">The allocation the write landed in</param>
+			void deduplicatePage(UINT_64 pageIndex, const std::shared_ptr<Payload>& page);
+
+			/// <summary>
+			/// Pointer to the memory mapped backing file. NULL when heap backed.
+			/// </summary>
+			BYTE* MappedBuffer;
+
+			/// <summary>
+			/// Keeps the file mapping alive for as long as any copy of this media exists.
+			/// Unmaps and closes the file when the last copy goes away.
+			/// </summary>
+			std::shared_ptr<void> BackingFileMapping;
+
+#ifndef _WIN32
+			/// <summary>
+			/// File descriptor for the backing file. Used to punch holes on erase.
+			/// </summary>
+			int BackingFileDescriptor;
+#endif // !_WIN32
+		};
+	}
+}
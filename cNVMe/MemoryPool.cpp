@@ -0,0 +1,123 @@
+/*
+###########################################################################################
+// cNVMe - An Open Source NVMe Device Simulation - MIT License
+// Copyright 2018 - Intel Corporation
+
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+// INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+// PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+// LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT
+// OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+// OTHER DEALINGS IN THE SOFTWARE.
+############################################################################################
+MemoryPool.cpp - An implementation file for the command-path memory pool
+*/
+
+#include "MemoryPool.h"
+
+namespace cnvme
+{
+	namespace pool
+	{
+		MemoryPool thePool;
+
+		MemoryPool::MemoryPool()
+		{
+			// nothing cached yet.
+		}
+
+		MemoryPool::~MemoryPool()
+		{
+			drain();
+		}
+
+		BYTE* MemoryPool::acquire(size_t byteSize)
+		{
+			if (byteSize == 0)
+			{
+				return nullptr;
+			}
+
+			size_t bucketSize = getBucketSize(byteSize);
+			if (bucketSize != 0)
+			{
+				std::lock_guard<std::mutex> poolLock(this->Mutex);
+				auto& freeBlocks = this->BucketSizeToFreeBlocks[bucketSize];
+				if (!freeBlocks.empty())
+				{
+					BYTE* block = freeBlocks.back();
+					freeBlocks.pop_back();
+					memset(block, 0, bucketSize); // recycled blocks hold stale data; callers expect zeros
+					return block;
+				}
+			}
+
+			// nothing cached (or not a pooled size): go to the heap.
+			// Allocate the full bucket so the block is recyclable on release.
+			size_t allocationSize = (bucketSize != 0) ? bucketSize : byteSize;
+			BYTE* block = new BYTE[allocationSize];
+			memset(block, 0, allocationSize);
+			return block;
+		}
+
+		void MemoryPool::release(BYTE* pointer, size_t byteSize)
+		{
+			if (pointer == nullptr)
+			{
+				return;
+			}
+
+			size_t bucketSize = getBucketSize(byteSize);
+			if (bucketSize != 0)
+			{
+				std::lock_guard<std::mutex> poolLock(this->Mutex);
+				auto& freeBlocks = this->BucketSizeToFreeBlocks[bucketSize];
+				if (freeBlocks.size() < MEMORY_POOL_MAX_CACHED_BLOCKS_PER_BUCKET)
+				{
+					freeBlocks.push_back(pointer);
+					return;
+				}
+			}
+
+			delete[] pointer;
+		}
+
+		void MemoryPool::drain()
+		{
+			std::lock_guard<std::mutex> poolLock(this->Mutex);
+			for (auto& bucket : this->BucketSizeToFreeBlocks)
+			{
+				for (BYTE* block : bucket.second)
+				{
+					delete[] block;
+				}
+			}
+			this->BucketSizeToFreeBlocks.clear();
+		}
+
+		size_t MemoryPool::getBucketSize(size_t byteSize)
+		{
+			if (byteSize > MEMORY_POOL_MAX_BLOCK_SIZE)
+			{
+				return 0; // too big to be worth caching
+			}
+
+			size_t bucketSize = MEMORY_POOL_MIN_BLOCK_SIZE;
+			while (bucketSize < byteSize)
+			{
+				bucketSize <<= 1;
+			}
+			return bucketSize;
+		}
+	}
+}
@@ -0,0 +1,114 @@
+/*
+###########################################################################################
+// cNVMe - An Open Source NVMe Device Simulation - MIT License
+// Copyright 2018 - Intel Corporation
+
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+// INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+// PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+// LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT
+// OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+// OTHER DEALINGS IN THE SOFTWARE.
+############################################################################################
+MemoryPool.h - A header file for the command-path memory pool
+*/
+
+#pragma once
+
+#include "Types.h"
+
+/// <summary>
+/// Largest block size the pool will cache. Bigger allocations go straight to the heap.
+/// </summary>
+#define MEMORY_POOL_MAX_BLOCK_SIZE (1024 * 1024)
+
+/// <summary>
+/// Smallest bucket size. Tiny allocations round up to this so they stay recyclable.
+/// </summary>
+#define MEMORY_POOL_MIN_BLOCK_SIZE 512
+
+/// <summary>
+/// Max free blocks cached per bucket, to bound how much memory the pool holds onto.
+/// </summary>
+#define MEMORY_POOL_MAX_CACHED_BLOCKS_PER_BUCKET 128
+
+namespace cnvme
+{
+	namespace pool
+	{
+		/// <summary>
+		/// MemoryPool recycles the fixed-size buffers the command path churns through
+		/// (PRP pages, Payload data, completion scratch) instead of hitting the heap
+		/// per command. Blocks are bucketed by power-of-two size. Every block is a
+		/// plain new[] allocation, so a block that escapes the pool can still be
+		/// delete[]'d safely; it just won't get recycled.
+		/// </summary>
+		class MemoryPool
+		{
+		public:
+			/// <summary>
+			/// Constructor. Starts with nothing cached.
+			/// </summary>
+			MemoryPool();
+
+			/// <summary>
+			/// Destructor. Frees all cached blocks.
+			/// </summary>
+			~MemoryPool();
+
+			/// <summary>
+			/// Gets a zeroed block of at least byteSize bytes, recycled if one is cached.
+			/// </summary>
+			/// <param name="byteSize">Number of bytes needed</param>
+			/// <returns>Pointer to the block (nullptr for a 0 size)</returns>
+			BYTE* acquire(size_t byteSize);
+
+			/// <summary>
+			/// Returns a block from acquire() to the pool. Pass the same byteSize that
+			/// was given to acquire(). Non-pooled sizes (and full buckets) get freed.
+			/// </summary>
+			/// <param name="pointer">Pointer from acquire()</param>
+			/// <param name="byteSize">The byteSize passed to acquire()</param>
+			void release(BYTE* pointer, size_t byteSize);
+
+			/// <summary>
+			/// Frees every cached block. Mostly for tests/leak checking.
+			/// </summary>
+			void drain();
+
+		private:
+
+			/// <summary>
+			/// Gets the bucket (block) size for a requested size, or 0 if the size isn't pooled.
+			/// </summary>
+			/// <param name="byteSize">Requested size</param>
+			/// <returns>Power-of-two bucket size, or 0 for not pooled</returns>
+			size_t getBucketSize(size_t byteSize);
+
+			/// <summary>
+			/// Free blocks, keyed by bucket size
+			/// </summary>
+			std::map<size_t, std::vector<BYTE*>> BucketSizeToFreeBlocks;
+
+			/// <summary>
+			/// Guards BucketSizeToFreeBlocks
+			/// </summary>
+			std::mutex Mutex;
+		};
+
+		/// <summary>
+		/// Global memory pool instance, shared by all controllers and drivers
+		/// </summary>
+		extern MemoryPool thePool;
+	}
+}
@@ -26,7 +26,6 @@ Namespace.cpp - An implementation file for a cNVMe Namespace
 #include "Constants.h"
 #include "Namespace.h"
 #include "PRP.h"
-#include "Tests.h"
 
 #define DEFAULT_NUMBER_OF_LBA_FORMAT 2; // 0-based!
 #define IEEE_OUI 0xCCAACC
@@ -39,13 +38,19 @@ namespace cnvme
 	{
 		Namespace::Namespace()
 		{
+			this->RangeLockState = std::make_shared<RANGE_LOCK_STATE>();
 			memset(&this->IdentifyNamespace, 0, sizeof(this->IdentifyNamespace));
 			this->getIdentifyNamespaceStructure(); // make sure we are setup.
 		}
 
 		Namespace::Namespace(size_t SizeInBytes) : Namespace()
 		{
-			Media = Payload(SizeInBytes);
+			Media = SparseMedia(SizeInBytes);
+		}
+
+		Namespace::Namespace(size_t SizeInBytes, const std::string &backingFilePath) : Namespace()
+		{
+			Media = SparseMedia(SizeInBytes, backingFilePath);
 		}
 
 		Namespace::~Namespace()
@@ -126,31 +131,32 @@ namespace cnvme
 			// update or current lba format
 			this->IdentifyNamespace.FLBAS.CurrentLBAFormat = nvmeCommand.DW10_Format.LBAF;
 
-			// delete the 'key'... in our case delete the Media and recreate it.
+			// delete the 'key'... in our case drop every allocated media page.
+			// Per NVMe spec the controller can do whatever here as long as the data is gone.
+			// With sparse media, deallocating the pages destroys the data and the namespace
+			// reads back as zeros, which covers all of the secure erase settings.
 			if (nvmeCommand.DW10_Format.SES == constants::commands::format::ses::CRYPTOGRAPHIC_ERASE)
 			{
 				LOG_INFO("Performing a crypto erase");
-				this->Media = Payload(Media.getSize());
 			}
 			else if (nvmeCommand.DW10_Format.SES == constants::commands::format::ses::USER_DATA_ERASE)
 			{
 				LOG_INFO("Performing a user data erase");
-				// Per NVMe spec the controller can do whatever here as long as the data is gone... so we shall do some randomization.
-				for (size_t i = 0; i < 8; i++) // 8 is a number i picked without much reason.
-				{
-					tests::helpers::randomizePayload(this->Media);
-				}
 			}
 			else
 			{
 				LOG_INFO("Performing a non-secure erase");
-				memset(this->Media.getBuffer(), 0x00, this->Media.getSize());
+			}
+			{
+				// Format conflicts with everything: take an exclusive lock over the whole media
+				SCOPED_BYTE_RANGE_LOCK rangeLock(*this, 0, this->Media.getSize(), true);
+				this->Media.eraseAll();
 			}
 
 			return completionQueueEntry;
 		}
 
-		command::COMPLETION_QUEUE_ENTRY Namespace::read(command::NVME_COMMAND nvmeCommand, Payload &outputPayload)
+		command::COMPLETION_QUEUE_ENTRY Namespace::read(command::NVME_COMMAND nvmeCommand, UINT_32 memoryPageSize)
 		{
 			command::COMPLETION_QUEUE_ENTRY completionQueueEntry = { 0 };
 
@@ -170,8 +176,15 @@ namespace cnvme
 			UINT_64 transferSize = this->getSectorSize() * ONE_BASED_FROM_ZERO_BASED(nvmeCommand.DW12_IO.NLB);
 			UINT_64 byteOffset = this->getSectorSize() * nvmeCommand.SLBA;
 
-			// Give data back
-			outputPayload = Payload(this->Media.getBuffer() + byteOffset, (size_t)transferSize);
+			// Give data back: read the media directly into the PRP pages (no intermediate payload).
+			// The shared range lock lets concurrent reads overlap while keeping writers to this range out.
+			SCOPED_BYTE_RANGE_LOCK rangeLock(*this, byteOffset, transferSize, false);
+			PRP prps(nvmeCommand.DPTR.DPTR1, nvmeCommand.DPTR.DPTR2, (size_t)transferSize, memoryPageSize);
+			for (auto &segment : prps.getDataSegments())
+			{
+				this->Media.read(byteOffset, segment.first, segment.second);
+				byteOffset += segment.second;
+			}
 
 			return completionQueueEntry;
 		}
@@ -196,16 +209,96 @@ namespace cnvme
 			UINT_64 transferSize = this->getSectorSize() * ONE_BASED_FROM_ZERO_BASED(nvmeCommand.DW12_IO.NLB);
 			UINT_64 byteOffset = this->getSectorSize() * nvmeCommand.SLBA;
 
-			// Get data from PRPs
+			// Get data from PRPs: write the PRP pages directly into the media (no intermediate payload).
+			// The exclusive range lock covers just this command's bytes, so writes to disjoint ranges run in parallel.
+			SCOPED_BYTE_RANGE_LOCK rangeLock(*this, byteOffset, transferSize, true);
 			PRP prps(nvmeCommand.DPTR.DPTR1, nvmeCommand.DPTR.DPTR2, (size_t)transferSize, memoryPageSize);
-			auto inputPayload = prps.getPayloadCopy();
-
-			// Give data back
-			memcpy_s(this->Media.getBuffer() + byteOffset, (size_t)(this->Media.getSize() - byteOffset), inputPayload.getBuffer(), (size_t)transferSize);
+			for (auto &segment : prps.getDataSegments())
+			{
+				this->Media.write(byteOffset, segment.first, segment.second);
+				byteOffset += segment.second;
+			}
 
 			return completionQueueEntry;
 		}
 
+		Namespace::NAMESPACE_SNAPSHOT Namespace::snapshot()
+		{
+			// the exclusive range lock drains in-flight IO so the capture is consistent
+			SCOPED_BYTE_RANGE_LOCK rangeLock(*this, 0, this->Media.getSize(), true);
+
+			NAMESPACE_SNAPSHOT namespaceSnapshot;
+			namespaceSnapshot.IdentifyNamespace = this->IdentifyNamespace;
+			namespaceSnapshot.MediaPages = this->Media.snapshot();
+			return namespaceSnapshot;
+		}
+
+		void Namespace::restore(const NAMESPACE_SNAPSHOT& namespaceSnapshot)
+		{
+			SCOPED_BYTE_RANGE_LOCK rangeLock(*this, 0, this->Media.getSize(), true);
+
+			this->IdentifyNamespace = namespaceSnapshot.IdentifyNamespace;
+			this->Media.restore(namespaceSnapshot.MediaPages);
+		}
+
+		Namespace Namespace::clone()
+		{
+			auto currentSnapshot = this->snapshot();
+
+			// Build the clone from scratch (own lock table / page map mutex) and then
+			//  point it at the captured state. It shares pages until either side writes.
+			Namespace clonedNamespace(this->Media.getSize());
+			clonedNamespace.IdentifyNamespace = currentSnapshot.IdentifyNamespace;
+			clonedNamespace.Media.restore(currentSnapshot.MediaPages);
+			return clonedNamespace;
+		}
+
+		void Namespace::setMediaDeduplicationEnabled(bool enabled)
+		{
+			this->Media.setDeduplicationEnabled(enabled);
+		}
+
+		void Namespace::lockByteRange(UINT_64 startByte, UINT_64 lengthInBytes, bool exclusive)
+		{
+			UINT_64 endByte = startByte + lengthInBytes;
+
+			std::unique_lock<std::mutex> rangeLock(this->RangeLockState->Mutex);
+			this->RangeLockState->Condition.wait(rangeLock, [&]() -> bool
+			{
+				for (auto &activeRange : this->RangeLockState->ActiveByteRanges)
+				{
+					bool overlaps = (startByte < activeRange.EndByte) && (activeRange.StartByte < endByte);
+					if (overlaps && (exclusive || activeRange.Exclusive))
+					{
+						return false; // conflict: readers wait for writers, writers wait for everyone
+					}
+				}
+				return true;
+			});
+
+			this->RangeLockState->ActiveByteRanges.push_back(ACTIVE_BYTE_RANGE{ startByte, endByte, exclusive });
+		}
+
+		void Namespace::unlockByteRange(UINT_64 startByte, UINT_64 lengthInBytes, bool exclusive)
+		{
+			UINT_64 endByte = startByte + lengthInBytes;
+
+			{
+				std::unique_lock<std::mutex> rangeLock(this->RangeLockState->Mutex);
+				for (auto itr = this->RangeLockState->ActiveByteRanges.begin(); itr != this->RangeLockState->ActiveByteRanges.end(); itr++)
+				{
+					if (itr->StartByte == startByte && itr->EndByte == endByte && itr->Exclusive == exclusive)
+					{
+						this->RangeLockState->ActiveByteRanges.erase(itr);
+						this->RangeLockState->Condition.notify_all();
+						return;
+					}
+				}
+			}
+
+			ASSERT("Tried to unlock a byte range that was not locked");
+		}
+
 		UINT_64 Namespace::getNamespaceSizeInSectors()
 		{
 			UINT_32 sectorSize = this->getSectorSize();
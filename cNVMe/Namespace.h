@@ -27,6 +27,7 @@ Namespace.h - A header file for a cNVMe Namespace
 
 #include "Command.h"
 #include "Identify.h"
+#include "Media.h"
 
 #define DEFAULT_SECTOR_SIZE 512
 
@@ -47,6 +48,15 @@ namespace cnvme
 			/// </summary>
 			Namespace(size_t SizeInBytes);
 
+			/// <summary>
+			/// Constructor for a namespace whose media is backed by a memory mapped file.
+			/// The media persists across runs via the backing file, and format punches
+			/// holes in the file instead of keeping zeroed blocks around.
+			/// </summary>
+			/// <param name="SizeInBytes">Size of the namespace in bytes</param>
+			/// <param name="backingFilePath">Path to the media backing file</param>
+			Namespace(size_t SizeInBytes, const std::string &backingFilePath);
+
 			/// <summary>
 			/// Destructor for namespace
 			/// </summary>
@@ -72,12 +82,13 @@ namespace cnvme
 			command::COMPLETION_QUEUE_ENTRY formatNVM(command::NVME_COMMAND nvmeCommand);
 
 			/// <summary>
-			/// Performs an NVM Read command on the given namespace
+			/// Performs an NVM Read command on the given namespace.
+			/// Scatters the media directly into the command's PRPs.
 			/// </summary>
 			/// <param name="nvmeCommand">Complete NVMe command for the read</param>
-			/// <param name="outputPayload">Data read out</param>
+			/// <param name="memoryPageSize">size of the memory page</param>
 			/// <returns>Completion queue entry for command</returns>
-			command::COMPLETION_QUEUE_ENTRY read(command::NVME_COMMAND nvmeCommand, Payload& outputPayload);
+			command::COMPLETION_QUEUE_ENTRY read(command::NVME_COMMAND nvmeCommand, UINT_32 memoryPageSize);
 
 			/// <summary>
 			/// Performs an NVM Write command on the given namespace
@@ -87,8 +98,116 @@ namespace cnvme
 			/// <returns>Completion queue entry for command</returns>
 			command::COMPLETION_QUEUE_ENTRY write(command::NVME_COMMAND nvmeCommand, UINT_32 memoryPageSize);
 
+			/// <summary>
+			/// A point-in-time capture of this namespace: its identify data and a
+			/// copy-on-write reference to every allocated media page
+			/// </summary>
+			typedef struct NAMESPACE_SNAPSHOT
+			{
+				identify::structures::IDENTIFY_NAMESPACE IdentifyNamespace;	// Identify data at capture time
+				MEDIA_SNAPSHOT MediaPages;									// Copy-on-write page references
+			} NAMESPACE_SNAPSHOT;
+
+			/// <summary>
+			/// Captures the namespace's current state. No page data is copied: later writes
+			/// copy the touched page first, so the snapshot stays frozen at capture time.
+			/// Takes the whole-media write lock, so in-flight IO finishes first.
+			/// Only supported for heap backed (non file backed) namespaces.
+			/// </summary>
+			/// <returns>NAMESPACE_SNAPSHOT to later restore() or keep around</returns>
+			NAMESPACE_SNAPSHOT snapshot();
+
+			/// <summary>
+			/// Rewinds the namespace to the given snapshot. Cost scales with how much was
+			/// written since the snapshot was taken, not with the namespace size.
+			/// </summary>
+			/// <param name="namespaceSnapshot">Snapshot to rewind to</param>
+			void restore(const NAMESPACE_SNAPSHOT& namespaceSnapshot);
+
+			/// <summary>
+			/// Builds an independent namespace starting from this one's current state.
+			/// The two share unmodified pages copy-on-write, so a clone is near-free no
+			/// matter how much data the original holds.
+			/// </summary>
+			/// <returns>The cloned namespace</returns>
+			Namespace clone();
+
+			/// <summary>
+			/// Turns page-level media deduplication on or off for this namespace.
+			/// With it on, pages with identical contents share one allocation and
+			/// zeroed pages cost nothing, which keeps hosts running many namespaces
+			/// with repetitive data from paying for every copy.
+			/// </summary>
+			/// <param name="enabled">True to deduplicate media pages as they are written</param>
+			void setMediaDeduplicationEnabled(bool enabled);
+
 		private:
 
+			/// <summary>
+			/// A byte range some command currently holds a lock on
+			/// </summary>
+			typedef struct ACTIVE_BYTE_RANGE
+			{
+				UINT_64 StartByte;		// First byte of the locked range
+				UINT_64 EndByte;		// One past the last byte of the locked range
+				bool Exclusive;			// true for writers, false for readers
+			} ACTIVE_BYTE_RANGE;
+
+			/// <summary>
+			/// Blocks until the given byte range can be locked: readers only wait for
+			/// overlapping writers, writers wait for any overlap. Disjoint ranges never wait,
+			/// so IO to different parts of the namespace runs in parallel.
+			/// </summary>
+			/// <param name="startByte">First byte of the range</param>
+			/// <param name="lengthInBytes">Length of the range</param>
+			/// <param name="exclusive">true for writes, false for reads</param>
+			void lockByteRange(UINT_64 startByte, UINT_64 lengthInBytes, bool exclusive);
+
+			/// <summary>
+			/// Releases a range taken with lockByteRange (same arguments)
+			/// </summary>
+			/// <param name="startByte">First byte of the range</param>
+			/// <param name="lengthInBytes">Length of the range</param>
+			/// <param name="exclusive">The exclusive flag the range was locked with</param>
+			void unlockByteRange(UINT_64 startByte, UINT_64 lengthInBytes, bool exclusive);
+
+			/// <summary>
+			/// RAII wrapper for lockByteRange/unlockByteRange
+			/// </summary>
+			struct SCOPED_BYTE_RANGE_LOCK
+			{
+				SCOPED_BYTE_RANGE_LOCK(Namespace& owner, UINT_64 startByte, UINT_64 lengthInBytes, bool exclusive) :
+					Owner(owner), StartByte(startByte), LengthInBytes(lengthInBytes), Exclusive(exclusive)
+				{
+					Owner.lockByteRange(StartByte, LengthInBytes, Exclusive);
+				}
+				~SCOPED_BYTE_RANGE_LOCK()
+				{
+					Owner.unlockByteRange(StartByte, LengthInBytes, Exclusive);
+				}
+				Namespace& Owner;
+				UINT_64 StartByte;
+				UINT_64 LengthInBytes;
+				bool Exclusive;
+			};
+
+			/// <summary>
+			/// The lockable state behind lockByteRange. Held by shared_ptr because
+			/// Namespace objects get copied around (and mutexes can't be); copies share
+			/// the same lock table, which is what you'd want anyway.
+			/// </summary>
+			typedef struct RANGE_LOCK_STATE
+			{
+				std::list<ACTIVE_BYTE_RANGE> ActiveByteRanges;	// Ranges currently locked
+				std::mutex Mutex;								// Guards ActiveByteRanges
+				std::condition_variable Condition;				// Signaled when a range unlocks
+			} RANGE_LOCK_STATE;
+
+			/// <summary>
+			/// This namespace's range lock table
+			/// </summary>
+			std::shared_ptr<RANGE_LOCK_STATE> RangeLockState;
+
 			/// <summary>
 			/// Gets this namespace's size in sectors. The sector size is variable and should be grabbed from the ID namespace structure
 			/// </summary>
@@ -107,9 +226,10 @@ namespace cnvme
 			identify::structures::IDENTIFY_NAMESPACE IdentifyNamespace;
 
 			/// <summary>
-			/// Internal managed media
+			/// Internal managed media. Sparse: pages are only allocated once written,
+			/// so large namespaces are cheap until they actually hold data.
 			/// </summary>
-			Payload Media;
+			SparseMedia Media;
 		};
 	}
 }
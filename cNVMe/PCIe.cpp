@@ -860,13 +860,21 @@ namespace cnvme
 			return retStr;
 		}
 
-		PCIExpressRegisters::PCIExpressRegisters()
+		PCIExpressRegisters::PCIExpressRegisters() : PCIExpressRegisters(nullptr)
 		{
+		}
+
+		PCIExpressRegisters::PCIExpressRegisters(cnvme::WatcherPool* watcherPool)
+		{
+			CachedParsedRegistersValid = false;
+
+			// Bring the registers up inline so construction doesn't have to handshake with
+			//  a watcher thread; the watcher starts lazily on the first change wait/notify
+			functionLevelReset();
+
 #ifndef SINGLE_THREADED
 			RegisterWatcher = LoopingThread([&] {PCIExpressRegisters::checkForChanges(); }, CHANGE_CHECK_SLEEP_MS);
-			RegisterWatcher.start();
-#else
-			functionLevelReset();
+			RegisterWatcher.setPool(watcherPool);
 #endif
 		}
 
@@ -880,6 +888,7 @@ namespace cnvme
 			LOG_INFO("Beginning function level reset.");
 
 			PciHeaderAndCapabilities = cnvme::Payload(sizeof(PCI_HEADER) + CAPABILITIES_SIZE);
+			CachedParsedRegistersValid = false; // the buffer just changed out from under any cached parse
 			PCI_HEADER* PciHeader = getPciHeader();
 
 			PciHeader->ID.DID = 0xCCAA;
@@ -1005,12 +1014,21 @@ namespace cnvme
 
 		void PCIExpressRegisters::writeHeaderAndCapabilities(const cnvme::Payload& payload)
 		{
-			// Update registers
+			// Update registers. The assignment gets a fresh buffer, so cached pointers die here.
 			PciHeaderAndCapabilities = payload;
+			CachedParsedRegistersValid = false;
+
+			// React to the write now instead of on the watcher's next poll
+			notifyChange();
 		}
 
 		PCI_EXPRESS_REGISTERS PCIExpressRegisters::getPciExpressRegisters()
 		{
+			if (CachedParsedRegistersValid)
+			{
+				return CachedParsedRegisters; // pointers are stable until the payload is replaced
+			}
+
 			PCI_EXPRESS_REGISTERS Registers = { 0 };
 			Registers.PciHeader = getPciHeader();
 
@@ -1078,11 +1096,17 @@ namespace cnvme
 				}
 			}
 
+			// Remember the parse so steady-state callers skip the capability walks
+			CachedParsedRegisters = Registers;
+			CachedParsedRegistersValid = true;
+
 			return Registers;
 		}
 
 		void PCIExpressRegisters::checkForChanges()
 		{
+			// Registers are written as raw memory (hosts poke fields through pointers), so there
+			//  is no write hook to gate on; the cached parse makes this a single field test.
 			auto regs = getPciExpressRegisters();
 
 			// If we can't find PXCAP or IFLR was set to 1 do the function level reset
@@ -1092,15 +1116,34 @@ namespace cnvme
 			}
 		}
 
+		void PCIExpressRegisters::startRegisterWatcher()
+		{
+#ifndef SINGLE_THREADED
+			std::lock_guard<std::mutex> startLock(WatcherStartMutex);
+			RegisterWatcher.start(); // no-op if already running
+#endif
+		}
+
 		void PCIExpressRegisters::waitForChangeLoop()
 		{
 #ifndef SINGLE_THREADED
+			startRegisterWatcher();
 			RegisterWatcher.waitForFlip();
 #else
 			checkForChanges();
 #endif
 		}
 
+		void PCIExpressRegisters::notifyChange()
+		{
+#ifndef SINGLE_THREADED
+			startRegisterWatcher();
+			RegisterWatcher.wakeUp();
+#else
+			checkForChanges();
+#endif
+		}
+
 		PCI_HEADER* PCIExpressRegisters::getPciHeader()
 		{
 			return (PCI_HEADER*)PciHeaderAndCapabilities.getBuffer();
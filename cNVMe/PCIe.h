@@ -836,6 +836,13 @@ namespace cnvme
 			/// </summary>
 			PCIExpressRegisters();
 
+			/// <summary>
+			/// Constructor that runs the register watcher on a shared pool instead of a
+			/// dedicated thread. Pass nullptr for the dedicated-thread behavior.
+			/// </summary>
+			/// <param name="watcherPool">Pool for the register watcher, or nullptr</param>
+			PCIExpressRegisters(cnvme::WatcherPool* watcherPool);
+
 			/// <summary>
 			/// Destructor
 			/// </summary>
@@ -864,11 +871,25 @@ namespace cnvme
 			/// </summary>
 			void checkForChanges();
 
+			/// <summary>
+			/// Starts the register watcher thread if it isn't already running. The
+			/// constructor defers this so bring-up doesn't pay a watcher handshake;
+			/// the first change wait/notify (or the owning controller's first register
+			/// handout) starts it.
+			/// </summary>
+			void startRegisterWatcher();
+
 			/// <summary>
 			/// Waits till the loop goes
 			/// </summary>
 			void waitForChangeLoop();
 
+			/// <summary>
+			/// Wakes the register watcher right away instead of waiting for its next poll.
+			/// Called when someone (like the Driver) knows they just wrote a register.
+			/// </summary>
+			void notifyChange();
+
 		private:
 			/// <summary>
 			/// The private implementation of the BAR memory.
@@ -882,6 +903,18 @@ namespace cnvme
 			/// </summary>
 			cnvme::Payload PciHeaderAndCapabilities;
 
+			/// <summary>
+			/// Parsed pointers into PciHeaderAndCapabilities, so the watcher doesn't re-walk
+			/// the capability lists every poll. Only valid while CachedParsedRegistersValid.
+			/// </summary>
+			PCI_EXPRESS_REGISTERS CachedParsedRegisters;
+
+			/// <summary>
+			/// True while CachedParsedRegisters points into the current payload buffer.
+			/// Cleared whenever the payload is replaced (writes, function level reset).
+			/// </summary>
+			std::atomic<bool> CachedParsedRegistersValid;
+
 			/// <summary>
 			/// Gets a pointer to the Pci Header
 			/// This is private since it is raw access.
@@ -909,6 +942,11 @@ namespace cnvme
 			/// Watches for changes to the registers
 			/// </summary>
 			LoopingThread RegisterWatcher;
+
+			/// <summary>
+			/// Serializes lazy RegisterWatcher starts
+			/// </summary>
+			std::mutex WatcherStartMutex;
 		};
 	}
 }
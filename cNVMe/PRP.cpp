@@ -23,6 +23,7 @@
 PRP.cpp - An implementation file for the PRPs
 */
 
+#include "MemoryPool.h"
 #include "PRP.h"
 
 namespace cnvme
@@ -73,7 +74,7 @@ namespace cnvme
 		{
 			if (PRP1)
 			{
-				delete[] MEMORY_ADDRESS_TO_8POINTER(PRP1);
+				pool::thePool.release(MEMORY_ADDRESS_TO_8POINTER(PRP1), std::min(NumberOfBytes, MemoryPageSize));
 				PRP1 = 0;
 			}
 
@@ -83,13 +84,13 @@ namespace cnvme
 				std::vector<std::pair<BYTE*, size_t>> prpList = getPRPListPointers();
 				for (std::pair<BYTE*, size_t> &prp : prpList)
 				{
-					delete[]prp.first;
+					pool::thePool.release(prp.first, MemoryPageSize); // list items are always a full page
 				}
 			}
 
 			if (PRP2)
 			{
-				delete[] MEMORY_ADDRESS_TO_8POINTER(PRP2);
+				pool::thePool.release(MEMORY_ADDRESS_TO_8POINTER(PRP2), MemoryPageSize);
 				PRP2 = 0;
 			}
 		}
@@ -99,31 +100,80 @@ namespace cnvme
 	{
 		Payload payload;
 		if (NumberOfBytes > 0)
+		{
+			// Allocate once and gather, instead of appending (and reallocating) per page
+			payload = Payload(NumberOfBytes);
+			copySegmentsToBuffer(payload.getBuffer(), payload.getSize());
+		}
+		return payload;
+	}
+
+	std::vector<std::pair<BYTE*, size_t>> PRP::getDataSegments()
+	{
+		std::vector<std::pair<BYTE*, size_t>> segments;
+		if (NumberOfBytes > 0)
 		{
 			size_t bytesRemaining = NumberOfBytes;
+
 			// no matter what, prp 1 is used
-			BYTE* prp1Pointer = MEMORY_ADDRESS_TO_8POINTER(PRP1);
-			payload.append(Payload(prp1Pointer, std::min(bytesRemaining, MemoryPageSize)));
-			bytesRemaining -= std::min(bytesRemaining, MemoryPageSize);
+			segments.emplace_back(MEMORY_ADDRESS_TO_8POINTER(PRP1), std::min(bytesRemaining, MemoryPageSize));
+			bytesRemaining -= segments.back().second;
+
 			if (bytesRemaining > 0)
 			{
 				if (usesPRPList())
 				{
 					std::vector<std::pair<BYTE*, size_t>> prpList = getPRPListPointers();
-					for (std::pair<BYTE*, size_t> &prp : prpList)
-					{
-						payload.append(Payload(prp.first, prp.second));
-					}
+					segments.insert(segments.end(), prpList.begin(), prpList.end());
 				}
 				else
 				{
-					BYTE* prp2Pointer = MEMORY_ADDRESS_TO_8POINTER(PRP2);
-					payload.append(Payload(prp2Pointer, std::min(bytesRemaining, MemoryPageSize)));
-					bytesRemaining -= std::min(bytesRemaining, MemoryPageSize);
+					segments.emplace_back(MEMORY_ADDRESS_TO_8POINTER(PRP2), std::min(bytesRemaining, MemoryPageSize));
 				}
 			}
 		}
-		return payload;
+		return segments;
+	}
+
+	bool PRP::copySegmentsToBuffer(BYTE* buffer, size_t bufferSize)
+	{
+		if (bufferSize < NumberOfBytes)
+		{
+			ASSERT("Given buffer is too small for the data in the PRPs");
+			return false;
+		}
+
+		for (auto &segment : getDataSegments())
+		{
+			memcpy_s(buffer, bufferSize, segment.first, segment.second);
+			buffer += segment.second;
+			bufferSize -= segment.second;
+		}
+		return true;
+	}
+
+	bool PRP::copyBufferToSegments(const BYTE* buffer, size_t bufferSize)
+	{
+		if (bufferSize > NumberOfBytes)
+		{
+			ASSERT("Given buffer is larger than the allocated PRPs");
+			return false;
+		}
+
+		size_t bytesRemaining = bufferSize;
+		for (auto &segment : getDataSegments())
+		{
+			if (bytesRemaining == 0)
+			{
+				break;
+			}
+
+			size_t bytesToCopy = std::min(segment.second, bytesRemaining);
+			memcpy_s(segment.first, segment.second, buffer, bytesToCopy);
+			buffer += bytesToCopy;
+			bytesRemaining -= bytesToCopy;
+		}
+		return true;
 	}
 
 	size_t PRP::getNumBytes()
@@ -151,45 +201,82 @@ namespace cnvme
 		return PRP2;
 	}
 
-	bool PRP::placePayloadInExistingPRPs(Payload &payload)
+
+	void PRP::constructFromExternalBuffer(BYTE* buffer, size_t numBytes, size_t memoryPageSize, Payload& prpListChainArena)
 	{
-		if (payload.getSize() > getNumBytes())
+		ASSERT_IF(buffer == nullptr && numBytes != 0, "Cannot build PRPs over a NULL buffer");
+
+		FreeOnScopeLoss = false; // the caller owns the buffer and the arena; we only describe them
+		NumberOfBytes = numBytes;
+		MemoryPageSize = memoryPageSize;
+		PRP1 = POINTER_TO_MEMORY_ADDRESS(buffer);
+		PRP2 = 0;
+
+		if (NumberOfBytes <= MemoryPageSize)
 		{
-			ASSERT("Given payload is larger than the allocated PRPs");
-			return false;
+			return; // PRP1 covers everything
+		}
+
+		if (!usesPRPList())
+		{
+			PRP2 = (UINT_64)(buffer + MemoryPageSize);
+			return;
 		}
 
-		size_t bytesRemaining = payload.getSize();
+		// Build the chained PRP lists in the arena with entries pointing straight into the
+		//  buffer. The loop shape matches what getPRPListPointers() walks: the last slot of
+		//  every list page except the final one links to the next list page.
+		UINT_32 numberOfChainedPrps = getNumberOfChainedPRPs();
+		UINT_32 numberOfItemsInSinglePrpList = getMaxItemsInSinglePRPList();
 
-		BYTE* prp1Pointer = MEMORY_ADDRESS_TO_8POINTER(PRP1);
+		size_t arenaBytesNeeded = (size_t)numberOfChainedPrps * MemoryPageSize;
+		if (prpListChainArena.getSize() < arenaBytesNeeded)
+		{
+			prpListChainArena.resize(arenaBytesNeeded);
+		}
+		PRP2 = prpListChainArena.getMemoryAddress();
 
-		// Copy in first page of data
-		size_t bytesIntoPrp1 = std::min(MemoryPageSize, bytesRemaining);
-		BYTE* payloadBuf = payload.getBuffer();
-		memcpy_s(prp1Pointer, MemoryPageSize, payloadBuf, bytesIntoPrp1);
-		payloadBuf += bytesIntoPrp1;
-		bytesRemaining -= bytesIntoPrp1;
+		size_t bytesRemaining = NumberOfBytes - MemoryPageSize;
+		size_t bufferOffset = MemoryPageSize;
+		UINT_64* listEntry = (UINT_64*)prpListChainArena.getBuffer();
 
-		if (bytesRemaining)
+		for (UINT_32 i = 0; i < numberOfChainedPrps; i++)
 		{
-			BYTE* prp2Pointer = MEMORY_ADDRESS_TO_8POINTER(PRP2);
-			if (usesPRPList())
+			for (UINT_32 j = 0; j < numberOfItemsInSinglePrpList; j++)
 			{
-				std::vector<std::pair<BYTE*, size_t>> prpList = getPRPListPointers();
-				for (std::pair<BYTE*, size_t> &prp : prpList)
+				// Out of data or we need to link to the next chain
+				if (bytesRemaining == 0 || ((j + 1) == numberOfItemsInSinglePrpList && (i + 1) != numberOfChainedPrps))
 				{
-					memcpy_s(prp.first, prp.second, payloadBuf, prp.second);
-					payloadBuf += prp.second;
+					break;
 				}
+
+				*listEntry = (UINT_64)(buffer + bufferOffset);
+				bytesRemaining -= std::min(MemoryPageSize, bytesRemaining);
+				bufferOffset += MemoryPageSize;
+				listEntry++;
 			}
-			else
+
+			if (bytesRemaining == 0)
 			{
-				// Copy the rest of the data into PRP2
-				size_t bytesIntoPrp2 = std::min(MemoryPageSize, bytesRemaining);
-				memcpy_s(prp2Pointer, MemoryPageSize, payloadBuf, bytesIntoPrp2);
+				break;
 			}
+
+			// The list pages are contiguous in the arena, so the link is just the next page over
+			BYTE* nextChain = prpListChainArena.getBuffer() + ((size_t)(i + 1) * MemoryPageSize);
+			*listEntry = POINTER_TO_MEMORY_ADDRESS(nextChain);
+			listEntry = (UINT_64*)nextChain;
 		}
-		return true;
+	}
+
+	bool PRP::placePayloadInExistingPRPs(Payload &payload)
+	{
+		if (payload.getSize() > getNumBytes())
+		{
+			ASSERT("Given payload is larger than the allocated PRPs");
+			return false;
+		}
+
+		return copyBufferToSegments(payload.getBuffer(), payload.getSize());
 	}
 
 	bool PRP::usesPRPList()
@@ -272,26 +359,30 @@ namespace cnvme
 
 		// PRP1 will be the first MPS (memory page size) of the data
 		size_t prp1DataSize = std::min(payload.getSize(), MemoryPageSize);
-		ALLOC_BYTE_ARRAY(prp1Pointer, prp1DataSize);
+		BYTE* prp1Pointer = pool::thePool.acquire(prp1DataSize); // pooled, comes back zeroed
 		// This is sort of not how this works in NVMe. In NVMe, we would have an entire page allocated.
 		// Though for the simulation, this can be really slow. If we only need say 512 bytes instead of a full 128MB page
 		// We will only allocate the 512 as opposed finding a full page. While here, another oddity is the offset.
 		// I'm not using the offset, it is always 0. Assume that we can always allocate a complete, empty page.
 
-		memcpy_s(prp1Pointer, prp1DataSize, payload.getBuffer(), prp1DataSize); //do not copy the whole payload. Just the prp1DataSize.
+		// Slice the transfer with zero-copy views: the only memory traffic left is the
+		//  one copy into each simulated host page (which are freed independently, so they
+		//  can't just point into the payload).
+		PayloadView prp1View = payload.view(0, prp1DataSize);
+		memcpy_s(prp1Pointer, prp1DataSize, prp1View.getBuffer(), prp1View.getSize()); //do not copy the whole payload. Just the prp1DataSize.
 
 		bytesRemaining -= prp1DataSize;
 
 		if (bytesRemaining > 0)
 		{
 			// PRP2 will be the next MPS or a pointer to a PRP list 
-			ALLOC_BYTE_ARRAY(prp2Pointer, MemoryPageSize);
+			BYTE* prp2Pointer = pool::thePool.acquire(MemoryPageSize); // pooled, comes back zeroed
 
 			// If the remaining data size is less than a second memory page, just copy to that pointer
 			if (!usesPRPList())
 			{
-				memcpy_s(prp2Pointer, MemoryPageSize, payload.getBuffer() + MemoryPageSize, \
-					std::min(payload.getSize() - MemoryPageSize, MemoryPageSize));
+				PayloadView prp2View = payload.view(MemoryPageSize, std::min(payload.getSize() - MemoryPageSize, MemoryPageSize));
+				memcpy_s(prp2Pointer, MemoryPageSize, prp2View.getBuffer(), prp2View.getSize());
 			}
 			else
 			{
@@ -302,7 +393,7 @@ namespace cnvme
 				UINT_32 numberOfChainedPrps = getNumberOfChainedPRPs();
 				UINT_32 numberOfItemsInSinglePrpList = getMaxItemsInSinglePRPList();
 
-				BYTE* bufPointer = payload.getBuffer() + MemoryPageSize;
+				size_t payloadOffset = MemoryPageSize;
 
 				for (UINT_32 i = 0; i < numberOfChainedPrps; i++)
 				{
@@ -314,14 +405,14 @@ namespace cnvme
 							break;
 						}
 
-						ALLOC_BYTE_ARRAY(listItem, MemoryPageSize);
+						BYTE* listItem = pool::thePool.acquire(MemoryPageSize); // pooled, comes back zeroed
 
-						size_t bytesToCopy = std::min(MemoryPageSize, bytesRemaining);
+						PayloadView pageView = payload.view(payloadOffset, std::min(MemoryPageSize, bytesRemaining));
 
-						memcpy_s(listItem, MemoryPageSize, bufPointer, bytesToCopy);
+						memcpy_s(listItem, MemoryPageSize, pageView.getBuffer(), pageView.getSize());
 
-						bytesRemaining -= bytesToCopy;
-						bufPointer += bytesToCopy;
+						bytesRemaining -= pageView.getSize();
+						payloadOffset += pageView.getSize();
 
 						*pPrpList = POINTER_TO_MEMORY_ADDRESS(listItem);
 						pPrpList++;
@@ -333,7 +424,7 @@ namespace cnvme
 					}
 
 					// Create new chain
-					ALLOC_BYTE_ARRAY(newPrpList, MemoryPageSize);
+					BYTE* newPrpList = pool::thePool.acquire(MemoryPageSize); // pooled, comes back zeroed
 
 					*pPrpList = POINTER_TO_MEMORY_ADDRESS(newPrpList);
 					pPrpList = &(*(UINT_64*)newPrpList);
@@ -79,6 +79,31 @@ namespace cnvme
 		/// <returns>A payload with data from the PRP</returns>
 		Payload getPayloadCopy();
 
+		/// <summary>
+		/// Gets an iovec-style view of the data pages for this PRP (PRP1, then PRP2 or the PRP list).
+		/// The pointers point at the actual PRP memory: no data is copied.
+		/// </summary>
+		/// <returns>vector of byte pointers and the size of the data they point to</returns>
+		std::vector<std::pair<BYTE*, size_t>> getDataSegments();
+
+		/// <summary>
+		/// Gathers the PRP's data into the given buffer by walking the segments.
+		/// Like getPayloadCopy() but without allocating an intermediate payload.
+		/// </summary>
+		/// <param name="buffer">Destination buffer</param>
+		/// <param name="bufferSize">Size of the destination buffer. Must fit getNumBytes()</param>
+		/// <returns>True if all of the PRP data was copied out. False otherwise.</returns>
+		bool copySegmentsToBuffer(BYTE* buffer, size_t bufferSize);
+
+		/// <summary>
+		/// Scatters the given buffer into the PRP's data pages by walking the segments.
+		/// Like placePayloadInExistingPRPs() but without an intermediate payload.
+		/// </summary>
+		/// <param name="buffer">Source buffer</param>
+		/// <param name="bufferSize">Number of bytes to copy in. Must be at most getNumBytes()</param>
+		/// <returns>True if the FULL buffer has been sent to the PRPs. False otherwise.</returns>
+		bool copyBufferToSegments(const BYTE* buffer, size_t bufferSize);
+
 		/// <summary>
 		/// Returns the number of bytes represented by the PRP
 		/// </summary>
@@ -122,6 +147,18 @@ namespace cnvme
 		/// <param name="payload"></param>
 		/// <param name="memoryPageSize"></param>
 		void constructFromPayloadAndMemoryPageSize(const Payload &payload, size_t memoryPageSize);
+
+		/// <summary>
+		/// Points this PRP at an existing contiguous buffer without copying any data.
+		/// The PRP entries (and any chained list pages, built in the given arena)
+		/// reference the buffer directly, so the caller keeps ownership of both the
+		/// buffer and the arena and must keep them alive while this PRP is in use.
+		/// </summary>
+		/// <param name="buffer">Contiguous buffer holding (or receiving) the data</param>
+		/// <param name="numBytes">Number of bytes of the buffer the PRP should describe</param>
+		/// <param name="memoryPageSize">Size in bytes of a memory page (CC.MPS)</param>
+		/// <param name="prpListChainArena">Caller owned memory the chained PRP lists get built in (resized as needed)</param>
+		void constructFromExternalBuffer(BYTE* buffer, size_t numBytes, size_t memoryPageSize, Payload& prpListChainArena);
 	private:
 
 		/// <summary>
@@ -23,6 +23,7 @@
 Payload.cpp - An implementation file for the Payload class
 */
 
+#include "MemoryPool.h"
 #include "Payload.h"
 
 #include <algorithm>
@@ -32,8 +33,7 @@ namespace cnvme
 	Payload::Payload(size_t byteSize) : Payload()
 	{
 		ByteSize = byteSize;
-		BytePointer = new UINT_8[byteSize];
-		memset(BytePointer, 0x00, ByteSize);
+		BytePointer = pool::thePool.acquire(byteSize); // comes back zeroed
 	}
 
 	Payload::Payload(BYTE * pointer, size_t byteSize) : Payload::Payload(byteSize)
@@ -61,32 +61,93 @@ namespace cnvme
 			return *this;
 		}
 
+		// free what we had (if we owned it) so the old buffer doesn't leak
+		if (BytePointer && DeleteOnScopeLoss)
+		{
+			pool::thePool.release(BytePointer, ByteSize);
+		}
+
 		ByteSize = other.ByteSize;
-		BytePointer = new UINT_8[other.ByteSize];
+		BytePointer = pool::thePool.acquire(other.ByteSize);
 
 		memcpy_s(BytePointer, ByteSize, other.BytePointer, other.ByteSize);
 		return *this;
 	}
 
-	bool Payload::operator==(const Payload &other)
+	Payload::Payload(Payload&& other) : Payload::Payload()
 	{
-		if (this->getSize() == other.getSize())
+		*this = std::move(other);
+	}
+
+	Payload& Payload::operator=(Payload&& other)
+	{
+		// check for self-assignment
+		if (&other == this)
+		{
+			return *this;
+		}
+
+		// free what we had (if we owned it) so the old buffer doesn't leak
+		if (BytePointer && DeleteOnScopeLoss)
 		{
+			pool::thePool.release(BytePointer, ByteSize);
+		}
+
+		// steal the other's buffer instead of copying it
+		BytePointer = other.BytePointer;
+		ByteSize = other.ByteSize;
+		DeleteOnScopeLoss = other.DeleteOnScopeLoss;
+
+		other.BytePointer = nullptr;
+		other.ByteSize = 0;
+
+		return *this;
+	}
+
+	bool Payload::operator==(const Payload &other)
+	{
+		size_t firstMiscompareOffset = 0;
+		bool equal = this->compare(other, firstMiscompareOffset);
 
 #ifdef PAYLOAD_CMP_DEBUG // Used for debugging comparison issues
-			for (size_t i = 0; i < getSize(); i++)
+		if (!equal && this->getSize() == other.getSize())
+		{
+			printf("Miscompare at index %zu : 0x%X != 0x%X\n", firstMiscompareOffset,
+				getBuffer()[firstMiscompareOffset], other.getBuffer()[firstMiscompareOffset]);
+		}
+#endif //PAYLOAD_CMP_DEBUG
+
+		return equal;
+	}
+
+	bool Payload::compare(const Payload& other, size_t& firstMiscompareOffset) const
+	{
+		if (this->getSize() != other.getSize())
+		{
+			firstMiscompareOffset = std::min(this->getSize(), other.getSize());
+			return false;
+		}
+
+		// Compare in chunks: the bulk work stays in libc's vectorized memcmp, and a
+		//  miscompare only costs a byte scan of the one failing chunk.
+		const size_t chunkSize = 4096;
+		for (size_t offset = 0; offset < this->getSize(); offset += chunkSize)
+		{
+			size_t bytesThisChunk = std::min(chunkSize, this->getSize() - offset);
+			if (memcmp(this->getBuffer() + offset, other.getBuffer() + offset, bytesThisChunk) != 0)
 			{
-				if (getBuffer()[i] != other.getBuffer()[i])
+				for (size_t i = 0; i < bytesThisChunk; i++)
 				{
-					printf("Miscompare at index %u : 0x%X != 0x%X\n", i, getBuffer()[i], other.getBuffer()[i]);
+					if (this->getBuffer()[offset + i] != other.getBuffer()[offset + i])
+					{
+						firstMiscompareOffset = offset + i;
+						return false;
+					}
 				}
 			}
-#endif //PAYLOAD_CMP_DEBUG
-			return memcmp(this->getBuffer(), other.getBuffer(), this->getSize()) == 0;
-
 		}
 
-		return false;
+		return true;
 	}
 
 	bool Payload::operator!=(const Payload & other)
@@ -98,7 +159,7 @@ namespace cnvme
 	{
 		if (BytePointer && DeleteOnScopeLoss)
 		{
-			delete[] BytePointer;
+			pool::thePool.release(BytePointer, ByteSize);
 			BytePointer = nullptr;
 			ByteSize = 0;
 		}
@@ -123,9 +184,9 @@ namespace cnvme
 	{
 		if (newSize != ByteSize)
 		{
-			UINT_8* tmp = new UINT_8[newSize];
+			UINT_8* tmp = pool::thePool.acquire(newSize);
 			memcpy_s(tmp, newSize, BytePointer, std::min(ByteSize, newSize)); // Only copy current size at most... don't overflow
-			delete[] BytePointer;
+			pool::thePool.release(BytePointer, ByteSize);
 			BytePointer = tmp;
 			ByteSize = newSize;
 		}
@@ -148,6 +209,18 @@ namespace cnvme
 		memcpy_s(this->getBuffer() + oldSize, this->getSize() - oldSize, otherPayload.getBuffer(), otherPayload.getSize());
 	}
 
+	void Payload::append(Payload&& otherPayload)
+	{
+		// If we are empty, just steal the other's buffer outright: no copy needed
+		if (this->getSize() == 0 && otherPayload.DeleteOnScopeLoss)
+		{
+			*this = std::move(otherPayload);
+			return;
+		}
+
+		this->append(otherPayload); // non-empty: fall back to the copying append
+	}
+
 	void Payload::setDeleteOnScopeLoss(bool delOnScopeLoss)
 	{
 		DeleteOnScopeLoss = delOnScopeLoss;
@@ -173,4 +246,64 @@ namespace cnvme
 
 		return retVec;
 	}
+
+	PayloadView Payload::view(size_t offset, size_t length) const
+	{
+		ASSERT_IF(offset + length > this->getSize(), "Attempted to create a view past the end of the payload");
+		return PayloadView(this->getBuffer() + offset, length);
+	}
+
+	std::vector<PayloadView> Payload::splitView(size_t splitSize) const
+	{
+		ASSERT_IF(this->getSize() % splitSize != 0, "Payload is not evenly splitable by the given splitSize (" + std::to_string(splitSize) + ")");
+
+		std::vector<PayloadView> retVec;
+		size_t retVecSize = this->getSize() / splitSize;
+		retVec.reserve(retVecSize);
+
+		for (size_t i = 0; i < retVecSize; i++)
+		{
+			retVec.emplace_back(this->getBuffer() + (i * splitSize), splitSize);
+		}
+
+		return retVec;
+	}
+
+	PayloadView::PayloadView()
+	{
+		BytePointer = nullptr;
+		ByteSize = 0;
+	}
+
+	PayloadView::PayloadView(BYTE* pointer, size_t byteSize)
+	{
+		BytePointer = pointer;
+		ByteSize = byteSize;
+	}
+
+	PayloadView::PayloadView(const Payload& payload)
+	{
+		BytePointer = payload.getBuffer();
+		ByteSize = payload.getSize();
+	}
+
+	UINT_8* PayloadView::getBuffer() const
+	{
+		return BytePointer;
+	}
+
+	size_t PayloadView::getSize() const
+	{
+		return ByteSize;
+	}
+
+	UINT_64 PayloadView::getMemoryAddress() const
+	{
+		return POINTER_TO_MEMORY_ADDRESS(BytePointer);
+	}
+
+	Payload PayloadView::toPayload() const
+	{
+		return Payload(BytePointer, ByteSize);
+	}
 }
\ No newline at end of file
@@ -29,6 +29,8 @@ Payload.h - A header file for the Payload class
 
 namespace cnvme
 {
+	class PayloadView; // defined below
+
 	/// <summary>
 	/// Payload is a safe dynamic memory allocation class
 	/// </summary>
@@ -66,6 +68,19 @@ namespace cnvme
 		/// <returns>Payload</returns>
 		Payload& operator=(const Payload& other);
 
+		/// <summary>
+		/// Move constructor. Steals the buffer from the other Payload instead of copying it.
+		/// </summary>
+		/// <param name="other">Another Payload to move from</param>
+		Payload(Payload&& other);
+
+		/// <summary>
+		/// Move assignment operator. Steals the buffer from the other Payload instead of copying it.
+		/// </summary>
+		/// <param name="other">Another Payload to move from</param>
+		/// <returns>Payload</returns>
+		Payload& operator=(Payload&& other);
+
 		/// <summary>
 		/// Checks if the two payloads are equivalent
 		/// </summary>
@@ -80,6 +95,17 @@ namespace cnvme
 		/// <returns>false if equal size and contents</returns>
 		bool operator!=(const Payload& other);
 
+		/// <summary>
+		/// Compares this payload's contents with another's, early-exiting at the first
+		/// difference. Runs chunk-wise over the vectorized libc memcmp, so it's fast on
+		/// large buffers but can still report where the first miscompare is.
+		/// </summary>
+		/// <param name="other">The other payload</param>
+		/// <param name="firstMiscompareOffset">On miscompare, gets the byte offset of the first difference.
+		/// If the sizes differ, gets the smaller payload's size.</param>
+		/// <returns>true if equal size and contents</returns>
+		bool compare(const Payload& other, size_t& firstMiscompareOffset) const;
+
 		/// <summary>
 		/// Destructor, deallocates memory
 		/// </summary>
@@ -121,6 +147,13 @@ namespace cnvme
 		/// <param name="otherPayload">another payload</param>
 		void append(const Payload &otherPayload);
 
+		/// <summary>
+		/// Append an expiring payload after this one.
+		/// If this payload is empty, the other's buffer gets stolen instead of copied.
+		/// </summary>
+		/// <param name="otherPayload">another payload</param>
+		void append(Payload&& otherPayload);
+
 		/// <summary>
 		/// Sets if we should free memory on scope loss 
 		/// </summary>
@@ -140,6 +173,24 @@ namespace cnvme
 		/// <returns>vector of Payload</returns>
 		std::vector<Payload> split(size_t splitSize) const;
 
+		/// <summary>
+		/// Gets a non-owning view of part of this payload's buffer.
+		/// No allocation or copy happens; this payload must outlive the view.
+		/// </summary>
+		/// <param name="offset">Byte offset into this payload</param>
+		/// <param name="length">Length of the view in bytes</param>
+		/// <returns>PayloadView into this payload</returns>
+		PayloadView view(size_t offset, size_t length) const;
+
+		/// <summary>
+		/// Splits the payload into evenly sized non-owning views, without copying anything.
+		/// Note that this will ASSERT if the size of this payload isn't evenly divisible by splitSize.
+		/// This payload must outlive the views.
+		/// </summary>
+		/// <param name="splitSize">Bytes per view</param>
+		/// <returns>vector of PayloadView</returns>
+		std::vector<PayloadView> splitView(size_t splitSize) const;
+
 	private:
 
 		/// <summary>
@@ -157,4 +208,67 @@ namespace cnvme
 		/// </summary>
 		bool DeleteOnScopeLoss;
 	};
+
+	/// <summary>
+	/// PayloadView is a non-owning view (pointer + length) into part of a buffer.
+	/// It formalizes the setDeleteOnScopeLoss(false) pattern: the owner of the memory
+	/// (usually a Payload) must outlive the view. Copying a view is just copying a pointer.
+	/// </summary>
+	class PayloadView
+	{
+	public:
+		/// <summary>
+		/// Default constructor. Views nothing.
+		/// </summary>
+		PayloadView();
+
+		/// <summary>
+		/// Create a view of a pointer/length. This does not copy or take ownership.
+		/// </summary>
+		/// <param name="pointer">byte array</param>
+		/// <param name="byteSize">size of the array</param>
+		PayloadView(BYTE* pointer, size_t byteSize);
+
+		/// <summary>
+		/// Create a view of an entire payload. This does not copy or take ownership.
+		/// </summary>
+		/// <param name="payload">The payload to view. Must outlive this view.</param>
+		PayloadView(const Payload& payload);
+
+		/// <summary>
+		/// Get the byte pointer
+		/// </summary>
+		/// <returns>The viewed buffer</returns>
+		UINT_8* getBuffer() const;
+
+		/// <summary>
+		/// Returns the size of the viewed buffer
+		/// </summary>
+		/// <returns>Size in bytes</returns>
+		size_t getSize() const;
+
+		/// <summary>
+		/// Returns the memory address for the viewed buffer
+		/// </summary>
+		/// <returns>Memory address</returns>
+		UINT_64 getMemoryAddress() const;
+
+		/// <summary>
+		/// Makes an owning Payload copy of the viewed bytes, for when a copy is actually wanted.
+		/// </summary>
+		/// <returns>Payload with a copy of the viewed data</returns>
+		Payload toPayload() const;
+
+	private:
+
+		/// <summary>
+		/// The viewed byte pointer. Not owned.
+		/// </summary>
+		UINT_8* BytePointer;
+
+		/// <summary>
+		/// The number of bytes viewed
+		/// </summary>
+		size_t ByteSize;
+	};
 }
@@ -24,6 +24,7 @@ Queue.cpp- A implementation file for the NVMe Queues
 */
 
 #include "Command.h"
+#include "Constants.h"
 #include "Queue.h"
 
 namespace cnvme
@@ -34,9 +35,14 @@ namespace cnvme
 		{
 			QueueSize = 0;
 			QueueId = 0;
+			Priority = constants::commands::queue_priorities::MEDIUM; // default unless Create IO SQ says otherwise
 			Doorbell = nullptr;
+			ShadowDoorbell = nullptr;
+			EventIdx = nullptr;
 			HeadPointer = 0; // Queue start at 0
 			TailPointer = 0; // Queue start at 0
+			CachedHeadPointer = 0;
+			CachedTailPointer = 0;
 			LinkedMemoryAddress = 0;
 			MappedQueue = nullptr;
 		}
@@ -56,6 +62,22 @@ namespace cnvme
 			// The owner of the memory should deallocate.
 		}
 
+		UINT_8 Queue::getPriority() const
+		{
+			return Priority;
+		}
+
+		void Queue::setPriority(UINT_8 priority)
+		{
+			Priority = priority;
+		}
+
+		void Queue::setShadowDoorbell(UINT_32* shadowDoorbell, UINT_32* eventIdx)
+		{
+			ShadowDoorbell = shadowDoorbell;
+			EventIdx = eventIdx;
+		}
+
 		UINT_32 Queue::getQueueSize() const
 		{
 			return QueueSize;
@@ -73,19 +95,19 @@ namespace cnvme
 
 		UINT_32 Queue::getHeadPointer()
 		{
-			return HeadPointer;
+			return HeadPointer.load(std::memory_order_acquire);
 		}
 
 		UINT_32 Queue::getTailPointer()
 		{
-			return TailPointer;
+			return TailPointer.load(std::memory_order_acquire);
 		}
 
 		bool Queue::setTailPointer(UINT_32 newIndex)
 		{
 			if (newIndex < getQueueSize())
 			{
-				TailPointer = newIndex;
+				TailPointer.store(newIndex, std::memory_order_release);
 				return true;
 			}
 
@@ -93,29 +115,73 @@ namespace cnvme
 			return false;
 		}
 
+		bool Queue::isFull()
+		{
+			// Only the producer calls this, so a relaxed read of our own tail is fine
+			UINT_32 nextTail = (TailPointer.load(std::memory_order_relaxed) + 1) % getQueueSize();
+
+			if (nextTail != CachedHeadPointer)
+			{
+				return false; // fast path: no cross-core read of the consumer's head
+			}
+
+			CachedHeadPointer = HeadPointer.load(std::memory_order_acquire); // looks full: refresh the cache
+			return nextTail == CachedHeadPointer;
+		}
+
+		bool Queue::isEmpty()
+		{
+			// Only the consumer calls this, so a relaxed read of our own head is fine
+			UINT_32 head = HeadPointer.load(std::memory_order_relaxed);
+
+			if (head != CachedTailPointer)
+			{
+				return false; // fast path: no cross-core read of the producer's tail
+			}
+
+			CachedTailPointer = TailPointer.load(std::memory_order_acquire); // looks empty: refresh the cache
+			return head == CachedTailPointer;
+		}
+
 		UINT_16 Queue::incrementAndGetHeadCloserToTail()
 		{
-			ASSERT_IF(HeadPointer == TailPointer, "HeadPointer == TailPointer. Should not be incrementing.");
+			// Consumer side: our own head can be read relaxed, the producer's tail needs acquire
+			UINT_32 head = HeadPointer.load(std::memory_order_relaxed);
+			UINT_32 tail = TailPointer.load(std::memory_order_acquire);
 
-			HeadPointer++;
-			HeadPointer %= getQueueSize();
-			if (HeadPointer > TailPointer)
+			ASSERT_IF(head == tail, "HeadPointer == TailPointer. Should not be incrementing.");
+
+			head = (head + 1) % getQueueSize();
+			HeadPointer.store(head, std::memory_order_release); // publish that we are done with the entry
+
+			if (head > tail)
 			{
-				return getQueueSize() - HeadPointer + TailPointer; // Wrapped around
+				return getQueueSize() - head + tail; // Wrapped around
 			}
-			return TailPointer - HeadPointer;                      // Not wrapped around
+			return tail - head;                      // Not wrapped around
 		}
 
 		void Queue::incrementTailPointerAndRingDoorbell()
 		{
-			TailPointer++;
-			// Wrap around as needed
-			if (TailPointer == getQueueSize())
+			// Producer side: publish the new tail with release so the consumer sees the entry's memory first
+			UINT_32 tail = (TailPointer.load(std::memory_order_relaxed) + 1) % getQueueSize();
+			TailPointer.store(tail, std::memory_order_release);
+
+			if (ShadowDoorbell)
 			{
-				TailPointer = 0;
+				// Doorbell Buffer Config is live: publish the tail to the shadow slot and skip the
+				//  real doorbell write unless this submission moved the tail past the controller's
+				//  EventIdx (wrap-safe comparison, same idea as virtio's vring_need_event()).
+				UINT_32 oldTail = *ShadowDoorbell;
+				*ShadowDoorbell = tail;
+
+				if (!((UINT_16)((UINT_16)tail - (UINT_16)*EventIdx - 1) < (UINT_16)((UINT_16)tail - (UINT_16)oldTail)))
+				{
+					return; // the controller will see the shadow slot on its next pass
+				}
 			}
 
-			*Doorbell = TailPointer;
+			*Doorbell = tail;
 		}
 
 		UINT_64 Queue::getMemoryAddress()
@@ -32,7 +32,9 @@ namespace cnvme
 	namespace controller
 	{
 		/// <summary>
-		/// Represents either a submission or completion queue
+		/// Represents either a submission or completion queue.
+		/// The head/tail indexes form a single-producer/single-consumer ring: one thread may
+		/// move the tail (producer) while another moves the head (consumer) without locking.
 		/// </summary>
 		class Queue
 		{
@@ -93,6 +95,23 @@ namespace cnvme
 			/// <returns>True if successful. False if the new index is out of bounds</returns>
 			bool setTailPointer(UINT_32 newIndex);
 
+			/// <summary>
+			/// Producer-side check for whether another entry can be placed in the ring.
+			/// Uses a cached copy of the consumer's head pointer so the common case does not
+			/// read the consumer's index (and bounce its cacheline); the cache is only
+			/// refreshed when the ring looks full.
+			/// </summary>
+			/// <returns>True if the ring is full</returns>
+			bool isFull();
+
+			/// <summary>
+			/// Consumer-side check for whether the ring has anything to consume.
+			/// Uses a cached copy of the producer's tail pointer, refreshed only when the
+			/// ring looks empty, for the same cacheline reasons as isFull().
+			/// </summary>
+			/// <returns>True if the ring is empty</returns>
+			bool isEmpty();
+
 			/// <summary>
 			/// Add 1 to the Head Pointer to get it closer to the tail
 			/// Will ASSERT if incremented past the tail.
@@ -135,6 +154,28 @@ namespace cnvme
 			/// <param name="mappedQueue">Linked queue</param>
 			void setMappedQueue(Queue* mappedQueueId);
 
+			/// <summary>
+			/// Gets this queue's arbitration priority class (see constants::commands::queue_priorities)
+			/// </summary>
+			/// <returns>Priority class</returns>
+			UINT_8 getPriority() const;
+
+			/// <summary>
+			/// Sets this queue's arbitration priority class (see constants::commands::queue_priorities)
+			/// </summary>
+			/// <param name="priority">Priority class</param>
+			void setPriority(UINT_8 priority);
+
+			/// <summary>
+			/// Hooks this (submission) queue up to its host-side shadow doorbell and EventIdx
+			/// slots (NVMe Doorbell Buffer Config). Once set, ringing the doorbell writes the
+			/// shadow slot and only touches the real doorbell register when the tail crosses
+			/// the controller's EventIdx. Pass nullptrs to go back to real doorbell writes.
+			/// </summary>
+			/// <param name="shadowDoorbell">Host memory slot the controller reads the tail from</param>
+			/// <param name="eventIdx">Host memory slot the controller reports its progress in</param>
+			void setShadowDoorbell(UINT_32* shadowDoorbell, UINT_32* eventIdx);
+
 		private:
 
 			/// <summary>
@@ -142,6 +183,11 @@ namespace cnvme
 			/// </summary>
 			UINT_32 QueueSize;
 
+			/// <summary>
+			/// Arbitration priority class for this queue (submission queues only)
+			/// </summary>
+			UINT_8 Priority;
+
 			/// <summary>
 			/// The identifier for the queue
 			/// </summary>
@@ -153,14 +199,39 @@ namespace cnvme
 			UINT_16* Doorbell;
 
 			/// <summary>
-			/// Head pointer of the queue
+			/// Host memory slot the tail gets published to instead of the real doorbell
+			/// (null unless Doorbell Buffer Config is live)
+			/// </summary>
+			UINT_32* ShadowDoorbell;
+
+			/// <summary>
+			/// Host memory slot where the controller reports the tail it has consumed through
+			/// (null unless Doorbell Buffer Config is live)
+			/// </summary>
+			UINT_32* EventIdx;
+
+			/// <summary>
+			/// Head pointer of the queue. Moved by the consumer with release ordering,
+			/// read by the producer with acquire ordering.
+			/// </summary>
+			std::atomic<UINT_32> HeadPointer;
+
+			/// <summary>
+			/// Tail pointer of the queue. Moved by the producer with release ordering,
+			/// read by the consumer with acquire ordering.
+			/// </summary>
+			std::atomic<UINT_32> TailPointer;
+
+			/// <summary>
+			/// Producer's cached copy of HeadPointer. Only refreshed when the ring looks full,
+			/// so most submissions never touch the consumer's cacheline.
 			/// </summary>
-			UINT_32 HeadPointer;
+			UINT_32 CachedHeadPointer;
 
 			/// <summary>
-			/// Tail pointer of the queue
+			/// Consumer's cached copy of TailPointer. Only refreshed when the ring looks empty.
 			/// </summary>
-			UINT_32 TailPointer;
+			UINT_32 CachedTailPointer;
 
 			/// <summary>
 			/// The memory for this queue to use.
@@ -0,0 +1,78 @@
+/*
+###########################################################################################
+// cNVMe - An Open Source NVMe Device Simulation - MIT License
+// Copyright 2018 - Intel Corporation
+
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+// INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+// PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+// LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT
+// OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+// OTHER DEALINGS IN THE SOFTWARE.
+############################################################################################
+Subsystem.cpp - An implementation file for the Subsystem class
+*/
+
+#include "Subsystem.h"
+
+namespace cnvme
+{
+	namespace controller
+	{
+		Subsystem::Subsystem() : Subsystem(0)
+		{
+		}
+
+		Subsystem::Subsystem(size_t poolThreadCount) : Pool(poolThreadCount)
+		{
+		}
+
+		Subsystem::~Subsystem()
+		{
+			// delete the controllers before the Pool member goes away: their destructors
+			//  pull their watchers out of the pool.
+			for (Controller* controller : this->Controllers)
+			{
+				delete controller;
+			}
+			this->Controllers.clear();
+		}
+
+		Controller& Subsystem::addController()
+		{
+			Controller* controller = new Controller(&this->Pool);
+
+			std::lock_guard<std::mutex> controllersLock(this->ControllersMutex);
+			this->Controllers.push_back(controller);
+			return *controller;
+		}
+
+		Controller& Subsystem::getController(size_t index)
+		{
+			std::lock_guard<std::mutex> controllersLock(this->ControllersMutex);
+			ASSERT_IF(index >= this->Controllers.size(), "Controller index out of range");
+			return *this->Controllers[index];
+		}
+
+		size_t Subsystem::getControllerCount()
+		{
+			std::lock_guard<std::mutex> controllersLock(this->ControllersMutex);
+			return this->Controllers.size();
+		}
+
+		size_t Subsystem::getPoolThreadCount()
+		{
+			return this->Pool.getThreadCount();
+		}
+	}
+}
@@ -0,0 +1,103 @@
+/*
+###########################################################################################
+// cNVMe - An Open Source NVMe Device Simulation - MIT License
+// Copyright 2018 - Intel Corporation
+
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+// INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+// PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+// LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT
+// OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+// OTHER DEALINGS IN THE SOFTWARE.
+############################################################################################
+Subsystem.h - A header file for the Subsystem class
+*/
+
+#pragma once
+
+#include "Controller.h"
+#include "WatcherPool.h"
+
+namespace cnvme
+{
+	namespace controller
+	{
+		/// <summary>
+		/// Subsystem holds many Controllers that share one WatcherPool, so their doorbell
+		/// and register watchers run on O(cores) threads instead of 3 threads per
+		/// controller. Meant for simulating fabrics with many controllers per process.
+		/// </summary>
+		class Subsystem
+		{
+		public:
+			/// <summary>
+			/// Constructor. Sizes the shared pool to the number of hardware threads.
+			/// </summary>
+			Subsystem();
+
+			/// <summary>
+			/// Constructor with an explicit pool thread count
+			/// </summary>
+			/// <param name="poolThreadCount">Worker threads for the shared pool (0 means size to the machine)</param>
+			Subsystem(size_t poolThreadCount);
+
+			/// <summary>
+			/// Destructor. Deletes every controller, then the shared pool.
+			/// </summary>
+			~Subsystem();
+
+			/// <summary>
+			/// Creates a new controller on the shared pool
+			/// </summary>
+			/// <returns>The new controller. Valid for the life of the Subsystem.</returns>
+			Controller& addController();
+
+			/// <summary>
+			/// Gets a controller by index (in addController() order)
+			/// </summary>
+			/// <param name="index">0-based controller index</param>
+			/// <returns>The controller</returns>
+			Controller& getController(size_t index);
+
+			/// <summary>
+			/// Gets the number of controllers in this subsystem
+			/// </summary>
+			/// <returns>Controller count</returns>
+			size_t getControllerCount();
+
+			/// <summary>
+			/// Gets the shared pool's worker thread count
+			/// </summary>
+			/// <returns>Worker thread count</returns>
+			size_t getPoolThreadCount();
+
+		private:
+
+			/// <summary>
+			/// The pool all this subsystem's watchers run on. Declared before Controllers
+			/// since it has to outlive them.
+			/// </summary>
+			WatcherPool Pool;
+
+			/// <summary>
+			/// The controllers, in creation order
+			/// </summary>
+			std::vector<Controller*> Controllers;
+
+			/// <summary>
+			/// Guards Controllers
+			/// </summary>
+			std::mutex ControllersMutex;
+		};
+	}
+}
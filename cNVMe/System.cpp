@@ -28,6 +28,7 @@ System.cpp - An implementation file for a System-specific calls for cNVMe
 #ifdef _WIN32
 #include <Windows.h>
 #else // Linux
+#include <dlfcn.h>
 #include <unistd.h>
 #include <sys/statvfs.h>
 #include <sys/sysinfo.h>
@@ -39,7 +40,11 @@ namespace cnvme
 {
 	namespace sys
 	{
-		std::string getCNVMeFolder()
+		/// <summary>
+		/// Does the actual (potentially slow) folder discovery. getCNVMeFolder() caches this.
+		/// </summary>
+		/// <returns>Folder the cNVMe binary lives in</returns>
+		static std::string discoverCNVMeFolder()
 		{
 			char filename[MAX_FILE_PATH] = "\0";
 			INT_32 len = 0;
@@ -65,19 +70,14 @@ namespace cnvme
 #else // Linux
 
 #if DLL_BUILD
-			// for DLL builds, get the location of the DLL
-			std::string cmd = "pmap -p -q " + std::to_string(getpid()) + " | grep -i cnvme | awk \'{print $4}\' | tail -1";
-			FILE* fp = popen(cmd.c_str(), "r");
-			ASSERT_IF(fp == NULL, "popen() failed!");
-
-			// get command output
-			while (fgets(filename, MAX_FILE_PATH, fp) != NULL) 
-			{
-				retStr += std::string(filename);
-			}
-			pclose(fp);
-			len = strlen(filename);      // set len so the rest of the code works
-			*filename = *retStr.c_str(); // point the filename to this so the rest of the code works
+			// for DLL builds, resolve one of our own symbols back to the shared object it
+			//  lives in. Worlds faster than the popen("pmap ...") walk this used to do.
+			Dl_info dlInfo;
+			memset(&dlInfo, 0, sizeof(dlInfo));
+			ASSERT_IF(dladdr((void*)&discoverCNVMeFolder, &dlInfo) == 0 || dlInfo.dli_fname == NULL, "dladdr() couldn't locate the cNVMe shared object");
+			len = (INT_32)strlen(dlInfo.dli_fname);
+			ASSERT_IF_LT(MAX_FILE_PATH, len, "The cNVMe shared object path doesn't fit in the buffer");
+			memcpy_s(filename, sizeof(filename), dlInfo.dli_fname, len);
 
 	  // ^ DLL_BUILD
 #else // EXE_BUILD
@@ -92,6 +92,14 @@ namespace cnvme
 			return retStr.substr(0, retStr.find_last_of("\\/"));
 		}
 
+		std::string getCNVMeFolder()
+		{
+			// Where we live can't change after load and discovery isn't free, so one
+			//  process-wide lookup serves everybody (thread-safe per C++11 static init)
+			static const std::string cachedCNVMeFolder = discoverCNVMeFolder();
+			return cachedCNVMeFolder;
+		}
+
 		UINT_64 getTotalLocalCapacityInBytes()
 		{
 			UINT_64 retBytes = 0;
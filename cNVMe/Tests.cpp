@@ -23,6 +23,9 @@
 Tests.cpp - An implementation file for all unit testing
 */
 
+#include "Benchmark.h"
+#include "ControllerPool.h"
+#include "Subsystem.h"
 #include "Tests.h"
 
 // Macros to fail a test
@@ -48,32 +51,108 @@ namespace cnvme
 				return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
 			}
 
-			bool runTests()
+			/// <summary>
+			/// One runnable entry in the test list
+			/// </summary>
+			typedef struct TEST_CASE
+			{
+				std::string Name;				// For the per-test timing report
+				std::function<bool()> Function;	// The test itself
+				bool Slow;						// True for sleep/poll heavy tests; they get dispatched first
+			} TEST_CASE;
+
+			/// <summary>
+			/// Timing/result slot for one dispatched TEST_CASE
+			/// </summary>
+			typedef struct TEST_RESULT
 			{
-				std::vector<std::future<bool>> results;
+				bool Passed;					// Did the test return true
+				UINT_64 Milliseconds;			// How long the test took
+			} TEST_RESULT;
 
-				// Run all tests 2 times, multi-threaded
+			bool runTests()
+			{
+				// Every test builds its own Controller/Driver, so they are all safe to run concurrently.
+				// Run all tests 2 times, multi-threaded.
+				std::vector<TEST_CASE> testCases;
 				for (int i = 0; i < 2; i++)
 				{
-					results.push_back(std::async(pci::testPciHeaderId));
-					results.push_back(std::async(general::testLoopingThread));
-					results.push_back(std::async(controller_registers::testControllerReset));
-					results.push_back(std::async(commands::testNVMeCommandOpcodeInvalid));
-					results.push_back(std::async(commands::testNVMeCommandParsing));
-					results.push_back(std::async(commands::testNVMeFirmwareDownloadAndCommit));
-					results.push_back(std::async(commands::testNVMeIo));
-					results.push_back(std::async(commands::testNVMeQueueDeletionFailures));
-					results.push_back(std::async(driver::testNoDataCommandViaDriver));
-					results.push_back(std::async(driver::testReadCommandViaDriver));
-					results.push_back(std::async(prp::testDifferentPRPSizes));
-					results.push_back(std::async(prp::testDataIntoExistingPRP));
-					results.push_back(std::async(logging::testAsserting));
+					testCases.push_back(TEST_CASE{ "pci::testPciHeaderId", pci::testPciHeaderId, false });
+					testCases.push_back(TEST_CASE{ "general::testLoopingThread", general::testLoopingThread, true });
+					testCases.push_back(TEST_CASE{ "controller_registers::testControllerReset", controller_registers::testControllerReset, true });
+					testCases.push_back(TEST_CASE{ "subsystem::testMultiControllerSharedPool", subsystem::testMultiControllerSharedPool, true });
+					testCases.push_back(TEST_CASE{ "subsystem::testControllerPoolReuse", subsystem::testControllerPoolReuse, false });
+					testCases.push_back(TEST_CASE{ "commands::testNVMeCommandOpcodeInvalid", commands::testNVMeCommandOpcodeInvalid, false });
+					testCases.push_back(TEST_CASE{ "commands::testNVMeCommandParsing", commands::testNVMeCommandParsing, false });
+					testCases.push_back(TEST_CASE{ "commands::testNVMeFirmwareDownloadAndCommit", commands::testNVMeFirmwareDownloadAndCommit, true });
+					testCases.push_back(TEST_CASE{ "commands::testNVMeIo", commands::testNVMeIo, true });
+					testCases.push_back(TEST_CASE{ "commands::testNVMeIoWithQueueWorkers", commands::testNVMeIoWithQueueWorkers, true });
+					testCases.push_back(TEST_CASE{ "commands::testNVMeQueueDeletionFailures", commands::testNVMeQueueDeletionFailures, false });
+					testCases.push_back(TEST_CASE{ "commands::testNVMeBackgroundFormat", commands::testNVMeBackgroundFormat, true });
+					testCases.push_back(TEST_CASE{ "driver::testNoDataCommandViaDriver", driver::testNoDataCommandViaDriver, false });
+					testCases.push_back(TEST_CASE{ "driver::testReadCommandViaDriver", driver::testReadCommandViaDriver, false });
+					testCases.push_back(TEST_CASE{ "driver::testAsyncCommandsViaDriver", driver::testAsyncCommandsViaDriver, false });
+					testCases.push_back(TEST_CASE{ "driver::testVendorPerformanceLogPage", driver::testVendorPerformanceLogPage, false });
+					testCases.push_back(TEST_CASE{ "driver::testShadowDoorbellsViaDriver", driver::testShadowDoorbellsViaDriver, true });
+					testCases.push_back(TEST_CASE{ "driver::testSmartHealthLogPage", driver::testSmartHealthLogPage, false });
+					testCases.push_back(TEST_CASE{ "driver::testRegisteredMemoryRegionIO", driver::testRegisteredMemoryRegionIO, false });
+					testCases.push_back(TEST_CASE{ "driver::testTimingEngineLatencyModel", driver::testTimingEngineLatencyModel, false });
+					testCases.push_back(TEST_CASE{ "benchmark::testBenchmarkSmoke", benchmark::testBenchmarkSmoke, true });
+					testCases.push_back(TEST_CASE{ "trace::testTraceCaptureAndReplay", trace::testTraceCaptureAndReplay, true });
+					testCases.push_back(TEST_CASE{ "media::testFileBackedMediaPersistence", media::testFileBackedMediaPersistence, false });
+					testCases.push_back(TEST_CASE{ "media::testConcurrentNamespaceIO", media::testConcurrentNamespaceIO, false });
+					testCases.push_back(TEST_CASE{ "media::testNamespaceSnapshotAndClone", media::testNamespaceSnapshotAndClone, false });
+					testCases.push_back(TEST_CASE{ "media::testMediaDeduplication", media::testMediaDeduplication, false });
+					testCases.push_back(TEST_CASE{ "prp::testDifferentPRPSizes", prp::testDifferentPRPSizes, false });
+					testCases.push_back(TEST_CASE{ "prp::testDataIntoExistingPRP", prp::testDataIntoExistingPRP, false });
+					testCases.push_back(TEST_CASE{ "logging::testAsserting", logging::testAsserting, false });
+				}
+
+				// Dispatch the slow (mostly idle-waiting) tests first, so a straggler isn't the
+				//  last thing picked up. With enough workers the suite's wall time is bounded
+				//  by the single slowest test instead of the sum of all the sleeps.
+				std::stable_sort(testCases.begin(), testCases.end(), [](const TEST_CASE& lhs, const TEST_CASE& rhs)
+				{
+					return lhs.Slow && !rhs.Slow;
+				});
+
+				std::vector<TEST_RESULT> testResults(testCases.size());
+
+				// Slow tests sit in sleeps/polls, so it is fine to oversubscribe the cores a bit
+				size_t workerCount = std::min(testCases.size(), (size_t)std::max(4u, std::thread::hardware_concurrency() * 2));
+				std::atomic<size_t> nextTestIndex(0);
+				std::vector<std::thread> workers;
+				for (size_t workerIdx = 0; workerIdx < workerCount; workerIdx++)
+				{
+					workers.push_back(std::thread([&testCases, &testResults, &nextTestIndex]()
+					{
+						for (;;)
+						{
+							size_t testIndex = nextTestIndex.fetch_add(1);
+							if (testIndex >= testCases.size())
+							{
+								return; // no tests left to grab
+							}
+
+							UINT_64 startMilliseconds = getTimeInMilliseconds();
+							testResults[testIndex].Passed = testCases[testIndex].Function();
+							testResults[testIndex].Milliseconds = getTimeInMilliseconds() - startMilliseconds;
+						}
+					}));
 				}
 
+				for (auto &worker : workers)
+				{
+					worker.join();
+				}
+
+				// Per-test timing so slow regressions stand out in CI logs
 				bool retVal = true;
-				for (auto &i : results)
+				for (size_t testIndex = 0; testIndex < testCases.size(); testIndex++)
 				{
-					retVal &= i.get();
+					std::cout << (testResults[testIndex].Passed ? "[PASS] " : "[FAIL] ") << testCases[testIndex].Name <<
+						" (" << testResults[testIndex].Milliseconds << " ms)" << std::endl;
+					retVal &= testResults[testIndex].Passed;
 				}
 
 				return retVal;
@@ -81,11 +160,24 @@ namespace cnvme
 
 			void randomizePayload(Payload & payload)
 			{
-				// Can't afford to take the time to randomize a 128MB buffer... so just randomly flip some bytes
-				UINT_32 jumpNum = (UINT_32)randInt((UINT_64)payload.getSize() / 4, (UINT_64)payload.getSize() / 2);
-				for (UINT_32 i = 0; i < payload.getSize(); i += jumpNum)
+				// xorshift64* fills 8 bytes per step, so even a 128MB buffer gets fully
+				//  randomized far faster than the old byte-at-a-time rand() ever could.
+				UINT_64 state = ((UINT_64)getTimeInMilliseconds() << 32) ^ payload.getMemoryAddress() ^ randInt(1, (UINT_64)-1);
+				state |= 1; // the generator can't leave a state of 0
+
+				BYTE* buffer = payload.getBuffer();
+				size_t bytesRemaining = payload.getSize();
+				while (bytesRemaining > 0)
 				{
-					payload.getBuffer()[i] = (BYTE)randInt(0, 0xFF);
+					state ^= state >> 12;
+					state ^= state << 25;
+					state ^= state >> 27;
+					UINT_64 randomValue = state * 0x2545F4914F6CDD1DULL;
+
+					size_t bytesThisStep = std::min(bytesRemaining, sizeof(randomValue));
+					memcpy_s(buffer, bytesRemaining, &randomValue, bytesThisStep);
+					buffer += bytesThisStep;
+					bytesRemaining -= bytesThisStep;
 				}
 			}
 
@@ -189,6 +281,7 @@ namespace cnvme
 				UINT_64 deathTime = helpers::getTimeInMilliseconds() + timeoutMs;
 				while (helpers::getTimeInMilliseconds() < deathTime)
 				{
+					controllerRegisters.waitForChangeLoop(); // one register service pass (inline when SINGLE_THREADED)
 					if (CR->CSTS.RDY == 1)
 					{
 						rdyTo1 = true;
@@ -207,6 +300,7 @@ namespace cnvme
 				bool rdyTo0 = false;
 				while (helpers::getTimeInMilliseconds() < deathTime)
 				{
+					controllerRegisters.waitForChangeLoop(); // one register service pass (inline when SINGLE_THREADED)
 					if (CR->CSTS.RDY == 0)
 					{
 						rdyTo0 = true;
@@ -220,6 +314,7 @@ namespace cnvme
 				deathTime = helpers::getTimeInMilliseconds() + timeoutMs;
 				while (helpers::getTimeInMilliseconds() < deathTime)
 				{
+					controllerRegisters.waitForChangeLoop(); // one register service pass (inline when SINGLE_THREADED)
 					if (CR->CSTS.RDY == 1)
 					{
 						rdyTo1 = true;
@@ -236,6 +331,116 @@ namespace cnvme
 			}
 		}
 
+		namespace subsystem
+		{
+			bool testMultiControllerSharedPool()
+			{
+				size_t poolThreadCount = 2;
+				size_t controllerCount = 4;
+
+				controller::Subsystem testSubsystem(poolThreadCount);
+				FAIL_IF(testSubsystem.getPoolThreadCount() != poolThreadCount, "The pool should have exactly the requested thread count");
+
+				for (size_t i = 0; i < controllerCount; i++)
+				{
+					testSubsystem.addController();
+				}
+				FAIL_IF(testSubsystem.getControllerCount() != controllerCount, "Should have every added controller");
+
+				for (size_t i = 0; i < controllerCount; i++)
+				{
+					auto &controller = testSubsystem.getController(i);
+
+					// the pooled PCIe watcher did this controller's initial function level reset
+					FAIL_IF(controller.getPCIExpressRegisters()->getPciExpressRegisters().PciHeader->ID.VID != 0xAACC, "VID was not set by the function level reset");
+
+					// the pooled register watcher handles enables/resets
+					auto CR = controller.getControllerRegisters()->getControllerRegisters();
+					auto timeoutMs = CR->CAP.TO * 500; // CAP.TO is in 500 millisecond intervals
+					FAIL_IF(CR->CSTS.RDY != 0, "CSTS.RDY should be 0 before the controller is enabled");
+
+					CR->CC.EN = 1;
+
+					bool rdyTo1 = false;
+					UINT_64 deathTime = helpers::getTimeInMilliseconds() + timeoutMs;
+					while (helpers::getTimeInMilliseconds() < deathTime)
+					{
+						controller.getControllerRegisters()->waitForChangeLoop(); // one register service pass (inline when SINGLE_THREADED)
+						if (CR->CSTS.RDY == 1)
+						{
+							rdyTo1 = true;
+							break;
+						}
+					}
+					FAIL_IF(rdyTo1 == false, "CSTS.RDY did not transition to 1 after CC.EN was set to 1");
+
+					CR->CC.EN = 0; // Begin Reset
+					bool rdyTo0 = false;
+					deathTime = helpers::getTimeInMilliseconds() + timeoutMs;
+					while (helpers::getTimeInMilliseconds() < deathTime)
+					{
+						controller.getControllerRegisters()->waitForChangeLoop(); // one register service pass (inline when SINGLE_THREADED)
+						if (CR->CSTS.RDY == 0)
+						{
+							rdyTo0 = true;
+							break;
+						}
+					}
+					FAIL_IF(rdyTo0 == false, "CSTS.RDY did not transition to 0 after CC.EN was set to 0");
+				}
+
+				return true; // the Subsystem destructor tears everything down
+			}
+
+			bool testControllerPoolReuse()
+			{
+				cnvme::controller::ControllerPool pool;
+
+				auto enableAndWaitForReady = [&](cnvme::controller::Controller* controller) -> bool
+				{
+					auto CR = controller->getControllerRegisters()->getControllerRegisters();
+					FAIL_IF(CR == nullptr, "The pooled controller has no registers");
+					FAIL_IF(CR->CC.EN != 0, "A controller from the pool should come out disabled");
+					FAIL_IF(CR->CSTS.RDY != 0, "A controller from the pool should come out not ready");
+
+					CR->CC.EN = 1;
+					bool rdyTo1 = false;
+					UINT_64 deathTime = helpers::getTimeInMilliseconds() + ((UINT_64)CR->CAP.TO * 500);
+					while (helpers::getTimeInMilliseconds() < deathTime)
+					{
+						controller->getControllerRegisters()->waitForChangeLoop(); // one register service pass (inline when SINGLE_THREADED)
+						if (CR->CSTS.RDY == 1)
+						{
+							rdyTo1 = true;
+							break;
+						}
+					}
+					FAIL_IF(rdyTo1 == false, "The controller did not become ready after CC.EN was set to 1");
+					return true;
+				};
+
+				auto firstController = pool.acquire();
+				FAIL_IF(firstController == nullptr, "The pool didn't hand out a controller");
+				FAIL_IF(!enableAndWaitForReady(firstController), "The first controller from the pool didn't come up");
+
+				pool.release(firstController);
+
+				// The pool should hand the same instance back, recycled to a fresh state
+				auto secondController = pool.acquire();
+				FAIL_IF(secondController != firstController, "The pool built a new controller instead of reusing the parked one");
+				FAIL_IF(!enableAndWaitForReady(secondController), "The recycled controller didn't come back up");
+
+				// With that instance out, the pool has to build a distinct second one
+				auto thirdController = pool.acquire();
+				FAIL_IF(thirdController == secondController, "The pool handed the same controller out twice");
+				FAIL_IF(!enableAndWaitForReady(thirdController), "The pool's second controller didn't come up");
+
+				pool.release(secondController);
+				pool.release(thirdController);
+				return true; // the pool's destructor deletes the parked controllers
+			}
+		}
+
 		namespace commands
 		{
 			bool testNVMeCommandParsing()
@@ -474,6 +679,95 @@ namespace cnvme
 				return true;
 			}
 
+			bool testNVMeIoWithQueueWorkers()
+			{
+				cnvme::driver::Driver driver;
+				driver.setIoQueueWorkersEnabled(true);
+
+				Payload payload(8192); // generic large size
+				auto pDriverCommand = (cnvme::driver::PDRIVER_COMMAND)payload.getBuffer();
+				pDriverCommand->QueueId = ADMIN_QUEUE_ID;
+				pDriverCommand->Timeout = 5; // arbitrary
+				pDriverCommand->TransferDataDirection = cnvme::driver::NO_DATA;
+
+				// Create 2 IO queue pairs. Each submission queue should get its own worker.
+				UINT_16 numberOfQueuePairs = 2;
+				for (UINT_16 queueId = 1; queueId <= numberOfQueuePairs; queueId++)
+				{
+					pDriverCommand->Command.DWord0Breakdown.OPC = constants::opcodes::admin::CREATE_IO_COMPLETION_QUEUE;
+					pDriverCommand->Command.DW10_CreateIoQueue.QSIZE = 0xF;
+					pDriverCommand->Command.DW10_CreateIoQueue.QID = queueId;
+					pDriverCommand->Command.DW11_CreateIoCompletionQueue.IEN = 1;
+					pDriverCommand->Command.DW11_CreateIoCompletionQueue.PC = 1;
+					driver.sendCommand(payload.getBuffer(), payload.getSize());
+					FAIL_IF(!pDriverCommand->CompletionQueueEntry.succeeded(), "Controller failed creating an io completion queue");
+
+					pDriverCommand->Command.DWord0Breakdown.OPC = constants::opcodes::admin::CREATE_IO_SUBMISSION_QUEUE;
+					pDriverCommand->Command.DW11_CreateIoSubmissionQueue.PC = 1;
+					pDriverCommand->Command.DW11_CreateIoSubmissionQueue.CQID = queueId;
+					driver.sendCommand(payload.getBuffer(), payload.getSize());
+					FAIL_IF(!pDriverCommand->CompletionQueueEntry.succeeded(), "Controller failed creating an io submission queue");
+				}
+
+				// Write a distinct sector per queue, then read each back through the same queue
+				for (UINT_16 queueId = 1; queueId <= numberOfQueuePairs; queueId++)
+				{
+					UINT_8 sectorValue = (UINT_8)(0xA0 + queueId);
+
+					memset(&pDriverCommand->Command, 0, sizeof(pDriverCommand->Command));
+					pDriverCommand->QueueId = queueId;
+					pDriverCommand->Command.NSID = 1;
+					pDriverCommand->Command.DWord0Breakdown.OPC = constants::opcodes::nvm::WRITE;
+					pDriverCommand->Command.DW12_IO.NLB = ZERO_BASED_FROM_ONE_BASED(1);
+					pDriverCommand->Command.SLBA = ZERO_BASED_FROM_ONE_BASED(queueId);
+					pDriverCommand->TransferDataDirection = cnvme::driver::WRITE;
+					pDriverCommand->TransferDataSize = 512; // default sector size
+					memset(&pDriverCommand->TransferData, sectorValue, 512);
+					driver.sendCommand(payload.getBuffer(), payload.getSize());
+					FAIL_IF(!pDriverCommand->CompletionQueueEntry.succeeded(), "Failed to write a sector via an IO queue worker");
+				}
+
+				for (UINT_16 queueId = 1; queueId <= numberOfQueuePairs; queueId++)
+				{
+					UINT_8 sectorValue = (UINT_8)(0xA0 + queueId);
+
+					memset(&pDriverCommand->Command, 0, sizeof(pDriverCommand->Command));
+					pDriverCommand->QueueId = queueId;
+					pDriverCommand->Command.NSID = 1;
+					pDriverCommand->Command.DWord0Breakdown.OPC = constants::opcodes::nvm::READ;
+					pDriverCommand->Command.DW12_IO.NLB = ZERO_BASED_FROM_ONE_BASED(1);
+					pDriverCommand->Command.SLBA = ZERO_BASED_FROM_ONE_BASED(queueId);
+					pDriverCommand->TransferDataDirection = cnvme::driver::READ;
+					pDriverCommand->TransferDataSize = 512;
+					driver.sendCommand(payload.getBuffer(), payload.getSize());
+					FAIL_IF(!pDriverCommand->CompletionQueueEntry.succeeded(), "Failed to read a sector via an IO queue worker");
+
+					for (size_t i = 0; i < 512; i++)
+					{
+						FAIL_IF(pDriverCommand->TransferData[i] != sectorValue, "Comparison failure: the read data didn't match what was written via the queue's worker");
+					}
+				}
+
+				// Make sure we can still tear the queues down with workers enabled
+				for (UINT_16 queueId = 1; queueId <= numberOfQueuePairs; queueId++)
+				{
+					memset(&pDriverCommand->Command, 0, sizeof(pDriverCommand->Command));
+					pDriverCommand->QueueId = ADMIN_QUEUE_ID;
+					pDriverCommand->TransferDataDirection = cnvme::driver::NO_DATA;
+					pDriverCommand->TransferDataSize = 0;
+					pDriverCommand->Command.DWord0Breakdown.OPC = constants::opcodes::admin::DELETE_IO_SUBMISSION_QUEUE;
+					pDriverCommand->Command.DW10_DeleteIoQueue.QID = queueId;
+					driver.sendCommand(payload.getBuffer(), payload.getSize());
+					FAIL_IF(!pDriverCommand->CompletionQueueEntry.succeeded(), "Failed to delete an IO submission queue with workers enabled");
+
+					pDriverCommand->Command.DWord0Breakdown.OPC = constants::opcodes::admin::DELETE_IO_COMPLETION_QUEUE;
+					driver.sendCommand(payload.getBuffer(), payload.getSize());
+					FAIL_IF(!pDriverCommand->CompletionQueueEntry.succeeded(), "Failed to delete an IO completion queue with workers enabled");
+				}
+
+				return true;
+			}
+
 			bool testNVMeFirmwareDownloadAndCommit()
 			{
 				cnvme::driver::TestDriver driver;
@@ -503,6 +797,18 @@ namespace cnvme
 				FAIL_IF(!driver.controllerReset(), "Controller reset failed!");
 				FAIL_IF(driver.getFirmwareString() != updatedFirmware, "FW changed after reset when it shouldn't have");
 
+				// Test out of order download: chunks after the first can arrive in any order
+				updatedFirmware = "NEWFW003";
+				auto outOfOrderSegments = helpers::getFirmwareImage(updatedFirmware, fwSize).split(fwSize / 4);
+				UINT_32 segmentDWords = (UINT_32)DWORDS_FROM_BYTES(outOfOrderSegments[0].getSize());
+				FAIL_IF(!driver.firmwareImageDownload(0, outOfOrderSegments[0]).CompletionQueueEntry.succeeded(), "Failed to download the FW image part 1/4");
+				FAIL_IF(!driver.firmwareImageDownload(segmentDWords * 2, outOfOrderSegments[2]).CompletionQueueEntry.succeeded(), "Failed to download the FW image part 3/4");
+				FAIL_IF(!driver.firmwareImageDownload(segmentDWords, outOfOrderSegments[1]).CompletionQueueEntry.succeeded(), "Failed to download the FW image part 2/4");
+				FAIL_IF(!driver.firmwareImageDownload(segmentDWords * 3, outOfOrderSegments[3]).CompletionQueueEntry.succeeded(), "Failed to download the FW image part 4/4");
+				FAIL_IF(!driver.firmwareCommit(constants::commands::fw_commit::commit_action::REPLACE_IN_SLOT_NO_ACTIVATE, 6).CompletionQueueEntry.succeeded(), "Failed to commit an out of order downloaded image");
+				FAIL_IF(!driver.firmwareCommit(constants::commands::fw_commit::commit_action::ACTIVATE_GIVEN_SLOT_NOW, 6).CompletionQueueEntry.succeeded(), "Failed to activate the FW in slot 6");
+				FAIL_IF(driver.getFirmwareString() != updatedFirmware, "FW did not change after activating an out of order downloaded image");
+
 				// Test fw/dl can return overlapping range
 				FAIL_IF(!driver.firmwareImageDownload(0, fwPayloadSegments[0]).CompletionQueueEntry.succeeded(), "Failed to download the FW image part 1/2");
 				FAIL_IF(driver.firmwareImageDownload(1, fwPayloadSegments[1]).CompletionQueueEntry.SC != constants::status::codes::specific::OVERLAPPING_RANGE, "Overlapping range was not returned");
@@ -511,6 +817,93 @@ namespace cnvme
 				FAIL_IF(!driver.firmwareImageDownload(0, Payload(4096)).CompletionQueueEntry.succeeded(), "Failed to download empty FW image");
 				FAIL_IF(driver.firmwareCommit(constants::commands::fw_commit::commit_action::REPLACE_IN_SLOT_NO_ACTIVATE, 5).CompletionQueueEntry.SC != constants::status::codes::specific::INVALID_FIRMWARE_IMAGE, "FW did not return invalid firmware image on an invalid image");
 
+				return true;
+			}
+			bool testNVMeBackgroundFormat()
+			{
+				cnvme::driver::Driver driver;
+
+				Payload payload(8192); // generic large size
+				auto pDriverCommand = (cnvme::driver::PDRIVER_COMMAND)payload.getBuffer();
+				pDriverCommand->QueueId = ADMIN_QUEUE_ID;
+				pDriverCommand->Timeout = 5;
+				pDriverCommand->TransferDataDirection = cnvme::driver::NO_DATA;
+
+				// Create CQ/SQ 1 so we have IO to run alongside the format
+				pDriverCommand->Command.DWord0Breakdown.OPC = constants::opcodes::admin::CREATE_IO_COMPLETION_QUEUE;
+				pDriverCommand->Command.DW10_CreateIoQueue.QSIZE = 0xF;
+				pDriverCommand->Command.DW10_CreateIoQueue.QID = 1;
+				pDriverCommand->Command.DW11_CreateIoCompletionQueue.IEN = 1;
+				pDriverCommand->Command.DW11_CreateIoCompletionQueue.PC = 1;
+				driver.sendCommand(payload.getBuffer(), payload.getSize());
+				FAIL_IF(!pDriverCommand->CompletionQueueEntry.succeeded(), "Controller failed creating an io completion queue");
+
+				pDriverCommand->Command.DW10_CreateIoQueue.QSIZE = 0xF;
+				pDriverCommand->Command.DW10_CreateIoQueue.QID = 1;
+				pDriverCommand->Command.DW11_CreateIoSubmissionQueue.PC = 1;
+				pDriverCommand->Command.DW11_CreateIoSubmissionQueue.CQID = 1;
+				pDriverCommand->Command.DWord0Breakdown.OPC = constants::opcodes::admin::CREATE_IO_SUBMISSION_QUEUE;
+				driver.sendCommand(payload.getBuffer(), payload.getSize());
+				FAIL_IF(!pDriverCommand->CompletionQueueEntry.succeeded(), "Controller failed creating an io submission queue");
+
+				// Put known data on the first sector
+				memset(&pDriverCommand->Command, 0, sizeof(pDriverCommand->Command));
+				pDriverCommand->QueueId = 1;
+				pDriverCommand->TransferDataSize = 512;
+				pDriverCommand->TransferDataDirection = cnvme::driver::WRITE;
+				pDriverCommand->Command.NSID = 1;
+				pDriverCommand->Command.DWord0Breakdown.OPC = constants::opcodes::nvm::WRITE;
+				pDriverCommand->Command.DW12_IO.NLB = ZERO_BASED_FROM_ONE_BASED(1);
+				memset(&pDriverCommand->TransferData, 0xAB, 512);
+				driver.sendCommand(payload.getBuffer(), payload.getSize());
+				FAIL_IF(!pDriverCommand->CompletionQueueEntry.succeeded(), "Failed to write known data before the format");
+
+				// Kick off the format asynchronously: it executes on the background engine
+				Payload formatBuffer(sizeof(cnvme::driver::DRIVER_COMMAND));
+				auto pFormatCommand = (cnvme::driver::PDRIVER_COMMAND)formatBuffer.getBuffer();
+				pFormatCommand->QueueId = ADMIN_QUEUE_ID;
+				pFormatCommand->Timeout = 5;
+				pFormatCommand->TransferDataDirection = cnvme::driver::NO_DATA;
+				pFormatCommand->Command.DWord0Breakdown.OPC = constants::opcodes::admin::FORMAT_NVM;
+				pFormatCommand->Command.NSID = 1;
+				FAIL_IF(driver.submitCommand(formatBuffer.getBuffer(), formatBuffer.getSize()) == INVALID_COMMAND_HANDLE, "Failed to submit the format asynchronously");
+
+				// The doorbell thread should still be servicing queues while the format runs
+				memset(&pDriverCommand->Command, 0, sizeof(pDriverCommand->Command));
+				pDriverCommand->QueueId = 1;
+				pDriverCommand->TransferDataSize = 512;
+				pDriverCommand->TransferDataDirection = cnvme::driver::READ;
+				pDriverCommand->Command.NSID = 1;
+				pDriverCommand->Command.DWord0Breakdown.OPC = constants::opcodes::nvm::READ;
+				pDriverCommand->Command.DW12_IO.NLB = ZERO_BASED_FROM_ONE_BASED(1);
+				driver.sendCommand(payload.getBuffer(), payload.getSize());
+				FAIL_IF(!pDriverCommand->CompletionQueueEntry.succeeded(), "IO did not complete while the format was outstanding");
+
+				// Reap the format and make sure it succeeded
+				UINT_64 deathTime = helpers::getTimeInMilliseconds() + 30000;
+				while (driver.getOutstandingCommandCount() && helpers::getTimeInMilliseconds() < deathTime)
+				{
+					driver.reapCompletions(1, 5);
+				}
+				FAIL_IF(driver.getOutstandingCommandCount() != 0, "The background format never completed");
+				FAIL_IF(pFormatCommand->DriverStatus != cnvme::driver::SENT_SUCCESSFULLY, "The format did not complete successfully");
+				FAIL_IF(!pFormatCommand->CompletionQueueEntry.succeeded(), "The background format failed");
+
+				// After the format the known data should be gone
+				memset(&pDriverCommand->Command, 0, sizeof(pDriverCommand->Command));
+				pDriverCommand->QueueId = 1;
+				pDriverCommand->TransferDataSize = 512;
+				pDriverCommand->TransferDataDirection = cnvme::driver::READ;
+				pDriverCommand->Command.NSID = 1;
+				pDriverCommand->Command.DWord0Breakdown.OPC = constants::opcodes::nvm::READ;
+				pDriverCommand->Command.DW12_IO.NLB = ZERO_BASED_FROM_ONE_BASED(1);
+				driver.sendCommand(payload.getBuffer(), payload.getSize());
+				FAIL_IF(!pDriverCommand->CompletionQueueEntry.succeeded(), "Failed to read back after the format");
+				for (size_t i = 0; i < 512; i++)
+				{
+					FAIL_IF(pDriverCommand->TransferData[i] != 0, "The format should have erased the known data");
+				}
+
 				return true;
 			}
 		}
@@ -588,6 +981,733 @@ namespace cnvme
 
 				return true;
 			}
+
+			bool testAsyncCommandsViaDriver()
+			{
+				cnvme::driver::Driver driver;
+				const UINT_32 COMMAND_COUNT = 8;
+				UINT_32 BUF_SIZE = sizeof(cnvme::driver::DRIVER_COMMAND);
+
+				std::atomic<UINT_32> callbackCount(0);
+				auto callback = [&callbackCount](cnvme::driver::PDRIVER_COMMAND pCommand)
+				{
+					callbackCount++;
+				};
+
+				// Each in-flight command needs its own buffer that lives until it gets reaped
+				std::vector<Payload> commandBuffers(COMMAND_COUNT, Payload(BUF_SIZE));
+				std::vector<cnvme::driver::COMMAND_HANDLE> handles;
+
+				for (UINT_32 i = 0; i < COMMAND_COUNT; i++)
+				{
+					auto pDriverCommand = (cnvme::driver::PDRIVER_COMMAND)commandBuffers[i].getBuffer();
+					pDriverCommand->QueueId = ADMIN_QUEUE_ID;
+					pDriverCommand->Timeout = 5;
+					pDriverCommand->TransferDataDirection = cnvme::driver::NO_DATA;
+					pDriverCommand->Command.DWord0Breakdown.OPC = cnvme::constants::opcodes::admin::KEEP_ALIVE;
+
+					auto handle = driver.submitCommand(commandBuffers[i].getBuffer(), BUF_SIZE, callback);
+					FAIL_IF(handle == INVALID_COMMAND_HANDLE, "Failed to submit an async command");
+					handles.push_back(handle);
+				}
+
+				FAIL_IF(driver.getOutstandingCommandCount() != COMMAND_COUNT, "All submitted commands should be outstanding until reaped");
+
+				// Reap the entire batch from this one thread
+				UINT_32 reaped = 0;
+				UINT_64 deathTime = helpers::getTimeInMilliseconds() + 30000;
+				while (reaped < COMMAND_COUNT && helpers::getTimeInMilliseconds() < deathTime)
+				{
+					reaped += driver.reapCompletions(COMMAND_COUNT - reaped, 5);
+				}
+
+				FAIL_IF(reaped != COMMAND_COUNT, "Did not reap every submitted command");
+				FAIL_IF(callbackCount != COMMAND_COUNT, "Every reaped command should have fired its callback");
+				FAIL_IF(driver.getOutstandingCommandCount() != 0, "No commands should be outstanding after reaping them all");
+
+				for (UINT_32 i = 0; i < COMMAND_COUNT; i++)
+				{
+					auto pDriverCommand = (cnvme::driver::PDRIVER_COMMAND)commandBuffers[i].getBuffer();
+					FAIL_IF(pDriverCommand->DriverStatus != cnvme::driver::SENT_SUCCESSFULLY, "An async command did not complete successfully");
+					FAIL_IF(pDriverCommand->CompletionQueueEntry.CID != pDriverCommand->Command.DWord0Breakdown.CID, "Completion CID should match that of the submission");
+				}
+
+				// Queue management has to stay synchronous
+				Payload queueCommandBuffer(BUF_SIZE);
+				auto pQueueCommand = (cnvme::driver::PDRIVER_COMMAND)queueCommandBuffer.getBuffer();
+				pQueueCommand->QueueId = ADMIN_QUEUE_ID;
+				pQueueCommand->Timeout = 5;
+				pQueueCommand->TransferDataDirection = cnvme::driver::NO_DATA;
+				pQueueCommand->Command.DWord0Breakdown.OPC = cnvme::constants::opcodes::admin::CREATE_IO_COMPLETION_QUEUE;
+				FAIL_IF(driver.submitCommand(queueCommandBuffer.getBuffer(), BUF_SIZE) != INVALID_COMMAND_HANDLE, "Queue management commands should not be allowed asynchronously");
+				FAIL_IF(pQueueCommand->DriverStatus != cnvme::driver::INVALID_COMMAND_FOR_ASYNC, "Rejected async queue management command should say why");
+
+				return true;
+			}
+
+			bool testRegisteredMemoryRegionIO()
+			{
+				cnvme::driver::Driver driver;
+
+				Payload payload(sizeof(cnvme::driver::DRIVER_COMMAND));
+				auto pDriverCommand = (cnvme::driver::PDRIVER_COMMAND)payload.getBuffer();
+				pDriverCommand->QueueId = ADMIN_QUEUE_ID;
+				pDriverCommand->Timeout = 5;
+				pDriverCommand->TransferDataDirection = cnvme::driver::NO_DATA;
+
+				// Create CQ/SQ 1 to run the IO on
+				pDriverCommand->Command.DWord0Breakdown.OPC = constants::opcodes::admin::CREATE_IO_COMPLETION_QUEUE;
+				pDriverCommand->Command.DW10_CreateIoQueue.QSIZE = 0xF;
+				pDriverCommand->Command.DW10_CreateIoQueue.QID = 1;
+				pDriverCommand->Command.DW11_CreateIoCompletionQueue.IEN = 1;
+				pDriverCommand->Command.DW11_CreateIoCompletionQueue.PC = 1;
+				driver.sendCommand(payload.getBuffer(), payload.getSize());
+				FAIL_IF(!pDriverCommand->CompletionQueueEntry.succeeded(), "Controller failed creating an io completion queue");
+
+				pDriverCommand->Command.DW10_CreateIoQueue.QSIZE = 0xF;
+				pDriverCommand->Command.DW10_CreateIoQueue.QID = 1;
+				pDriverCommand->Command.DW11_CreateIoSubmissionQueue.PC = 1;
+				pDriverCommand->Command.DW11_CreateIoSubmissionQueue.CQID = 1;
+				pDriverCommand->Command.DWord0Breakdown.OPC = constants::opcodes::admin::CREATE_IO_SUBMISSION_QUEUE;
+				driver.sendCommand(payload.getBuffer(), payload.getSize());
+				FAIL_IF(!pDriverCommand->CompletionQueueEntry.succeeded(), "Controller failed creating an io submission queue");
+
+				// Register a buffer big enough to need a PRP list (more than 2 memory pages)
+				UINT_32 transferSize = 16384;
+				Payload regionBuffer(transferSize);
+				auto token = driver.registerMemoryRegion(regionBuffer.getBuffer(), regionBuffer.getSize());
+				FAIL_IF(token == INVALID_MEMORY_REGION_TOKEN, "Registering a memory region did not return a token");
+
+				// Write the whole namespace straight out of the registered buffer
+				Payload writtenData(transferSize);
+				helpers::randomizePayload(writtenData);
+				memcpy_s(regionBuffer.getBuffer(), regionBuffer.getSize(), writtenData.getBuffer(), writtenData.getSize());
+
+				memset(&pDriverCommand->Command, 0, sizeof(pDriverCommand->Command));
+				pDriverCommand->QueueId = 1;
+				pDriverCommand->TransferDataSize = transferSize;
+				pDriverCommand->TransferDataDirection = cnvme::driver::WRITE;
+				pDriverCommand->MemoryRegionToken = token;
+				pDriverCommand->Command.NSID = 1;
+				pDriverCommand->Command.DWord0Breakdown.OPC = constants::opcodes::nvm::WRITE;
+				pDriverCommand->Command.DW12_IO.NLB = ZERO_BASED_FROM_ONE_BASED(transferSize / 512);
+				driver.sendCommand(payload.getBuffer(), payload.getSize());
+				FAIL_IF(pDriverCommand->DriverStatus != cnvme::driver::SENT_SUCCESSFULLY, "Driver didn't take the write through the registered region");
+				FAIL_IF(!pDriverCommand->CompletionQueueEntry.succeeded(), "Failed to write through the registered region");
+
+				// Read it back: the controller should land the data right back in the buffer
+				regionBuffer.clear();
+				pDriverCommand->TransferDataDirection = cnvme::driver::READ;
+				pDriverCommand->Command.DWord0Breakdown.OPC = constants::opcodes::nvm::READ;
+				driver.sendCommand(payload.getBuffer(), payload.getSize());
+				FAIL_IF(!pDriverCommand->CompletionQueueEntry.succeeded(), "Failed to read through the registered region");
+				FAIL_IF(regionBuffer != writtenData, "The read did not land the written data in the registered buffer");
+
+				// A transfer bigger than the region must be rejected before anything is sent
+				pDriverCommand->TransferDataSize = transferSize * 2;
+				driver.sendCommand(payload.getBuffer(), payload.getSize());
+				FAIL_IF(pDriverCommand->DriverStatus != cnvme::driver::INVALID_DATA_LENGTH, "A transfer larger than the region was not rejected");
+
+				// A stale token must be rejected too
+				FAIL_IF(!driver.unregisterMemoryRegion(token), "Failed to unregister the memory region");
+				FAIL_IF(driver.unregisterMemoryRegion(token), "Unregistering the same region twice somehow worked");
+				pDriverCommand->TransferDataSize = transferSize;
+				driver.sendCommand(payload.getBuffer(), payload.getSize());
+				FAIL_IF(pDriverCommand->DriverStatus != cnvme::driver::UNKNOWN_MEMORY_REGION_TOKEN, "A stale region token was not rejected");
+
+				return true;
+			}
+
+
+			bool testTimingEngineLatencyModel()
+			{
+				// Releases the engine on the way out so a FAIL_IF can't strand a controller
+				//  thread parked on an unadvanced virtual clock
+				struct RELEASE_ON_SCOPE_LOSS
+				{
+					RELEASE_ON_SCOPE_LOSS(const std::shared_ptr<timing::TimingEngine>& engine) : Engine(engine) {}
+					~RELEASE_ON_SCOPE_LOSS() { Engine->release(); }
+					std::shared_ptr<timing::TimingEngine> Engine;
+				};
+
+				auto buildIoQueues = [&](cnvme::driver::Driver& driver, Payload& payload) -> bool
+				{
+					auto pDriverCommand = (cnvme::driver::PDRIVER_COMMAND)payload.getBuffer();
+					memset(pDriverCommand, 0, sizeof(cnvme::driver::DRIVER_COMMAND));
+					pDriverCommand->QueueId = ADMIN_QUEUE_ID;
+					pDriverCommand->Timeout = 5;
+					pDriverCommand->TransferDataDirection = cnvme::driver::NO_DATA;
+
+					pDriverCommand->Command.DWord0Breakdown.OPC = constants::opcodes::admin::CREATE_IO_COMPLETION_QUEUE;
+					pDriverCommand->Command.DW10_CreateIoQueue.QSIZE = 0xF;
+					pDriverCommand->Command.DW10_CreateIoQueue.QID = 1;
+					pDriverCommand->Command.DW11_CreateIoCompletionQueue.IEN = 1;
+					pDriverCommand->Command.DW11_CreateIoCompletionQueue.PC = 1;
+					driver.sendCommand(payload.getBuffer(), payload.getSize());
+					FAIL_IF(!pDriverCommand->CompletionQueueEntry.succeeded(), "Controller failed creating an io completion queue");
+
+					pDriverCommand->Command.DW10_CreateIoQueue.QSIZE = 0xF;
+					pDriverCommand->Command.DW10_CreateIoQueue.QID = 1;
+					pDriverCommand->Command.DW11_CreateIoSubmissionQueue.PC = 1;
+					pDriverCommand->Command.DW11_CreateIoSubmissionQueue.CQID = 1;
+					pDriverCommand->Command.DWord0Breakdown.OPC = constants::opcodes::admin::CREATE_IO_SUBMISSION_QUEUE;
+					driver.sendCommand(payload.getBuffer(), payload.getSize());
+					FAIL_IF(!pDriverCommand->CompletionQueueEntry.succeeded(), "Controller failed creating an io submission queue");
+					return true;
+				};
+
+				UINT_32 sectorSize = 512;
+
+				// Part 1: a real clock engine. A 20000us read model should make a read take at
+				//  least that long on the wall clock; an unmodeled opcode shouldn't be delayed.
+				{
+					cnvme::driver::Driver driver;
+					Payload payload(sizeof(cnvme::driver::DRIVER_COMMAND) + sectorSize);
+					FAIL_IF(!buildIoQueues(driver, payload), "Couldn't build the IO queues");
+
+					auto engine = std::make_shared<timing::TimingEngine>(timing::REAL_TIME);
+					RELEASE_ON_SCOPE_LOSS engineReleaser(engine);
+					timing::LATENCY_DISTRIBUTION readLatency = { timing::CONSTANT };
+					readLatency.MeanMicroseconds = 20000;
+					engine->setOpcodeLatency(false, constants::opcodes::nvm::READ, readLatency);
+					driver.setTimingEngine(engine);
+
+					auto pDriverCommand = (cnvme::driver::PDRIVER_COMMAND)payload.getBuffer();
+					memset(pDriverCommand, 0, sizeof(cnvme::driver::DRIVER_COMMAND));
+					pDriverCommand->QueueId = 1;
+					pDriverCommand->Timeout = 5;
+					pDriverCommand->TransferDataSize = sectorSize;
+					pDriverCommand->TransferDataDirection = cnvme::driver::READ;
+					pDriverCommand->Command.NSID = 1;
+					pDriverCommand->Command.DWord0Breakdown.OPC = constants::opcodes::nvm::READ;
+					pDriverCommand->Command.DW12_IO.NLB = ZERO_BASED_FROM_ONE_BASED(1);
+
+					auto readStart = std::chrono::steady_clock::now();
+					driver.sendCommand(payload.getBuffer(), payload.getSize());
+					UINT_64 readWallMicroseconds = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - readStart).count();
+					FAIL_IF(!pDriverCommand->CompletionQueueEntry.succeeded(), "The modeled read failed");
+					FAIL_IF(readWallMicroseconds < 20000, "The read completed in " + std::to_string(readWallMicroseconds) + "us, under its 20000us model");
+
+					// The write has no model, so it should beat the read's modeled floor easily
+					pDriverCommand->TransferDataDirection = cnvme::driver::WRITE;
+					pDriverCommand->Command.DWord0Breakdown.OPC = constants::opcodes::nvm::WRITE;
+					auto writeStart = std::chrono::steady_clock::now();
+					driver.sendCommand(payload.getBuffer(), payload.getSize());
+					UINT_64 writeWallMicroseconds = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - writeStart).count();
+					FAIL_IF(!pDriverCommand->CompletionQueueEntry.succeeded(), "The unmodeled write failed");
+					FAIL_IF(writeWallMicroseconds >= 20000, "The unmodeled write took " + std::to_string(writeWallMicroseconds) + "us; was it delayed?");
+				}
+
+				// Part 2: a virtual clock engine. The read's completion should stay parked until
+				//  the clock is advanced past its 80us due time, and no wall time gets burned.
+				{
+					cnvme::driver::Driver driver;
+					Payload payload(sizeof(cnvme::driver::DRIVER_COMMAND) + sectorSize);
+					FAIL_IF(!buildIoQueues(driver, payload), "Couldn't build the IO queues");
+
+					auto engine = std::make_shared<timing::TimingEngine>(timing::VIRTUAL);
+					RELEASE_ON_SCOPE_LOSS engineReleaser(engine);
+					timing::LATENCY_DISTRIBUTION readLatency = { timing::CONSTANT };
+					readLatency.MeanMicroseconds = 80;
+					engine->setOpcodeLatency(false, constants::opcodes::nvm::READ, readLatency);
+					driver.setTimingEngine(engine);
+
+					auto pDriverCommand = (cnvme::driver::PDRIVER_COMMAND)payload.getBuffer();
+					memset(pDriverCommand, 0, sizeof(cnvme::driver::DRIVER_COMMAND));
+					pDriverCommand->QueueId = 1;
+					pDriverCommand->Timeout = 5;
+					pDriverCommand->TransferDataSize = sectorSize;
+					pDriverCommand->TransferDataDirection = cnvme::driver::READ;
+					pDriverCommand->Command.NSID = 1;
+					pDriverCommand->Command.DWord0Breakdown.OPC = constants::opcodes::nvm::READ;
+					pDriverCommand->Command.DW12_IO.NLB = ZERO_BASED_FROM_ONE_BASED(1);
+
+					FAIL_IF(driver.submitCommand(payload.getBuffer(), payload.getSize()) == INVALID_COMMAND_HANDLE, "Failed to submit the modeled read");
+
+#ifndef SINGLE_THREADED
+					// The clock hasn't moved, so the completion should still be parked
+					FAIL_IF(driver.reapCompletions(1, 1) != 0, "A completion posted before the virtual clock reached its due time");
+#endif
+
+					engine->advanceVirtualClock(100);
+					FAIL_IF(engine->getTimeMicroseconds() != 100, "The virtual clock didn't land where it was advanced to");
+
+					FAIL_IF(driver.reapCompletions(1, 5) != 1, "The modeled read never completed after the virtual clock passed its due time");
+					FAIL_IF(pDriverCommand->DriverStatus != cnvme::driver::SENT_SUCCESSFULLY, "The modeled read's driver status was bad");
+					FAIL_IF(!pDriverCommand->CompletionQueueEntry.succeeded(), "The modeled read failed");
+				}
+
+				return true;
+			}
+
+			bool testSmartHealthLogPage()
+			{
+				cnvme::driver::Driver driver;
+
+				Payload payload(sizeof(cnvme::driver::DRIVER_COMMAND) + 512);
+				auto pDriverCommand = (cnvme::driver::PDRIVER_COMMAND)payload.getBuffer();
+				pDriverCommand->QueueId = ADMIN_QUEUE_ID;
+				pDriverCommand->Timeout = 5;
+				pDriverCommand->TransferDataDirection = cnvme::driver::NO_DATA;
+
+				// Create CQ/SQ 1 so we can put some NVM traffic on the counters
+				pDriverCommand->Command.DWord0Breakdown.OPC = constants::opcodes::admin::CREATE_IO_COMPLETION_QUEUE;
+				pDriverCommand->Command.DW10_CreateIoQueue.QSIZE = 0xF;
+				pDriverCommand->Command.DW10_CreateIoQueue.QID = 1;
+				pDriverCommand->Command.DW11_CreateIoCompletionQueue.IEN = 1;
+				pDriverCommand->Command.DW11_CreateIoCompletionQueue.PC = 1;
+				driver.sendCommand(payload.getBuffer(), payload.getSize());
+				FAIL_IF(!pDriverCommand->CompletionQueueEntry.succeeded(), "Controller failed creating an io completion queue");
+
+				pDriverCommand->Command.DW10_CreateIoQueue.QSIZE = 0xF;
+				pDriverCommand->Command.DW10_CreateIoQueue.QID = 1;
+				pDriverCommand->Command.DW11_CreateIoSubmissionQueue.PC = 1;
+				pDriverCommand->Command.DW11_CreateIoSubmissionQueue.CQID = 1;
+				pDriverCommand->Command.DWord0Breakdown.OPC = constants::opcodes::admin::CREATE_IO_SUBMISSION_QUEUE;
+				driver.sendCommand(payload.getBuffer(), payload.getSize());
+				FAIL_IF(!pDriverCommand->CompletionQueueEntry.succeeded(), "Controller failed creating an io submission queue");
+
+				// One write and one read so every SMART IO counter has something to show
+				memset(&pDriverCommand->Command, 0, sizeof(pDriverCommand->Command));
+				pDriverCommand->QueueId = 1;
+				pDriverCommand->TransferDataSize = 512;
+				pDriverCommand->TransferDataDirection = cnvme::driver::WRITE;
+				pDriverCommand->Command.NSID = 1;
+				pDriverCommand->Command.DWord0Breakdown.OPC = constants::opcodes::nvm::WRITE;
+				pDriverCommand->Command.DW12_IO.NLB = ZERO_BASED_FROM_ONE_BASED(1);
+				memset(&pDriverCommand->TransferData, 0xCD, 512);
+				driver.sendCommand(payload.getBuffer(), payload.getSize());
+				FAIL_IF(!pDriverCommand->CompletionQueueEntry.succeeded(), "Failed to write a sector for the SMART counters");
+
+				memset(&pDriverCommand->Command, 0, sizeof(pDriverCommand->Command));
+				pDriverCommand->QueueId = 1;
+				pDriverCommand->TransferDataSize = 512;
+				pDriverCommand->TransferDataDirection = cnvme::driver::READ;
+				pDriverCommand->Command.NSID = 1;
+				pDriverCommand->Command.DWord0Breakdown.OPC = constants::opcodes::nvm::READ;
+				pDriverCommand->Command.DW12_IO.NLB = ZERO_BASED_FROM_ONE_BASED(1);
+				driver.sendCommand(payload.getBuffer(), payload.getSize());
+				FAIL_IF(!pDriverCommand->CompletionQueueEntry.succeeded(), "Failed to read a sector for the SMART counters");
+
+				// Pull the SMART / Health Information log
+				UINT_32 LOG_SIZE = sizeof(cnvme::log_pages::SMART_HEALTH_INFO);
+				UINT_32 LOG_BUF_SIZE = sizeof(cnvme::driver::DRIVER_COMMAND) + LOG_SIZE;
+				Payload logCommandBuffer(LOG_BUF_SIZE);
+
+				auto pLogCommand = (cnvme::driver::PDRIVER_COMMAND)logCommandBuffer.getBuffer();
+				pLogCommand->QueueId = ADMIN_QUEUE_ID;
+				pLogCommand->Timeout = 5;
+				pLogCommand->TransferDataSize = LOG_SIZE;
+				pLogCommand->TransferDataDirection = cnvme::driver::READ;
+				pLogCommand->Command.DWord0Breakdown.OPC = cnvme::constants::opcodes::admin::GET_LOG_PAGE;
+				pLogCommand->Command.DW10_GetLogPage.LID = cnvme::constants::commands::log_page_ids::SMART_HEALTH_INFORMATION;
+				pLogCommand->Command.DW10_GetLogPage.NUMDL = (UINT_16)((LOG_SIZE / sizeof(UINT_32)) - 1); // NUMD is 0-based dwords
+
+				driver.sendCommand(logCommandBuffer.getBuffer(), LOG_BUF_SIZE);
+				FAIL_IF(pLogCommand->DriverStatus != cnvme::driver::SENT_SUCCESSFULLY, "Get Log Page did not send successfully");
+				FAIL_IF(pLogCommand->CompletionQueueEntry.SC != 0, "Get Log Page for the SMART log did not succeed");
+
+				auto pSmartInfo = (cnvme::log_pages::PSMART_HEALTH_INFO)pLogCommand->TransferData;
+				UINT_16 compositeTemperatureKelvin = 0;
+				memcpy_s(&compositeTemperatureKelvin, sizeof(compositeTemperatureKelvin), pSmartInfo->CompositeTemperature, sizeof(pSmartInfo->CompositeTemperature));
+
+				FAIL_IF(pSmartInfo->CriticalWarning != 0, "A healthy simulated drive should have no critical warnings");
+				FAIL_IF(compositeTemperatureKelvin < 273 || compositeTemperatureKelvin > 373, "Composite temperature should be a sane Kelvin value");
+				FAIL_IF(pSmartInfo->AvailableSpare != 100, "Available spare should be 100 percent");
+
+				auto readCounter = [](UINT_8* counterField) -> UINT_64
+				{
+					UINT_64 value = 0;
+					memcpy_s(&value, sizeof(value), counterField, sizeof(value));
+					return value;
+				};
+				FAIL_IF(readCounter(pSmartInfo->HostReadCommands) < 1, "The SMART log should have seen our read");
+				FAIL_IF(readCounter(pSmartInfo->HostWriteCommands) < 1, "The SMART log should have seen our write");
+				FAIL_IF(readCounter(pSmartInfo->DataUnitsRead) < 1, "Data units read should round up to at least 1");
+				FAIL_IF(readCounter(pSmartInfo->DataUnitsWritten) < 1, "Data units written should round up to at least 1");
+				FAIL_IF(readCounter(pSmartInfo->PowerCycles) != 1, "The simulated controller gets powered on exactly once");
+
+				return true;
+			}
+
+			bool testShadowDoorbellsViaDriver()
+			{
+				cnvme::driver::Driver driver;
+
+				UINT_32 BUF_SIZE = sizeof(cnvme::driver::DRIVER_COMMAND);
+				Payload p(BUF_SIZE);
+				BYTE* buffer = p.getBuffer();
+
+				auto pDriverCommand = (cnvme::driver::PDRIVER_COMMAND)buffer;
+				pDriverCommand->QueueId = ADMIN_QUEUE_ID;
+				pDriverCommand->Timeout = 5;
+				pDriverCommand->TransferDataDirection = cnvme::driver::NO_DATA;
+				pDriverCommand->Command.DWord0Breakdown.OPC = cnvme::constants::opcodes::admin::KEEP_ALIVE;
+
+				FAIL_IF(!driver.enableShadowDoorbells(), "Controller should accept Doorbell Buffer Config");
+
+				// Commands must still complete even though most rings now only touch the shadow slot
+				for (UINT_32 i = 0; i < 8; i++)
+				{
+					driver.sendCommand(buffer, BUF_SIZE);
+					FAIL_IF(pDriverCommand->DriverStatus != cnvme::driver::SENT_SUCCESSFULLY, "Command did not send successfully with shadow doorbells on");
+					FAIL_IF(pDriverCommand->CompletionQueueEntry.SC != 0, "Command failed with shadow doorbells on");
+				}
+
+				// A reset drops the controller's shadow buffers; the driver must fall back to real doorbells
+				FAIL_IF(!driver.controllerReset(), "Controller reset failed!");
+				driver.sendCommand(buffer, BUF_SIZE);
+				FAIL_IF(pDriverCommand->DriverStatus != cnvme::driver::SENT_SUCCESSFULLY, "Command did not send successfully after the reset");
+				FAIL_IF(pDriverCommand->CompletionQueueEntry.SC != 0, "Command failed after the reset");
+
+				// And Doorbell Buffer Config can simply be sent again
+				FAIL_IF(!driver.enableShadowDoorbells(), "Controller should accept Doorbell Buffer Config after a reset");
+				driver.sendCommand(buffer, BUF_SIZE);
+				FAIL_IF(pDriverCommand->DriverStatus != cnvme::driver::SENT_SUCCESSFULLY, "Command did not send successfully after re-enabling");
+				FAIL_IF(pDriverCommand->CompletionQueueEntry.SC != 0, "Command failed after re-enabling");
+
+				return true;
+			}
+
+			bool testVendorPerformanceLogPage()
+			{
+				cnvme::driver::Driver driver;
+				UINT_32 BUF_SIZE = sizeof(cnvme::driver::DRIVER_COMMAND);
+				Payload p(BUF_SIZE);
+				BYTE* buffer = p.getBuffer();
+
+				auto pDriverCommand = (cnvme::driver::PDRIVER_COMMAND)buffer;
+				pDriverCommand->QueueId = ADMIN_QUEUE_ID;
+				pDriverCommand->Timeout = 5; // arbitrary
+				pDriverCommand->TransferDataDirection = cnvme::driver::NO_DATA;
+				pDriverCommand->Command.DWord0Breakdown.OPC = cnvme::constants::opcodes::admin::KEEP_ALIVE;
+
+				// put some traffic on the admin queue so the counters have something to show
+				const UINT_32 KEEP_ALIVE_COUNT = 8;
+				for (UINT_32 i = 0; i < KEEP_ALIVE_COUNT; i++)
+				{
+					driver.sendCommand(buffer, BUF_SIZE);
+					FAIL_IF(pDriverCommand->DriverStatus != cnvme::driver::SENT_SUCCESSFULLY, "Keep Alive did not send successfully");
+				}
+
+				// only the admin queue exists, so the header plus a single entry covers everything
+				UINT_32 LOG_SIZE = sizeof(cnvme::log_pages::PERFORMANCE_LOG_HEADER) + sizeof(cnvme::log_pages::QUEUE_PERFORMANCE_STATS);
+				UINT_32 LOG_BUF_SIZE = sizeof(cnvme::driver::DRIVER_COMMAND) + LOG_SIZE;
+				Payload logCommandBuffer(LOG_BUF_SIZE);
+
+				auto pLogCommand = (cnvme::driver::PDRIVER_COMMAND)logCommandBuffer.getBuffer();
+				pLogCommand->QueueId = ADMIN_QUEUE_ID;
+				pLogCommand->Timeout = 5; // arbitrary
+				pLogCommand->TransferDataSize = LOG_SIZE;
+				pLogCommand->TransferDataDirection = cnvme::driver::READ;
+				pLogCommand->Command.DWord0Breakdown.OPC = cnvme::constants::opcodes::admin::GET_LOG_PAGE;
+				pLogCommand->Command.DW10_GetLogPage.LID = cnvme::constants::commands::log_page_ids::VENDOR_PERFORMANCE;
+				pLogCommand->Command.DW10_GetLogPage.NUMDL = (UINT_16)((LOG_SIZE / sizeof(UINT_32)) - 1); // NUMD is 0-based dwords
+
+				driver.sendCommand(logCommandBuffer.getBuffer(), LOG_BUF_SIZE);
+				FAIL_IF(pLogCommand->DriverStatus != cnvme::driver::SENT_SUCCESSFULLY, "Get Log Page did not send successfully");
+				FAIL_IF(pLogCommand->CompletionQueueEntry.SC != 0, "Get Log Page for the performance log did not succeed");
+
+				auto pHeader = (cnvme::log_pages::PPERFORMANCE_LOG_HEADER)pLogCommand->TransferData;
+				FAIL_IF(pHeader->QueueCount == 0, "Performance log should know about at least the admin queue");
+				FAIL_IF(pHeader->LatencyBucketCount != PERFORMANCE_LOG_LATENCY_BUCKETS, "Latency bucket count didn't match the build's bucket count");
+				FAIL_IF(pHeader->AdminOpcodeCounts[cnvme::constants::opcodes::admin::KEEP_ALIVE] < KEEP_ALIVE_COUNT, "Keep Alive opcode count was lower than the number sent");
+
+				auto pEntry = (cnvme::log_pages::PQUEUE_PERFORMANCE_STATS)(pLogCommand->TransferData + sizeof(cnvme::log_pages::PERFORMANCE_LOG_HEADER));
+				FAIL_IF(pEntry->SubmissionQueueId != ADMIN_QUEUE_ID, "First performance entry should be the admin queue");
+				FAIL_IF(pEntry->CommandsCompleted < KEEP_ALIVE_COUNT, "Admin queue completed count was lower than the number of commands sent");
+
+				UINT_64 histogramTotal = 0;
+				for (size_t i = 0; i < PERFORMANCE_LOG_LATENCY_BUCKETS; i++)
+				{
+					histogramTotal += pEntry->LatencyHistogram[i];
+				}
+				FAIL_IF(histogramTotal != pEntry->CommandsCompleted, "Every completed command should land in exactly one latency bucket");
+
+				return true;
+			}
+		}
+
+		namespace benchmark
+		{
+			bool testBenchmarkSmoke()
+			{
+				cnvme::benchmark::BENCHMARK_CONFIG config;
+				config.QueuePairCount = 1;
+				config.QueueDepth = 4;
+				config.WorkerThreadCount = 2;
+				config.DurationInSeconds = 1;
+
+				cnvme::benchmark::BENCHMARK_RESULTS results;
+				FAIL_IF(!cnvme::benchmark::runBenchmark(config, results), "Benchmark run did not complete cleanly");
+				FAIL_IF(results.CommandsCompleted == 0, "Benchmark should have completed at least one command");
+				FAIL_IF(results.CommandsFailed != 0, "No benchmark command should have failed");
+				FAIL_IF(results.IOPS <= 0, "A run with completions should report non-zero IOPS");
+				FAIL_IF(results.BandwidthMBps <= 0, "A run with completions should report non-zero bandwidth");
+				FAIL_IF(results.P50LatencyMicroseconds > results.P99LatencyMicroseconds, "p50 latency should not exceed p99");
+				FAIL_IF(results.P99LatencyMicroseconds > results.P999LatencyMicroseconds, "p99 latency should not exceed p999");
+				FAIL_IF(results.P999LatencyMicroseconds > results.MaxLatencyMicroseconds, "p999 latency should not exceed the max");
+
+				return true;
+			}
+		}
+
+		namespace trace
+		{
+			bool testTraceCaptureAndReplay()
+			{
+				// unique path since this test can run more than once at the same time
+				std::string traceFilePath = "cnvme_trace_test_" + std::to_string(std::chrono::steady_clock::now().time_since_epoch().count()) + ".bin";
+				UINT_64 tracedCommandCount = 3;
+
+				{
+					cnvme::driver::Driver driver;
+					driver.enableCommandTracing(traceFilePath, 256);
+
+					UINT_32 bufferSize = sizeof(cnvme::driver::DRIVER_COMMAND) + sizeof(identify::structures::IDENTIFY_CONTROLLER);
+					Payload buffer(bufferSize);
+					auto pCommand = (cnvme::driver::PDRIVER_COMMAND)buffer.getBuffer();
+
+					for (UINT_64 i = 0; i < tracedCommandCount; i++)
+					{
+						memset(&pCommand->Command, 0, sizeof(pCommand->Command));
+						pCommand->QueueId = ADMIN_QUEUE_ID;
+						pCommand->Timeout = 5;
+						pCommand->TransferDataDirection = cnvme::driver::READ;
+						pCommand->TransferDataSize = sizeof(identify::structures::IDENTIFY_CONTROLLER);
+						pCommand->Command.DWord0Breakdown.OPC = constants::opcodes::admin::IDENTIFY;
+						pCommand->Command.DW10_Identify.CNS = constants::commands::identify::cns::CONTROLLER;
+						driver.sendCommand(buffer.getBuffer(), buffer.getSize());
+						FAIL_IF(!pCommand->CompletionQueueEntry.succeeded(), "Traced identify command failed");
+					}
+
+					driver.disableCommandTracing(); // finalizes the trace file
+				}
+
+				tracing::REPLAY_CONFIG replayConfig;
+				replayConfig.TraceFilePath = traceFilePath;
+				replayConfig.TimeScale = 0; // as fast as possible
+
+				tracing::REPLAY_RESULTS replayResults;
+				FAIL_IF(!tracing::replayTrace(replayConfig, replayResults), "Replaying the captured trace did not run");
+				FAIL_IF(replayResults.CommandsReplayed != tracedCommandCount, "Replay should send exactly the traced commands");
+				FAIL_IF(replayResults.CommandsFailed != 0, "Replayed identify commands should succeed");
+
+				remove(traceFilePath.c_str());
+				return true;
+			}
+		}
+
+		namespace media
+		{
+			bool testFileBackedMediaPersistence()
+			{
+				UINT_64 mediaSize = 16384;
+
+				// unique path since this test can run more than once at the same time
+				std::string backingFilePath = "cnvme_media_test_" + std::to_string(std::chrono::steady_clock::now().time_since_epoch().count()) + ".bin";
+
+				Payload writtenData(4096);
+				helpers::randomizePayload(writtenData);
+
+				{
+					ns::SparseMedia media(mediaSize, backingFilePath);
+					FAIL_IF(!media.isFileBacked(), "Media with a backing file should say it is file backed");
+					media.write(4096, writtenData.getBuffer(), writtenData.getSize());
+				} // close the mapping
+
+				ns::SparseMedia reopenedMedia(mediaSize, backingFilePath);
+				Payload readData(4096);
+
+				reopenedMedia.read(4096, readData.getBuffer(), readData.getSize());
+				FAIL_IF(readData != writtenData, "Data did not persist across a close and reopen of the backing file");
+
+				reopenedMedia.read(8192, readData.getBuffer(), readData.getSize());
+				FAIL_IF(readData == writtenData, "An unwritten region somehow read back as the written data");
+
+				reopenedMedia.eraseAll();
+				reopenedMedia.read(4096, readData.getBuffer(), readData.getSize());
+				FAIL_IF(readData == writtenData, "Data was still there after erasing the media");
+
+				remove(backingFilePath.c_str());
+				return true;
+			}
+
+			bool testMediaDeduplication()
+			{
+				UINT_64 pageCount = 16;
+				ns::SparseMedia media(pageCount * SPARSE_MEDIA_PAGE_SIZE);
+				media.setDeduplicationEnabled(true);
+
+				Payload patternData(SPARSE_MEDIA_PAGE_SIZE);
+				helpers::randomizePayload(patternData);
+
+				// the same page contents written all over should land in one allocation
+				UINT_64 duplicateCount = 8;
+				for (UINT_64 pageIndex = 0; pageIndex < duplicateCount; pageIndex++)
+				{
+					media.write(pageIndex * SPARSE_MEDIA_PAGE_SIZE, patternData.getBuffer(), patternData.getSize());
+				}
+				FAIL_IF(media.getAllocatedPageCount() != duplicateCount, "Every written page should be in the page map");
+				FAIL_IF(media.getUniquePageAllocationCount() != 1, "Identical pages should share a single allocation");
+
+				Payload readData(SPARSE_MEDIA_PAGE_SIZE);
+				for (UINT_64 pageIndex = 0; pageIndex < duplicateCount; pageIndex++)
+				{
+					media.read(pageIndex * SPARSE_MEDIA_PAGE_SIZE, readData.getBuffer(), readData.getSize());
+					FAIL_IF(readData != patternData, "A deduplicated page read back the wrong data");
+				}
+
+				// a write to one shared page must not show up in the others
+				Payload divergedData(SPARSE_MEDIA_PAGE_SIZE);
+				helpers::randomizePayload(divergedData);
+				media.write(0, divergedData.getBuffer(), divergedData.getSize());
+
+				media.read(0, readData.getBuffer(), readData.getSize());
+				FAIL_IF(readData != divergedData, "The diverged page should read back its new data");
+				media.read(SPARSE_MEDIA_PAGE_SIZE, readData.getBuffer(), readData.getSize());
+				FAIL_IF(readData != patternData, "Writing one shared page changed another");
+				FAIL_IF(media.getUniquePageAllocationCount() != 2, "The diverged page should have its own allocation now");
+
+				// zeroing a page should drop its allocation entirely: absent pages read as zeros
+				Payload zeroData(SPARSE_MEDIA_PAGE_SIZE);
+				media.write(0, zeroData.getBuffer(), zeroData.getSize());
+				FAIL_IF(media.getAllocatedPageCount() != duplicateCount - 1, "A zeroed page should leave the page map");
+
+				media.read(0, readData.getBuffer(), readData.getSize());
+				FAIL_IF(readData != zeroData, "The zeroed page should read back as zeros");
+
+				// a partial write into a shared page copies it first, then the copy deduplicates on its own
+				media.write(SPARSE_MEDIA_PAGE_SIZE, divergedData.getBuffer(), 512);
+				media.read(SPARSE_MEDIA_PAGE_SIZE * 2, readData.getBuffer(), readData.getSize());
+				FAIL_IF(readData != patternData, "A partial write to one shared page changed another");
+
+				return true;
+			}
+
+			bool testNamespaceSnapshotAndClone()
+			{
+				UINT_32 memoryPageSize = 4096;
+				UINT_32 sectorSize = 512;
+				UINT_32 sectorCount = 32;
+
+				ns::Namespace testNamespace(sectorSize * sectorCount);
+
+				// Writes/reads the whole namespace through the command path
+				auto doIo = [&](ns::Namespace& targetNamespace, Payload& data, bool write) -> bool
+				{
+					PRP prp(data, memoryPageSize);
+
+					command::NVME_COMMAND nvmeCommand = { 0 };
+					nvmeCommand.SLBA = 0;
+					nvmeCommand.DW12_IO.NLB = ZERO_BASED_FROM_ONE_BASED(sectorCount);
+					nvmeCommand.DPTR.DPTR1 = prp.getPRP1();
+					nvmeCommand.DPTR.DPTR2 = prp.getPRP2();
+
+					auto completionQueueEntry = write ? targetNamespace.write(nvmeCommand, memoryPageSize) : targetNamespace.read(nvmeCommand, memoryPageSize);
+					FAIL_IF(completionQueueEntry.SC != 0, "Namespace IO failed");
+
+					if (!write)
+					{
+						data = prp.getPayloadCopy();
+					}
+					return true;
+				};
+
+				Payload originalData(sectorSize * sectorCount);
+				helpers::randomizePayload(originalData);
+				FAIL_IF(!doIo(testNamespace, originalData, true), "Failed to write the original data");
+
+				auto namespaceSnapshot = testNamespace.snapshot();
+
+				// A clone taken now should start from the same data without copying it up front
+				auto clonedNamespace = testNamespace.clone();
+
+				Payload overwriteData(sectorSize * sectorCount);
+				helpers::randomizePayload(overwriteData);
+				FAIL_IF(!doIo(testNamespace, overwriteData, true), "Failed to overwrite the original data");
+
+				Payload readData(sectorSize * sectorCount);
+				FAIL_IF(!doIo(testNamespace, readData, false), "Failed to read after the overwrite");
+				FAIL_IF(readData != overwriteData, "The overwrite should be visible before the restore");
+
+				// The clone must still see the pre-overwrite data (the pages were shared copy-on-write)
+				FAIL_IF(!doIo(clonedNamespace, readData, false), "Failed to read the clone");
+				FAIL_IF(readData != originalData, "The clone should not see writes made to the original");
+
+				// Writes to the clone must not leak back into the original
+				Payload cloneData(sectorSize * sectorCount);
+				helpers::randomizePayload(cloneData);
+				FAIL_IF(!doIo(clonedNamespace, cloneData, true), "Failed to write the clone");
+				FAIL_IF(!doIo(testNamespace, readData, false), "Failed to re-read the original");
+				FAIL_IF(readData != overwriteData, "Writes to the clone should not change the original");
+
+				// Restoring rewinds the original back to the snapshot
+				testNamespace.restore(namespaceSnapshot);
+				FAIL_IF(!doIo(testNamespace, readData, false), "Failed to read after the restore");
+				FAIL_IF(readData != originalData, "The restore should rewind to the snapshot's data");
+
+				return true;
+			}
+
+			bool testConcurrentNamespaceIO()
+			{
+				UINT_32 memoryPageSize = 4096;
+				UINT_32 sectorSize = 512;
+				UINT_32 sectorsPerStripe = 64;
+				size_t workerCount = 4;
+
+				ns::Namespace testNamespace(sectorSize * sectorsPerStripe * workerCount);
+
+				// Each worker hammers its own disjoint LBA stripe: write a random pattern,
+				//  read it back, compare. With the range locks, none of them should ever
+				//  see another worker's data (or torn data).
+				auto stripeWorker = [&](size_t workerIndex) -> bool
+				{
+					UINT_64 startingLba = workerIndex * sectorsPerStripe;
+
+					for (int iteration = 0; iteration < 8; iteration++)
+					{
+						Payload writtenData(sectorSize * sectorsPerStripe);
+						helpers::randomizePayload(writtenData);
+						PRP writePrp(writtenData, memoryPageSize);
+
+						command::NVME_COMMAND nvmeCommand = { 0 };
+						nvmeCommand.SLBA = startingLba;
+						nvmeCommand.DW12_IO.NLB = ZERO_BASED_FROM_ONE_BASED(sectorsPerStripe);
+						nvmeCommand.DPTR.DPTR1 = writePrp.getPRP1();
+						nvmeCommand.DPTR.DPTR2 = writePrp.getPRP2();
+
+						auto completionQueueEntry = testNamespace.write(nvmeCommand, memoryPageSize);
+						FAIL_IF(completionQueueEntry.SC != 0, "Write to the stripe failed");
+
+						Payload readData(writtenData.getSize());
+						PRP readPrp(readData, memoryPageSize);
+						nvmeCommand.DPTR.DPTR1 = readPrp.getPRP1();
+						nvmeCommand.DPTR.DPTR2 = readPrp.getPRP2();
+
+						completionQueueEntry = testNamespace.read(nvmeCommand, memoryPageSize);
+						FAIL_IF(completionQueueEntry.SC != 0, "Read from the stripe failed");
+
+						FAIL_IF(readPrp.getPayloadCopy() != writtenData, "A stripe read back different data than was written to it");
+					}
+
+					return true;
+				};
+
+				std::vector<std::future<bool>> workers;
+				for (size_t workerIndex = 0; workerIndex < workerCount; workerIndex++)
+				{
+					workers.push_back(std::async(std::launch::async, stripeWorker, workerIndex));
+				}
+
+				for (auto &worker : workers)
+				{
+					FAIL_IF(!worker.get(), "A stripe worker saw corrupted data");
+				}
+
+				return true;
+			}
 		}
 
 		namespace prp
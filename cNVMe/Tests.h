@@ -31,6 +31,7 @@ Tests.h - A header file for all unit testing
 #include "Driver.h"
 #include "Identify.h"
 #include "LoopingThread.h"
+#include "Media.h"
 #include "PCIe.h"
 #include "PRP.h"
 
@@ -96,6 +97,21 @@ namespace cnvme
 			bool testControllerReset();
 		}
 
+		namespace subsystem
+		{
+			/// <summary>
+			/// Tests that many controllers sharing one WatcherPool all come up, reset,
+			/// and tear down correctly.
+			/// </summary>
+			bool testMultiControllerSharedPool();
+
+			/// <summary>
+			/// Tests ControllerPool: a released controller comes back recycled (same
+			/// instance, fresh state) and still does a full enable handshake.
+			/// </summary>
+			bool testControllerPoolReuse();
+		}
+
 		namespace commands
 		{
 			/// <summary>
@@ -118,10 +134,20 @@ namespace cnvme
 			/// </summary>
 			bool testNVMeIo();
 
+			/// <summary>
+			/// Tests that IO works across multiple queues with per-queue worker threads enabled.
+			/// </summary>
+			bool testNVMeIoWithQueueWorkers();
+
 			/// <summary>
 			/// Tests that updating FW works correctly
 			/// </summary>
 			bool testNVMeFirmwareDownloadAndCommit();
+
+			/// <summary>
+			/// Tests that Format NVM executes in the background without blocking other commands
+			/// </summary>
+			bool testNVMeBackgroundFormat();
 		}
 
 		namespace driver
@@ -135,6 +161,83 @@ namespace cnvme
 			/// Tests sending read commands via the driver
 			/// <summary>
 			bool testReadCommandViaDriver();
+
+			/// <summary>
+			/// Tests submitting a batch of commands asynchronously and reaping their completions
+			/// <summary>
+			bool testAsyncCommandsViaDriver();
+
+			/// <summary>
+			/// Tests reading the vendor specific performance log page via the driver
+			/// <summary>
+			bool testVendorPerformanceLogPage();
+
+			/// <summary>
+			/// Tests that commands still complete with shadow doorbells (Doorbell Buffer Config) on
+			/// <summary>
+			bool testShadowDoorbellsViaDriver();
+
+			/// <summary>
+			/// Tests reading the SMART / Health Information log page via the driver
+			/// <summary>
+			bool testSmartHealthLogPage();
+
+			/// <summary>
+			/// Tests registered memory regions: IO moves through the registered buffer
+			/// with no driver-side copies, and a stale token is rejected.
+			/// </summary>
+			bool testRegisteredMemoryRegionIO();
+
+			/// <summary>
+			/// Tests the timing engine: a real clock engine really delays completions by the
+			/// opcode's modeled latency, and a virtual clock engine parks them until the
+			/// clock is advanced past their due time.
+			/// </summary>
+			bool testTimingEngineLatencyModel();
+		}
+
+		namespace benchmark
+		{
+			/// <summary>
+			/// Quick smoke run of the benchmark harness with a tiny workload
+			/// </summary>
+			bool testBenchmarkSmoke();
+		}
+
+		namespace trace
+		{
+			/// <summary>
+			/// Tests capturing commands to a binary trace file and replaying them
+			/// through a fresh Driver.
+			/// </summary>
+			bool testTraceCaptureAndReplay();
+		}
+
+		namespace media
+		{
+			/// <summary>
+			/// Tests that file backed media keeps its data across a close and reopen,
+			/// and that erasing it really drops the data.
+			/// </summary>
+			bool testFileBackedMediaPersistence();
+
+			/// <summary>
+			/// Tests that concurrent reads and writes to disjoint LBA ranges of one
+			/// namespace don't corrupt each other's data.
+			/// </summary>
+			bool testConcurrentNamespaceIO();
+
+			/// <summary>
+			/// Tests copy-on-write namespace snapshots: restore rewinds later writes and
+			/// a clone diverges from the original without copying shared pages up front.
+			/// </summary>
+			bool testNamespaceSnapshotAndClone();
+
+			/// <summary>
+			/// Tests page-level media deduplication: identical pages share one allocation,
+			/// zeroed pages are dropped, and writes to a shared page don't leak to its twins.
+			/// </summary>
+			bool testMediaDeduplication();
 		}
 
 		namespace prp
@@ -0,0 +1,153 @@
+/*
+###########################################################################################
+// cNVMe - An Open Source NVMe Device Simulation - MIT License
+// Copyright 2018 - Intel Corporation
+
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+// INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+// PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+// LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT
+// OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+// OTHER DEALINGS IN THE SOFTWARE.
+############################################################################################
+Timing.cpp - An implementation file for the simulated device timing engine
+*/
+
+#include "Logger.h"
+#include "Timing.h"
+
+namespace cnvme
+{
+	namespace timing
+	{
+		/// <summary>
+		/// Map key for an opcode: admin and NVM opcodes share numbers, so the admin bit goes up top
+		/// </summary>
+		/// <param name="adminCommand">true for admin opcodes</param>
+		/// <param name="opcode">The opcode</param>
+		/// <returns>Key for OpcodeToLatencyDistribution</returns>
+		static UINT_16 getOpcodeKey(bool adminCommand, UINT_8 opcode)
+		{
+			return (UINT_16)((adminCommand ? 0x100 : 0) | opcode);
+		}
+
+		TimingEngine::TimingEngine(CLOCK_MODE clockMode)
+		{
+			this->ClockMode = clockMode;
+			this->Released = false;
+			this->VirtualTimeMicroseconds = 0;
+			this->StartTime = std::chrono::steady_clock::now();
+			this->RandomEngine.seed(std::random_device()());
+		}
+
+		TimingEngine::~TimingEngine()
+		{
+			release();
+		}
+
+		void TimingEngine::setOpcodeLatency(bool adminCommand, UINT_8 opcode, const LATENCY_DISTRIBUTION& latencyDistribution)
+		{
+			std::lock_guard<std::mutex> engineLock(this->Mutex);
+			this->OpcodeToLatencyDistribution[getOpcodeKey(adminCommand, opcode)] = latencyDistribution;
+		}
+
+		UINT_64 TimingEngine::getTimeMicroseconds()
+		{
+			std::lock_guard<std::mutex> engineLock(this->Mutex);
+			if (this->ClockMode == VIRTUAL)
+			{
+				return this->VirtualTimeMicroseconds;
+			}
+			return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - this->StartTime).count();
+		}
+
+		void TimingEngine::advanceVirtualClock(UINT_64 microseconds)
+		{
+			ASSERT_IF(this->ClockMode != VIRTUAL, "advanceVirtualClock() only makes sense on a VIRTUAL clock engine");
+
+			{
+				std::lock_guard<std::mutex> engineLock(this->Mutex);
+				this->VirtualTimeMicroseconds += microseconds;
+			}
+			this->Condition.notify_all();
+		}
+
+		void TimingEngine::release()
+		{
+			{
+				std::lock_guard<std::mutex> engineLock(this->Mutex);
+				this->Released = true;
+			}
+			this->Condition.notify_all();
+		}
+
+		bool TimingEngine::delayBeforeCompletion(bool adminCommand, UINT_8 opcode, UINT_64& modeledLatencyMicroseconds)
+		{
+			modeledLatencyMicroseconds = 0;
+
+			std::unique_lock<std::mutex> engineLock(this->Mutex);
+
+			auto itr = this->OpcodeToLatencyDistribution.find(getOpcodeKey(adminCommand, opcode));
+			if (itr == this->OpcodeToLatencyDistribution.end() || this->Released)
+			{
+				return false; // no latency configured for this opcode (or the engine is done)
+			}
+
+			const LATENCY_DISTRIBUTION& latencyDistribution = itr->second;
+			if (latencyDistribution.Type == UNIFORM)
+			{
+				std::uniform_int_distribution<UINT_64> distribution(latencyDistribution.MinMicroseconds, latencyDistribution.MaxMicroseconds);
+				modeledLatencyMicroseconds = distribution(this->RandomEngine);
+			}
+			else if (latencyDistribution.Type == NORMAL)
+			{
+				std::normal_distribution<double> distribution((double)latencyDistribution.MeanMicroseconds, (double)latencyDistribution.StandardDeviationMicroseconds);
+				double sample = distribution(this->RandomEngine);
+				modeledLatencyMicroseconds = (sample > 0) ? (UINT_64)sample : 0;
+			}
+			else // CONSTANT
+			{
+				modeledLatencyMicroseconds = latencyDistribution.MeanMicroseconds;
+			}
+
+			if (this->ClockMode == VIRTUAL)
+			{
+#ifndef SINGLE_THREADED
+				// Park the completion until the harness moves the clock past its due time.
+				//  With one thread there is nobody left to move the clock, so the wait is
+				//  compiled out and only the modeled timestamps remain.
+				UINT_64 dueTimeMicroseconds = this->VirtualTimeMicroseconds + modeledLatencyMicroseconds;
+				this->Condition.wait(engineLock, [this, dueTimeMicroseconds]() {
+					return this->Released || this->VirtualTimeMicroseconds >= dueTimeMicroseconds;
+				});
+#endif
+				return true; // the caller should account the modeled latency, not the wall clock
+			}
+
+			// REAL_TIME: sleep off the bulk and spin out the remainder, since an OS sleep
+			//  alone is too coarse for double digit microsecond device models
+			engineLock.unlock();
+			auto deadline = std::chrono::steady_clock::now() + std::chrono::microseconds(modeledLatencyMicroseconds);
+			if (modeledLatencyMicroseconds > TIMING_SPIN_THRESHOLD_MICROSECONDS)
+			{
+				std::this_thread::sleep_for(std::chrono::microseconds(modeledLatencyMicroseconds - TIMING_SPIN_THRESHOLD_MICROSECONDS));
+			}
+			while (std::chrono::steady_clock::now() < deadline)
+			{
+				; // spin: the remainder is under the spin threshold
+			}
+
+			return false; // the measured latency already includes the delay
+		}
+	}
+}
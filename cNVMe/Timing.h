@@ -0,0 +1,178 @@
+/*
+###########################################################################################
+// cNVMe - An Open Source NVMe Device Simulation - MIT License
+// Copyright 2018 - Intel Corporation
+
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+// INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+// PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+// LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT
+// OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+// OTHER DEALINGS IN THE SOFTWARE.
+############################################################################################
+Timing.h - A header file for the simulated device timing engine
+*/
+
+#pragma once
+
+#include "Types.h"
+
+/// <summary>
+/// In real time mode, delays this long or shorter finish with a spin instead of a sleep
+/// (OS sleeps are far too coarse for double digit microsecond latencies)
+/// </summary>
+#define TIMING_SPIN_THRESHOLD_MICROSECONDS 200
+
+namespace cnvme
+{
+	namespace timing
+	{
+		/// <summary>
+		/// What drives the engine's notion of "now"
+		/// </summary>
+		enum CLOCK_MODE
+		{
+			REAL_TIME,	// the high resolution steady clock: modeled latencies are real waits
+			VIRTUAL		// a clock the harness advances manually: completions release as it moves
+		};
+
+		/// <summary>
+		/// Shapes a latency distribution can take
+		/// </summary>
+		enum LATENCY_DISTRIBUTION_TYPE
+		{
+			CONSTANT,	// always MeanMicroseconds
+			UNIFORM,	// uniform over [MinMicroseconds, MaxMicroseconds]
+			NORMAL		// normal around MeanMicroseconds with StandardDeviationMicroseconds (clamped at 0)
+		};
+
+		/// <summary>
+		/// A configurable per-opcode latency distribution. Only the fields the
+		/// Type calls for are looked at.
+		/// </summary>
+		typedef struct LATENCY_DISTRIBUTION
+		{
+			LATENCY_DISTRIBUTION_TYPE Type;			// Shape of the distribution
+			UINT_64 MeanMicroseconds;				// CONSTANT value / NORMAL mean
+			UINT_64 MinMicroseconds;				// UNIFORM lower bound
+			UINT_64 MaxMicroseconds;				// UNIFORM upper bound
+			UINT_64 StandardDeviationMicroseconds;	// NORMAL standard deviation
+		} LATENCY_DISTRIBUTION, *PLATENCY_DISTRIBUTION;
+
+		/// <summary>
+		/// Models device latency for a controller. Opcodes get configurable latency
+		/// distributions; the controller calls in right before posting each completion and
+		/// the engine holds the completion back until the modeled time has passed. In
+		/// REAL_TIME mode that is a high resolution wait on the servicing thread. In
+		/// VIRTUAL mode the completion releases when the harness advances the clock past
+		/// its due time, so a simulated hour of IO takes however long the harness takes
+		/// to advance an hour. Opcodes with no distribution configured are not delayed.
+		/// </summary>
+		class TimingEngine
+		{
+		public:
+			/// <summary>
+			/// Creates an engine with the given clock mode and no latencies configured
+			/// </summary>
+			/// <param name="clockMode">REAL_TIME or VIRTUAL</param>
+			TimingEngine(CLOCK_MODE clockMode);
+
+			/// <summary>
+			/// Destructor. Releases anything still waiting.
+			/// </summary>
+			~TimingEngine();
+
+			/// <summary>
+			/// Sets the latency distribution for an opcode. Replaces any earlier setting.
+			/// </summary>
+			/// <param name="adminCommand">true if the opcode is an admin opcode (they share numbers with NVM ones)</param>
+			/// <param name="opcode">The command opcode</param>
+			/// <param name="latencyDistribution">The distribution to sample that opcode's latency from</param>
+			void setOpcodeLatency(bool adminCommand, UINT_8 opcode, const LATENCY_DISTRIBUTION& latencyDistribution);
+
+			/// <summary>
+			/// The engine's current time in microseconds: time since construction in
+			/// REAL_TIME mode, the sum of advanceVirtualClock() calls in VIRTUAL mode
+			/// </summary>
+			/// <returns>Now, in microseconds</returns>
+			UINT_64 getTimeMicroseconds();
+
+			/// <summary>
+			/// Moves the virtual clock forward, releasing every completion that comes due.
+			/// Only valid in VIRTUAL mode.
+			/// </summary>
+			/// <param name="microseconds">How far to advance</param>
+			void advanceVirtualClock(UINT_64 microseconds);
+
+			/// <summary>
+			/// Releases every waiter and makes all further delays no-ops. Call before tearing
+			/// down a controller that might still have a completion parked on the virtual
+			/// clock, or that controller's thread will never come back.
+			/// </summary>
+			void release();
+
+			/// <summary>
+			/// Called by the controller right before a completion posts. Samples the opcode's
+			/// latency and blocks until it has passed (really in REAL_TIME mode, until the
+			/// harness advances the clock in VIRTUAL mode). No-op for unconfigured opcodes.
+			/// </summary>
+			/// <param name="adminCommand">true if the command was an admin command</param>
+			/// <param name="opcode">The command's opcode</param>
+			/// <param name="modeledLatencyMicroseconds">Gets the sampled latency</param>
+			/// <returns>true if the caller should account the modeled latency instead of the measured one (VIRTUAL mode)</returns>
+			bool delayBeforeCompletion(bool adminCommand, UINT_8 opcode, UINT_64& modeledLatencyMicroseconds);
+
+		private:
+
+			/// <summary>
+			/// The engine's clock mode (fixed at construction)
+			/// </summary>
+			CLOCK_MODE ClockMode;
+
+			/// <summary>
+			/// True once release() ran: waiters are gone and delays do nothing
+			/// </summary>
+			bool Released;
+
+			/// <summary>
+			/// The virtual clock's current time (VIRTUAL mode only)
+			/// </summary>
+			UINT_64 VirtualTimeMicroseconds;
+
+			/// <summary>
+			/// When the engine was built (REAL_TIME mode's epoch)
+			/// </summary>
+			std::chrono::steady_clock::time_point StartTime;
+
+			/// <summary>
+			/// Map from (admin, opcode) key to that opcode's latency distribution
+			/// </summary>
+			std::map<UINT_16, LATENCY_DISTRIBUTION> OpcodeToLatencyDistribution;
+
+			/// <summary>
+			/// Source for latency sampling (guarded by Mutex)
+			/// </summary>
+			std::mt19937_64 RandomEngine;
+
+			/// <summary>
+			/// Guards everything above
+			/// </summary>
+			std::mutex Mutex;
+
+			/// <summary>
+			/// Wakes virtual clock waiters on advance or release
+			/// </summary>
+			std::condition_variable Condition;
+		};
+	}
+}
@@ -0,0 +1,353 @@
+/*
+###########################################################################################
+// cNVMe - An Open Source NVMe Device Simulation - MIT License
+// Copyright 2018 - Intel Corporation
+
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+// INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+// PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+// LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT
+// OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+// OTHER DEALINGS IN THE SOFTWARE.
+############################################################################################
+Trace.cpp - An implementation file for the command trace capture and replay engine
+*/
+
+#ifdef _WIN32
+#include <Windows.h>
+#else // Linux
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif // _WIN32
+
+#include "Constants.h"
+#include "Driver.h"
+#include "Identify.h"
+#include "Trace.h"
+
+namespace cnvme
+{
+	namespace tracing
+	{
+		CommandTracer::CommandTracer(const std::string& traceFilePath, UINT_64 recordCapacity)
+		{
+			ASSERT_IF(recordCapacity == 0, "A trace needs room for at least one record");
+
+			this->RecordCapacity = recordCapacity;
+			this->NextRecordIndex = 0;
+			this->TraceStartTime = std::chrono::steady_clock::now();
+
+			UINT_64 fileSizeInBytes = sizeof(TRACE_FILE_HEADER) + (recordCapacity * sizeof(TRACE_RECORD));
+
+#ifdef _WIN32
+			HANDLE fileHandle = CreateFileA(traceFilePath.c_str(), GENERIC_READ | GENERIC_WRITE, 0, NULL, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+			ASSERT_IF(fileHandle == INVALID_HANDLE_VALUE, "Unable to create the trace file");
+
+			HANDLE mappingHandle = CreateFileMappingA(fileHandle, NULL, PAGE_READWRITE, (DWORD)(fileSizeInBytes >> 32), (DWORD)(fileSizeInBytes & 0xFFFFFFFF), NULL);
+			ASSERT_IF(mappingHandle == NULL, "Unable to create a file mapping for the trace file");
+
+			BYTE* mappedBuffer = (BYTE*)MapViewOfFile(mappingHandle, FILE_MAP_ALL_ACCESS, 0, 0, (SIZE_T)fileSizeInBytes);
+			ASSERT_IF(mappedBuffer == NULL, "Unable to map a view of the trace file");
+
+			this->FileMapping = std::shared_ptr<void>(mappedBuffer, [mappedBuffer, mappingHandle, fileHandle](void*)
+			{
+				UnmapViewOfFile(mappedBuffer);
+				CloseHandle(mappingHandle);
+				CloseHandle(fileHandle);
+			});
+#else // Linux
+			int fileDescriptor = open(traceFilePath.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+			ASSERT_IF(fileDescriptor < 0, "Unable to create the trace file");
+			ASSERT_IF(ftruncate(fileDescriptor, fileSizeInBytes) != 0, "Unable to size the trace file");
+
+			BYTE* mappedBuffer = (BYTE*)mmap(NULL, (size_t)fileSizeInBytes, PROT_READ | PROT_WRITE, MAP_SHARED, fileDescriptor, 0);
+			ASSERT_IF(mappedBuffer == MAP_FAILED, "Unable to memory map the trace file");
+
+			this->FileMapping = std::shared_ptr<void>(mappedBuffer, [mappedBuffer, fileSizeInBytes, fileDescriptor](void*)
+			{
+				munmap(mappedBuffer, (size_t)fileSizeInBytes);
+				close(fileDescriptor);
+			});
+#endif // _WIN32
+
+			this->Header = (PTRACE_FILE_HEADER)mappedBuffer;
+			this->Records = (PTRACE_RECORD)(mappedBuffer + sizeof(TRACE_FILE_HEADER));
+
+			memcpy_s(this->Header->Magic, sizeof(this->Header->Magic), TRACE_FILE_MAGIC, sizeof(this->Header->Magic));
+			this->Header->Version = TRACE_FILE_VERSION;
+			this->Header->RecordSizeInBytes = sizeof(TRACE_RECORD);
+			this->Header->RecordCapacity = recordCapacity;
+			this->Header->RecordsWritten = 0;
+		}
+
+		CommandTracer::~CommandTracer()
+		{
+			this->Header->RecordsWritten = this->NextRecordIndex.load();
+			this->FileMapping = nullptr; // unmaps (and flushes) the file
+		}
+
+		void CommandTracer::recordCommand(const command::NVME_COMMAND& nvmeCommand, const command::COMPLETION_QUEUE_ENTRY& completionQueueEntry,
+			UINT_16 submissionQueueId, std::chrono::steady_clock::time_point pickupTime, std::chrono::steady_clock::time_point completionTime)
+		{
+			UINT_64 recordIndex = this->NextRecordIndex.fetch_add(1, std::memory_order_relaxed);
+			PTRACE_RECORD record = &this->Records[recordIndex % this->RecordCapacity];
+
+			record->PickupTimeMicroseconds = std::chrono::duration_cast<std::chrono::microseconds>(pickupTime - this->TraceStartTime).count();
+			record->CompletionTimeMicroseconds = std::chrono::duration_cast<std::chrono::microseconds>(completionTime - this->TraceStartTime).count();
+			record->SubmissionQueueId = submissionQueueId;
+			record->Command = nvmeCommand;
+			record->CompletionQueueEntry = completionQueueEntry;
+		}
+
+		bool replayTrace(const REPLAY_CONFIG& config, REPLAY_RESULTS& results)
+		{
+			results = REPLAY_RESULTS();
+
+			// Pull the whole trace into memory up front: the file is a bounded ring and
+			//  we don't want file IO on the replay timeline.
+			std::ifstream traceFile(config.TraceFilePath, std::ios::binary | std::ios::ate);
+			if (!traceFile.is_open())
+			{
+				LOG_ERROR("Replay failed: couldn't open " + config.TraceFilePath);
+				return false;
+			}
+			size_t fileSize = (size_t)traceFile.tellg();
+			if (fileSize < sizeof(TRACE_FILE_HEADER))
+			{
+				LOG_ERROR("Replay failed: the trace file is smaller than a trace header");
+				return false;
+			}
+			Payload traceData(fileSize);
+			traceFile.seekg(0);
+			traceFile.read((char*)traceData.getBuffer(), fileSize);
+			traceFile.close();
+
+			auto header = (PTRACE_FILE_HEADER)traceData.getBuffer();
+			if (memcmp(header->Magic, TRACE_FILE_MAGIC, sizeof(header->Magic)) != 0)
+			{
+				LOG_ERROR("Replay failed: not a cNVMe trace file");
+				return false;
+			}
+			if (header->Version != TRACE_FILE_VERSION || header->RecordSizeInBytes != sizeof(TRACE_RECORD))
+			{
+				LOG_ERROR("Replay failed: the trace was captured with an incompatible cNVMe version");
+				return false;
+			}
+			if (fileSize < sizeof(TRACE_FILE_HEADER) + (header->RecordCapacity * sizeof(TRACE_RECORD)))
+			{
+				LOG_ERROR("Replay failed: the trace file is truncated");
+				return false;
+			}
+
+			// Order the ring oldest first. If it wrapped, the oldest record is right after
+			//  the write point.
+			auto rawRecords = (PTRACE_RECORD)(traceData.getBuffer() + sizeof(TRACE_FILE_HEADER));
+			UINT_64 recordCount = std::min(header->RecordsWritten, header->RecordCapacity);
+			std::vector<TRACE_RECORD> records;
+			records.reserve((size_t)recordCount);
+			UINT_64 oldestIndex = (header->RecordsWritten > header->RecordCapacity) ? (header->RecordsWritten % header->RecordCapacity) : 0;
+			for (UINT_64 i = 0; i < recordCount; i++)
+			{
+				records.push_back(rawRecords[(oldestIndex + i) % header->RecordCapacity]);
+			}
+
+			// Completions can post out of pickup order across queues; replay by pickup time
+			std::stable_sort(records.begin(), records.end(), [](const TRACE_RECORD& left, const TRACE_RECORD& right)
+			{
+				return left.PickupTimeMicroseconds < right.PickupTimeMicroseconds;
+			});
+
+			if (records.empty())
+			{
+				LOG_ERROR("Replay failed: the trace has no records");
+				return false;
+			}
+
+			cnvme::driver::Driver driver;
+			driver.setIoQueueWorkersEnabled(true);
+
+			// Ask the namespace how big it is and how big its sectors are, for fitting traced LBAs
+			UINT_32 setupBufferSize = sizeof(cnvme::driver::DRIVER_COMMAND) + sizeof(identify::structures::IDENTIFY_NAMESPACE);
+			Payload setupBuffer(setupBufferSize);
+			auto pSetupCommand = (cnvme::driver::PDRIVER_COMMAND)setupBuffer.getBuffer();
+
+			pSetupCommand->QueueId = ADMIN_QUEUE_ID;
+			pSetupCommand->Timeout = 5;
+			pSetupCommand->TransferDataDirection = cnvme::driver::READ;
+			pSetupCommand->TransferDataSize = sizeof(identify::structures::IDENTIFY_NAMESPACE);
+			pSetupCommand->Command.DWord0Breakdown.OPC = constants::opcodes::admin::IDENTIFY;
+			pSetupCommand->Command.DW10_Identify.CNS = constants::commands::identify::cns::NAMESPACE_ACTIVE;
+			pSetupCommand->Command.NSID = 1;
+			driver.sendCommand(setupBuffer.getBuffer(), setupBuffer.getSize());
+			if (!pSetupCommand->CompletionQueueEntry.succeeded())
+			{
+				LOG_ERROR("Replay setup failed: couldn't identify namespace 1");
+				return false;
+			}
+			auto pIdentifyNamespace = (identify::structures::PIDENTIFY_NAMESPACE)pSetupCommand->TransferData;
+			UINT_32 sectorSize = (UINT_32)std::pow(2, pIdentifyNamespace->LBAF[pIdentifyNamespace->FLBAS.CurrentLBAFormat].LBADS);
+			UINT_64 namespaceSectorCount = pIdentifyNamespace->NSZE;
+
+			// Create enough IO queue pairs to cover the queues the trace used
+			UINT_16 maxTracedQueueId = 0;
+			for (auto &record : records)
+			{
+				maxTracedQueueId = std::max(maxTracedQueueId, record.SubmissionQueueId);
+			}
+			UINT_16 ioQueueCount = std::min(maxTracedQueueId, (UINT_16)TRACE_REPLAY_MAX_QUEUE_PAIRS);
+			for (UINT_16 queueId = 1; queueId <= ioQueueCount; queueId++)
+			{
+				memset(&pSetupCommand->Command, 0, sizeof(pSetupCommand->Command));
+				pSetupCommand->QueueId = ADMIN_QUEUE_ID;
+				pSetupCommand->TransferDataDirection = cnvme::driver::NO_DATA;
+				pSetupCommand->TransferDataSize = 0;
+				pSetupCommand->Command.DWord0Breakdown.OPC = constants::opcodes::admin::CREATE_IO_COMPLETION_QUEUE;
+				pSetupCommand->Command.DW10_CreateIoQueue.QSIZE = 255; // 0-based
+				pSetupCommand->Command.DW10_CreateIoQueue.QID = queueId;
+				pSetupCommand->Command.DW11_CreateIoCompletionQueue.IEN = 1;
+				pSetupCommand->Command.DW11_CreateIoCompletionQueue.PC = 1;
+				driver.sendCommand(setupBuffer.getBuffer(), setupBuffer.getSize());
+				if (!pSetupCommand->CompletionQueueEntry.succeeded())
+				{
+					LOG_ERROR("Replay setup failed: couldn't create completion queue " + std::to_string(queueId));
+					return false;
+				}
+
+				memset(&pSetupCommand->Command, 0, sizeof(pSetupCommand->Command));
+				pSetupCommand->Command.DWord0Breakdown.OPC = constants::opcodes::admin::CREATE_IO_SUBMISSION_QUEUE;
+				pSetupCommand->Command.DW10_CreateIoQueue.QSIZE = 255;
+				pSetupCommand->Command.DW10_CreateIoQueue.QID = queueId;
+				pSetupCommand->Command.DW11_CreateIoSubmissionQueue.PC = 1;
+				pSetupCommand->Command.DW11_CreateIoSubmissionQueue.CQID = queueId;
+				driver.sendCommand(setupBuffer.getBuffer(), setupBuffer.getSize());
+				if (!pSetupCommand->CompletionQueueEntry.succeeded())
+				{
+					LOG_ERROR("Replay setup failed: couldn't create submission queue " + std::to_string(queueId));
+					return false;
+				}
+			}
+
+			UINT_64 firstPickupMicroseconds = records[0].PickupTimeMicroseconds;
+			auto replayStartTime = std::chrono::steady_clock::now();
+
+			for (auto &record : records)
+			{
+				bool adminCommand = (record.SubmissionQueueId == ADMIN_QUEUE_ID);
+				UINT_8 opcode = record.Command.DWord0Breakdown.OPC;
+
+				// queue management is the replay's own business, skip the trace's
+				if (adminCommand && (opcode == constants::opcodes::admin::CREATE_IO_SUBMISSION_QUEUE || opcode == constants::opcodes::admin::CREATE_IO_COMPLETION_QUEUE ||
+					opcode == constants::opcodes::admin::DELETE_IO_SUBMISSION_QUEUE || opcode == constants::opcodes::admin::DELETE_IO_COMPLETION_QUEUE))
+				{
+					results.CommandsSkipped++;
+					continue;
+				}
+
+				UINT_64 transferSize = record.Command.getTransferSizeBytes(adminCommand, sectorSize);
+
+				// figure the data direction from the opcode. Unknown opcodes replay without data;
+				//  the controller's status for them is part of the recorded behavior.
+				cnvme::driver::DataDirection transferDirection = cnvme::driver::NO_DATA;
+				if (transferSize != 0)
+				{
+					if (adminCommand)
+					{
+						if (opcode == constants::opcodes::admin::IDENTIFY || opcode == constants::opcodes::admin::GET_LOG_PAGE)
+						{
+							transferDirection = cnvme::driver::READ;
+						}
+						else if (opcode == constants::opcodes::admin::FIRMWARE_IMAGE_DOWNLOAD)
+						{
+							transferDirection = cnvme::driver::WRITE;
+						}
+						else
+						{
+							transferSize = 0;
+						}
+					}
+					else
+					{
+						if (opcode == constants::opcodes::nvm::READ)
+						{
+							transferDirection = cnvme::driver::READ;
+						}
+						else if (opcode == constants::opcodes::nvm::WRITE)
+						{
+							transferDirection = cnvme::driver::WRITE;
+						}
+						else
+						{
+							transferSize = 0;
+						}
+					}
+				}
+
+				// wrap IO onto the replay namespace, which may be smaller than the traced one
+				UINT_64 startingLba = record.Command.SLBA;
+				if (!adminCommand && transferSize != 0)
+				{
+					UINT_64 sectorsThisCommand = ONE_BASED_FROM_ZERO_BASED(record.Command.DW12_IO.NLB);
+					if (sectorsThisCommand > namespaceSectorCount)
+					{
+						results.CommandsSkipped++;
+						continue;
+					}
+					startingLba = startingLba % (namespaceSectorCount - sectorsThisCommand + 1);
+				}
+
+				// hold to the recorded (scaled) timeline
+				if (config.TimeScale > 0)
+				{
+					auto targetOffset = std::chrono::microseconds((UINT_64)((record.PickupTimeMicroseconds - firstPickupMicroseconds) / config.TimeScale));
+					std::this_thread::sleep_until(replayStartTime + targetOffset);
+				}
+
+				Payload commandBuffer(sizeof(cnvme::driver::DRIVER_COMMAND) + (size_t)transferSize);
+				auto pReplayCommand = (cnvme::driver::PDRIVER_COMMAND)commandBuffer.getBuffer();
+				pReplayCommand->QueueId = adminCommand ? ADMIN_QUEUE_ID : (((record.SubmissionQueueId - 1) % ioQueueCount) + 1);
+				pReplayCommand->Timeout = 60;
+				pReplayCommand->TransferDataDirection = transferDirection;
+				pReplayCommand->TransferDataSize = (UINT_32)transferSize;
+				pReplayCommand->Command = record.Command;
+				pReplayCommand->Command.SLBA = startingLba;
+
+				driver.sendCommand(commandBuffer.getBuffer(), commandBuffer.getSize());
+
+				results.CommandsReplayed++;
+				if (pReplayCommand->DriverStatus != cnvme::driver::SENT_SUCCESSFULLY || !pReplayCommand->CompletionQueueEntry.succeeded())
+				{
+					results.CommandsFailed++;
+				}
+			}
+
+			results.ElapsedMicroseconds = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - replayStartTime).count();
+			if (results.ElapsedMicroseconds > 0)
+			{
+				results.CommandsPerSecond = (double)results.CommandsReplayed / ((double)results.ElapsedMicroseconds / 1000000.0);
+			}
+
+			return true;
+		}
+
+		void printReplayReport(const REPLAY_CONFIG& config, const REPLAY_RESULTS& results)
+		{
+			printf("cNVMe trace replay: %s (timescale=%g)\n", config.TraceFilePath.c_str(), config.TimeScale);
+			printf("  replayed : %llu commands (%llu failed, %llu skipped)\n",
+				(unsigned long long)results.CommandsReplayed, (unsigned long long)results.CommandsFailed, (unsigned long long)results.CommandsSkipped);
+			printf("  elapsed  : %.3f seconds\n", (double)results.ElapsedMicroseconds / 1000000.0);
+			printf("  rate     : %.0f commands/second\n", results.CommandsPerSecond);
+		}
+	}
+}
@@ -0,0 +1,195 @@
+/*
+###########################################################################################
+// cNVMe - An Open Source NVMe Device Simulation - MIT License
+// Copyright 2018 - Intel Corporation
+
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+// INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+// PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+// LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT
+// OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+// OTHER DEALINGS IN THE SOFTWARE.
+############################################################################################
+Trace.h - A header file for the command trace capture and replay engine
+*/
+
+#pragma once
+
+#include "Command.h"
+#include "Types.h"
+
+/// <summary>
+/// First 8 bytes of every trace file
+/// </summary>
+#define TRACE_FILE_MAGIC "cNVMeTrc"
+
+/// <summary>
+/// Bump when the header or record layout changes
+/// </summary>
+#define TRACE_FILE_VERSION 1
+
+/// <summary>
+/// Most IO queue pairs a replay will create, however many the trace used
+/// </summary>
+#define TRACE_REPLAY_MAX_QUEUE_PAIRS 8
+
+namespace cnvme
+{
+	namespace tracing
+	{
+		/// <summary>
+		/// On-disk header at the start of a trace file
+		/// </summary>
+		typedef struct TRACE_FILE_HEADER
+		{
+			UINT_8 Magic[8];			// TRACE_FILE_MAGIC
+			UINT_32 Version;			// TRACE_FILE_VERSION
+			UINT_32 RecordSizeInBytes;	// sizeof(TRACE_RECORD) when captured
+			UINT_64 RecordCapacity;		// Ring capacity in records
+			UINT_64 RecordsWritten;		// Total records ever appended. Can exceed RecordCapacity once the ring wraps. Finalized when tracing stops.
+			UINT_8 Reserved[32];		// Pad to 64 bytes
+		} TRACE_FILE_HEADER, *PTRACE_FILE_HEADER;
+		static_assert(sizeof(TRACE_FILE_HEADER) == 64, "TRACE_FILE_HEADER should be 64 bytes");
+
+		/// <summary>
+		/// One traced command: the raw 64-byte NVMe command, its completion, where it ran and when
+		/// </summary>
+		typedef struct TRACE_RECORD
+		{
+			UINT_64 PickupTimeMicroseconds;		// When the controller picked the command up, relative to trace start
+			UINT_64 CompletionTimeMicroseconds;	// When its completion posted, relative to trace start
+			UINT_16 SubmissionQueueId;			// Queue the command arrived on (0 is the admin queue)
+			UINT_8 Reserved[6];					// Keeps the command 8-byte aligned
+			command::NVME_COMMAND Command;						// The raw submission queue entry
+			command::COMPLETION_QUEUE_ENTRY CompletionQueueEntry;	// The raw completion queue entry
+		} TRACE_RECORD, *PTRACE_RECORD;
+		static_assert(sizeof(TRACE_RECORD) == 104, "TRACE_RECORD should be 104 bytes");
+
+		/// <summary>
+		/// CommandTracer appends TRACE_RECORDs to a memory-mapped ring file. Recording a
+		/// command is an index fetch-add and a memcpy into the mapping, so it is cheap
+		/// enough to leave on while measuring. The header's RecordsWritten is finalized
+		/// by the destructor, so stop tracing before reading the file back.
+		/// </summary>
+		class CommandTracer
+		{
+		public:
+			/// <summary>
+			/// Creates (truncating if needed) and maps the trace file
+			/// </summary>
+			/// <param name="traceFilePath">File to write the trace into</param>
+			/// <param name="recordCapacity">Ring capacity in records. Older records get overwritten once full.</param>
+			CommandTracer(const std::string& traceFilePath, UINT_64 recordCapacity);
+
+			/// <summary>
+			/// Destructor. Finalizes the header and unmaps the file.
+			/// </summary>
+			~CommandTracer();
+
+			/// <summary>
+			/// Appends one record to the ring. Safe to call from multiple threads.
+			/// </summary>
+			/// <param name="nvmeCommand">The command as it was picked up</param>
+			/// <param name="completionQueueEntry">The completion that got posted for it</param>
+			/// <param name="submissionQueueId">Queue the command arrived on</param>
+			/// <param name="pickupTime">When the controller picked the command up</param>
+			/// <param name="completionTime">When its completion posted</param>
+			void recordCommand(const command::NVME_COMMAND& nvmeCommand, const command::COMPLETION_QUEUE_ENTRY& completionQueueEntry,
+				UINT_16 submissionQueueId, std::chrono::steady_clock::time_point pickupTime, std::chrono::steady_clock::time_point completionTime);
+
+		private:
+
+			/// <summary>
+			/// The mapped header (start of the mapping)
+			/// </summary>
+			PTRACE_FILE_HEADER Header;
+
+			/// <summary>
+			/// The mapped ring (right after the header)
+			/// </summary>
+			PTRACE_RECORD Records;
+
+			/// <summary>
+			/// Ring capacity in records
+			/// </summary>
+			UINT_64 RecordCapacity;
+
+			/// <summary>
+			/// Next ring index to write. Monotonically increasing; slot is modulo RecordCapacity.
+			/// </summary>
+			std::atomic<UINT_64> NextRecordIndex;
+
+			/// <summary>
+			/// All record timestamps are relative to this
+			/// </summary>
+			std::chrono::steady_clock::time_point TraceStartTime;
+
+			/// <summary>
+			/// Keeps the file mapping alive. The deleter unmaps and closes.
+			/// </summary>
+			std::shared_ptr<void> FileMapping;
+		};
+
+		/// <summary>
+		/// Knobs for a trace replay
+		/// </summary>
+		typedef struct REPLAY_CONFIG
+		{
+			std::string TraceFilePath;	// The trace to replay
+			double TimeScale;			// 1.0 replays at recorded timing, 2.0 at double speed, 0 as fast as possible
+
+			REPLAY_CONFIG()
+			{
+				TimeScale = 0;
+			}
+		} REPLAY_CONFIG, *PREPLAY_CONFIG;
+
+		/// <summary>
+		/// What a replay did
+		/// </summary>
+		typedef struct REPLAY_RESULTS
+		{
+			UINT_64 CommandsReplayed;		// Commands sent back through the Driver
+			UINT_64 CommandsSkipped;		// Records that cannot be replayed (queue management, doesn't fit the namespace)
+			UINT_64 CommandsFailed;			// Replayed commands that completed with a non-success status
+			UINT_64 ElapsedMicroseconds;	// Wall time for the replay phase
+			double CommandsPerSecond;		// CommandsReplayed over the elapsed time
+
+			REPLAY_RESULTS()
+			{
+				CommandsReplayed = 0;
+				CommandsSkipped = 0;
+				CommandsFailed = 0;
+				ElapsedMicroseconds = 0;
+				CommandsPerSecond = 0;
+			}
+		} REPLAY_RESULTS, *PREPLAY_RESULTS;
+
+		/// <summary>
+		/// Brings up a fresh Driver and feeds a captured trace back through it in recorded
+		/// order. Queue management commands are skipped (the replay creates its own queues)
+		/// and IO gets its LBAs wrapped to fit the replay namespace.
+		/// </summary>
+		/// <param name="config">What to replay and how fast</param>
+		/// <param name="results">Filled out with what the replay did</param>
+		/// <returns>true if the trace loaded and the replay ran</returns>
+		bool replayTrace(const REPLAY_CONFIG& config, REPLAY_RESULTS& results);
+
+		/// <summary>
+		/// Prints a report of a replay to stdout
+		/// </summary>
+		/// <param name="config">The replay that ran</param>
+		/// <param name="results">What it did</param>
+		void printReplayReport(const REPLAY_CONFIG& config, const REPLAY_RESULTS& results);
+	}
+}
@@ -39,6 +39,7 @@ Types.h - A header file for all needed type includes
 #include <cmath>
 #include <cstddef>
 #include <cstdint>
+#include <deque>
 #include <exception>
 #include <fstream>
 #include <functional>
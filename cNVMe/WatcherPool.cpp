@@ -0,0 +1,149 @@
+/*
+###########################################################################################
+// cNVMe - An Open Source NVMe Device Simulation - MIT License
+// Copyright 2018 - Intel Corporation
+
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+// INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+// PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+// LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT
+// OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+// OTHER DEALINGS IN THE SOFTWARE.
+############################################################################################
+WatcherPool.cpp - An implementation file for the WatcherPool class
+*/
+
+#include "WatcherPool.h"
+
+namespace cnvme
+{
+	WatcherPool::WatcherPool() : WatcherPool(0)
+	{
+	}
+
+	WatcherPool::WatcherPool(size_t threadCount)
+	{
+		if (threadCount == 0)
+		{
+			threadCount = std::max((size_t)1, (size_t)std::thread::hardware_concurrency());
+		}
+
+		this->ContinueLoop = true;
+		for (size_t i = 0; i < threadCount; i++)
+		{
+			POOL_WORKER* worker = new POOL_WORKER();
+			worker->WakeRequested = false;
+			worker->Thread = std::thread(&WatcherPool::workerLoop, this, worker);
+			this->Workers.push_back(worker);
+		}
+	}
+
+	WatcherPool::~WatcherPool()
+	{
+		this->ContinueLoop = false;
+		this->wake();
+
+		for (POOL_WORKER* worker : this->Workers)
+		{
+			worker->Thread.join();
+			ASSERT_IF(!worker->Tasks.empty(), "A WatcherPool was destroyed while tasks were still registered. End the tasks first.");
+			delete worker;
+		}
+		this->Workers.clear();
+	}
+
+	void WatcherPool::add(LoopingThread* task)
+	{
+		std::lock_guard<std::mutex> membershipLock(this->MembershipMutex);
+
+		// place on the worker with the fewest tasks. Only add()/remove() change the
+		//  lists' sizes and both hold MembershipMutex, so reading sizes here is safe.
+		POOL_WORKER* leastLoadedWorker = this->Workers[0];
+		for (POOL_WORKER* worker : this->Workers)
+		{
+			if (worker->Tasks.size() < leastLoadedWorker->Tasks.size())
+			{
+				leastLoadedWorker = worker;
+			}
+		}
+
+		{
+			std::lock_guard<std::mutex> workerLock(leastLoadedWorker->Mutex);
+			leastLoadedWorker->Tasks.push_back(task);
+			leastLoadedWorker->WakeRequested = true;
+		}
+		leastLoadedWorker->WakeCondition.notify_all();
+	}
+
+	void WatcherPool::remove(LoopingThread* task)
+	{
+		std::lock_guard<std::mutex> membershipLock(this->MembershipMutex);
+
+		for (POOL_WORKER* worker : this->Workers)
+		{
+			// taking the worker's mutex means the worker is between passes, so the task
+			//  cannot be mid-iteration once we have the lock.
+			std::lock_guard<std::mutex> workerLock(worker->Mutex);
+			for (auto itr = worker->Tasks.begin(); itr != worker->Tasks.end(); itr++)
+			{
+				if (*itr == task)
+				{
+					worker->Tasks.erase(itr);
+					return;
+				}
+			}
+		}
+
+		ASSERT("Tried to remove a task that was not in the pool");
+	}
+
+	void WatcherPool::wake()
+	{
+		for (POOL_WORKER* worker : this->Workers)
+		{
+			{
+				std::lock_guard<std::mutex> workerLock(worker->Mutex);
+				worker->WakeRequested = true;
+			}
+			worker->WakeCondition.notify_all();
+		}
+	}
+
+	size_t WatcherPool::getThreadCount()
+	{
+		return this->Workers.size();
+	}
+
+	void WatcherPool::workerLoop(POOL_WORKER* worker)
+	{
+		std::unique_lock<std::mutex> workerLock(worker->Mutex);
+
+		while (this->ContinueLoop)
+		{
+			UINT_64 sleepDuration = WATCHER_POOL_DEFAULT_SLEEP_MS;
+			for (LoopingThread* task : worker->Tasks)
+			{
+				task->runPooledIteration();
+				sleepDuration = std::min(sleepDuration, task->SleepDuration);
+			}
+
+			// Sleep till either the sleep duration passes or someone calls wake().
+			//  The wait releases the mutex, which is when add()/remove() get in.
+			if (!worker->WakeRequested)
+			{
+				worker->WakeCondition.wait_for(workerLock, std::chrono::milliseconds(sleepDuration));
+			}
+			worker->WakeRequested = false;
+		}
+	}
+}
@@ -0,0 +1,125 @@
+/*
+###########################################################################################
+// cNVMe - An Open Source NVMe Device Simulation - MIT License
+// Copyright 2018 - Intel Corporation
+
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+// INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+// PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+// LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT
+// OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+// OTHER DEALINGS IN THE SOFTWARE.
+############################################################################################
+WatcherPool.h - A header file for the WatcherPool class
+*/
+
+#pragma once
+
+#include "LoopingThread.h"
+#include "Types.h"
+
+/// <summary>
+/// What a pool worker sleeps between passes when none of its tasks say otherwise (ms)
+/// </summary>
+#define WATCHER_POOL_DEFAULT_SLEEP_MS 1
+
+namespace cnvme
+{
+	/// <summary>
+	/// WatcherPool runs many LoopingThreads' iterations on a fixed set of worker
+	/// threads instead of giving each LoopingThread its own std::thread. With many
+	/// controllers in one process each spawns several 1ms pollers, and dedicated
+	/// threads stop scaling; the pool keeps thread count O(cores) rather than
+	/// O(controllers). Tasks keep their full LoopingThread semantics (waitForFlip,
+	/// wakeUp, start/end) via LoopingThread::setPool().
+	/// </summary>
+	class WatcherPool
+	{
+	public:
+		/// <summary>
+		/// Constructor. Sizes the pool to the number of hardware threads.
+		/// </summary>
+		WatcherPool();
+
+		/// <summary>
+		/// Constructor with an explicit worker thread count
+		/// </summary>
+		/// <param name="threadCount">Number of worker threads (0 means size to the machine)</param>
+		WatcherPool(size_t threadCount);
+
+		/// <summary>
+		/// Destructor. Stops all worker threads. All tasks should have been removed
+		/// (via LoopingThread::end()) before this runs.
+		/// </summary>
+		~WatcherPool();
+
+		/// <summary>
+		/// Adds a task to the least loaded worker. Called by LoopingThread::start().
+		/// </summary>
+		/// <param name="task">The task to start iterating</param>
+		void add(LoopingThread* task);
+
+		/// <summary>
+		/// Removes a task. Blocks until no worker is mid-iteration on it, so once this
+		/// returns the task's function will never be called again. Called by LoopingThread::end().
+		/// </summary>
+		/// <param name="task">The task to remove</param>
+		void remove(LoopingThread* task);
+
+		/// <summary>
+		/// Wakes every worker to run a pass right away instead of waiting out the sleep
+		/// </summary>
+		void wake();
+
+		/// <summary>
+		/// Gets the number of worker threads in the pool
+		/// </summary>
+		/// <returns>Worker thread count</returns>
+		size_t getThreadCount();
+
+	private:
+
+		/// <summary>
+		/// One worker thread and the tasks assigned to it
+		/// </summary>
+		typedef struct POOL_WORKER
+		{
+			std::thread Thread;						// The worker thread
+			std::list<LoopingThread*> Tasks;		// Tasks this worker iterates (guarded by Mutex)
+			std::mutex Mutex;						// Held by the worker across each pass, so remove() can't race an iteration
+			std::condition_variable WakeCondition;	// Cuts the sleep between passes short
+			bool WakeRequested;						// Set via wake() (guarded by Mutex)
+		} POOL_WORKER;
+
+		/// <summary>
+		/// The function each worker thread runs
+		/// </summary>
+		/// <param name="worker">This thread's worker state</param>
+		void workerLoop(POOL_WORKER* worker);
+
+		/// <summary>
+		/// The workers. Sized once in the constructor and never resized.
+		/// </summary>
+		std::vector<POOL_WORKER*> Workers;
+
+		/// <summary>
+		/// Serializes add()/remove() so task placement doesn't race itself
+		/// </summary>
+		std::mutex MembershipMutex;
+
+		/// <summary>
+		/// bool to say if the workers should keep looping or not
+		/// </summary>
+		std::atomic<bool> ContinueLoop;
+	};
+}
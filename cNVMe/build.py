@@ -32,7 +32,7 @@ def build(bitness, configType, outputType):
     if outputType not in VALID_OUTPUT_TYPE:
         raise ValueError("Invalid output type.")
     elif outputType == 'DLL':
-        gppArgs += '-DDLL_BUILD -shared '
+        gppArgs += '-DDLL_BUILD -shared -ldl ' # -ldl for the dladdr() self-location in System.cpp
         ext = 'so'
     else:
         ext = 'out'